@@ -0,0 +1,252 @@
+#pragma once
+
+#include "../src/game/Game.h"
+#include "../src/util/Json.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Small benchmark harness shared by the bench programs
+// A micro benchmark times a function doing ops operations: the number of calls
+// per sample is calibrated so a sample takes at least min_sample_ms, warm-up
+// samples are dropped, and every kept sample is reported in ns per operation.
+// A macro benchmark times whole runs (one solve per sample) in ms. Results
+// print as a table and go to a JSON file with one benchmark per line, so two
+// files diff line by line and compare() can match them up by name.
+class Bench{
+    public:
+        struct Result{
+            std::string name;
+            std::string unit;           // "ns" per operation or "ms" per run
+            long long batch;            // Operations per sample
+            std::vector<double> samples;
+            double median, p10, p90, p99, min, mean;
+            std::string status;         // Macro runs: Agent::status_name
+            std::map<std::string, double> counters;
+            Result():batch(1), median(0), p10(0), p90(0), p99(0), min(0), mean(0), status("ok"){}
+        };
+        // Value a macro run reports back
+        struct Run{
+            std::string status;
+            std::map<std::string, double> counters;
+            bool repeat;                // false: do not time this run again (budget ran out)
+            Run():status("ok"), repeat(true){}
+        };
+    private:
+        int _warmup, _reps;
+        double _min_sample_ms;
+        std::string _filter;
+        std::vector<Result> _results;
+        typedef std::chrono::steady_clock clock;
+
+        static double elapsed_ms(clock::time_point t0){
+            return std::chrono::duration<double, std::milli>(clock::now() - t0).count();
+        }
+        // Linear interpolation between closest ranks, v sorted
+        static double percentile(const std::vector<double>& v, double p){
+            if (v.empty()) return 0;
+            double x = p*(v.size() - 1);
+            size_t i = (size_t)x;
+            if (i + 1 >= v.size()) return v.back();
+            return v[i] + (x - i)*(v[i+1] - v[i]);
+        }
+        void finish(Result& r){
+            std::vector<double> v(r.samples);
+            std::sort(v.begin(), v.end());
+            r.median = percentile(v, 0.5);
+            r.p10 = percentile(v, 0.1);
+            r.p90 = percentile(v, 0.9);
+            r.p99 = percentile(v, 0.99);
+            r.min = v.empty() ? 0 : v.front();
+            double sum = 0;
+            for (double x: v) sum += x;
+            r.mean = v.empty() ? 0 : sum/v.size();
+            print(r);
+            _results.push_back(r);
+        }
+    public:
+        // Keeps results the optimizer would otherwise drop
+        static volatile size_t& sink(){
+            static volatile size_t s = 0;
+            return s;
+        }
+        // ns per item of reps calls to f, each handling per_rep items
+        template<class F>
+        static double time_ns(int reps, size_t per_rep, F f){
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int r=0;r<reps;++r) f();
+            auto stop = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count() / (double)(reps*per_rep);
+        }
+        // Random walk of count moves from the start state, recording every state and
+        // move; a nullptr move marks a restart from the start (Sokoban dead ends)
+        static void random_walk(Game* g, int count, std::mt19937& rng, std::vector<std::shared_ptr<State>>& states, std::vector<std::shared_ptr<Action>>& moves){
+            std::shared_ptr<State> start = g->get_state(), cur = start;
+            for (int i=0;i<count;++i){
+                std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+                g->get_successors(cur.get(), vsa);
+                if (vsa.empty()){
+                    cur = start;
+                    moves.push_back(nullptr);
+                }
+                else{
+                    std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>& sa = vsa[rng() % vsa.size()];
+                    cur = sa.first;
+                    moves.push_back(sa.second);
+                }
+                states.push_back(cur);
+            }
+        }
+        static void random_walk(Game* g, int count, std::mt19937& rng, std::vector<std::shared_ptr<State>>& states){
+            std::vector<std::shared_ptr<Action>> moves;
+            random_walk(g, count, rng, states, moves);
+        }
+        // Whether va played from g's current state reaches a goal
+        static bool replays(Game* g, const std::vector<std::shared_ptr<Action>>& va){
+            std::shared_ptr<State> s = g->get_state();
+            for (const std::shared_ptr<Action>& a: va){
+                if (!g->play_action(s.get(), a.get())) return false;
+            }
+            return g->is_goal_state(s.get());
+        }
+
+        Bench(int warmup = 3, int reps = 21, double min_sample_ms = 5)
+            :_warmup(warmup), _reps(std::max(reps, 1)), _min_sample_ms(min_sample_ms){}
+        // Only run benchmarks whose name contains filter
+        void set_filter(const std::string& filter){_filter = filter;}
+        bool enabled(const std::string& name) const{
+            return name.find(_filter) != std::string::npos;
+        }
+        const std::vector<Result>& get_results() const{return _results;}
+
+        static void header(){
+            printf("%-44s %6s %12s %12s %12s %12s %12s %10s\n", "benchmark", "unit", "median", "p10", "p90", "p99", "min", "samples");
+        }
+        static void print(const Result& r){
+            printf("%-44s %6s %12.2f %12.2f %12.2f %12.2f %12.2f %10zu", r.name.c_str(), r.unit.c_str(), r.median, r.p10, r.p90, r.p99, r.min, r.samples.size());
+            if (r.status != "ok") printf("  %s", r.status.c_str());
+            printf("\n");
+            fflush(stdout);
+        }
+
+        // f() performs ops operations per call
+        template<class F>
+        void micro(const std::string& name, long long ops, F f){
+            if (!enabled(name) || ops <= 0) return;
+            // Calibrate calls per sample (doubling until a sample is long enough)
+            long long calls = 1;
+            for (;;){
+                clock::time_point t0 = clock::now();
+                for (long long i=0;i<calls;++i) f();
+                if (elapsed_ms(t0) >= _min_sample_ms || calls >= (1LL << 30)) break;
+                calls *= 2;
+            }
+            Result r;
+            r.name = name;
+            r.unit = "ns";
+            r.batch = calls*ops;
+            for (int s=0;s<_warmup + _reps;++s){
+                clock::time_point t0 = clock::now();
+                for (long long i=0;i<calls;++i) f();
+                double ms = elapsed_ms(t0);
+                if (s >= _warmup) r.samples.push_back(ms*1e6/r.batch);
+            }
+            finish(r);
+        }
+
+        // Whole runs: f() returns a Run, warm-up runs are not recorded
+        template<class F>
+        void macro(const std::string& name, int warmup, int reps, F f){
+            if (!enabled(name)) return;
+            Result r;
+            r.name = name;
+            r.unit = "ms";
+            for (int s=0;s<warmup + std::max(reps, 1);++s){
+                clock::time_point t0 = clock::now();
+                Run run = f();
+                double ms = elapsed_ms(t0);
+                r.status = run.status;
+                r.counters = run.counters;
+                if (s >= warmup || !run.repeat) r.samples.push_back(ms);
+                if (!run.repeat) break;
+            }
+            finish(r);
+        }
+
+        // One benchmark per line
+        // @return 0 on success
+        int write_json(const std::string& path, const std::map<std::string, std::string>& meta) const{
+            std::ofstream fout(path);
+            if (!fout){
+                std::cerr << "(Bench::write_json) Error: cannot write <" << path << ">" << std::endl;
+                return 1;
+            }
+            fout << "{" << std::endl;
+            for (const std::pair<const std::string, std::string>& kv: meta){
+                fout << "  \"" << json_escape(kv.first) << "\": \"" << json_escape(kv.second) << "\"," << std::endl;
+            }
+            fout << "  \"benchmarks\": [" << std::endl;
+            for (size_t i=0;i<_results.size();++i){
+                const Result& r = _results[i];
+                char buf[512];
+                snprintf(buf, sizeof(buf), "\"unit\": \"%s\", \"batch\": %lld, \"samples\": %zu, \"median\": %.6g, \"p10\": %.6g, \"p90\": %.6g, \"p99\": %.6g, \"min\": %.6g, \"mean\": %.6g",
+                         r.unit.c_str(), r.batch, r.samples.size(), r.median, r.p10, r.p90, r.p99, r.min, r.mean);
+                fout << "    {\"name\": \"" << json_escape(r.name) << "\", " << buf << ", \"status\": \"" << json_escape(r.status) << "\"";
+                for (const std::pair<const std::string, double>& c: r.counters){
+                    fout << ", \"" << json_escape(c.first) << "\": " << c.second;
+                }
+                fout << "}" << (i + 1 < _results.size() ? "," : "") << std::endl;
+            }
+            fout << "  ]" << std::endl << "}" << std::endl;
+            return 0;
+        }
+
+        // (name, median) of every benchmark line in a file written by write_json
+        // @return 0 on success
+        static int read_medians(const std::string& path, std::vector<std::pair<std::string, double>>& out){
+            std::ifstream fin(path);
+            if (!fin){
+                std::cerr << "(Bench::read_medians) Error: cannot read <" << path << ">" << std::endl;
+                return 1;
+            }
+            std::string line;
+            const std::string name_key = "{\"name\": \"", median_key = "\"median\": ";
+            while (std::getline(fin, line)){
+                size_t n = line.find(name_key), m = line.find(median_key);
+                if (n == std::string::npos || m == std::string::npos) continue;
+                n += name_key.size();
+                size_t end = line.find('"', n);
+                if (end == std::string::npos) continue;
+                out.push_back(std::make_pair(line.substr(n, end - n), std::atof(line.c_str() + m + median_key.size())));
+            }
+            return 0;
+        }
+
+        // Median change of every benchmark in both files (positive: slower)
+        // @return 0 on success
+        static int compare(const std::string& before, const std::string& after){
+            std::vector<std::pair<std::string, double>> a, b;
+            if (read_medians(before, a) || read_medians(after, b)) return 1;
+            std::map<std::string, double> old(a.begin(), a.end());
+            printf("%-44s %12s %12s %9s\n", "benchmark", "before", "after", "change");
+            for (const std::pair<std::string, double>& nb: b){
+                std::map<std::string, double>::iterator it = old.find(nb.first);
+                if (it == old.end()){
+                    printf("%-44s %12s %12.2f %9s\n", nb.first.c_str(), "-", nb.second, "new");
+                    continue;
+                }
+                double change = it->second > 0 ? 100.0*(nb.second - it->second)/it->second : 0;
+                printf("%-44s %12.2f %12.2f %+8.1f%%\n", nb.first.c_str(), it->second, nb.second, change);
+            }
+            return 0;
+        }
+};
@@ -0,0 +1,169 @@
+#include "../src/game/ConnectFour.h"
+#include "../src/agent/AlphaBetaAgent.h"
+#include "../src/agent/ExpectimaxAgent.h"
+#include <getopt.h>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Nodes per second of AlphaBetaAgent and ExpectimaxAgent on Connect-Four, searched
+// to a fixed depth for each thread count, from random openings. Before timing,
+// both agents (one thread) are checked against plain minimax/expectimax without
+// table or ordering at a small depth: the root values must match exactly,
+// otherwise the bench exits non-zero.
+
+int help(){
+    printf("Usage: ./adversarial_bench [-d: alpha-beta depth] [-e: expectimax depth] [-c: check depth] [-j: thread counts, e.g. 1,2,4] [-n: positions] [-o: opening plies] [-s: seed]\n");
+    return 1;
+}
+
+static int adjust(int v, int ply){
+    return v >= AdversarialGame::WIN_BOUND ? v - ply : v <= -AdversarialGame::WIN_BOUND ? v + ply : v;
+}
+
+// Reference searches, same leaf values and win adjustment as the agents
+static int minimax(const ConnectFour& g, ConnectFourState& s, int depth, int ply){
+    int side = g.to_move(&s);
+    if (depth == 0 || g.is_terminal(&s)) return adjust(g.evaluate(&s, side), ply);
+    int moves[ConnectFour::COLS];
+    int n = g.get_moves(&s, moves), best = -AdversarialGame::WIN_SCORE - 1;
+    for (int i=0;i<n;++i){
+        g.make_move(&s, moves[i]);
+        best = std::max(best, -minimax(g, s, depth - 1, ply + 1));
+        g.undo_move(&s, moves[i]);
+    }
+    return best;
+}
+
+static int expectimax(const ConnectFour& g, ConnectFourState& s, int player, int depth, int ply){
+    if (depth == 0 || g.is_terminal(&s)) return adjust(g.evaluate(&s, player), ply);
+    int moves[ConnectFour::COLS];
+    int n = g.get_moves(&s, moves);
+    int best = -AdversarialGame::WIN_SCORE - 1;
+    long long sum = 0;
+    for (int i=0;i<n;++i){
+        g.make_move(&s, moves[i]);
+        int v = expectimax(g, s, player, depth - 1, ply + 1);
+        g.undo_move(&s, moves[i]);
+        best = std::max(best, v);
+        sum += v;
+    }
+    return g.to_move(&s) == player ? best : (int)std::lround((double)sum/n);
+}
+
+int main(int argc, char* argv[]){
+    int ab_depth = 18, em_depth = 9, check_depth = 7;
+    std::vector<int> thread_counts = {1, 2, 4};
+    int positions = 4, plies = 8;
+    unsigned seed = 1;
+    int c;
+    while((c = getopt(argc, argv, "d:e:c:j:n:o:s:")) != -1){
+        switch(c){
+            case 'd':
+                ab_depth = std::atoi(optarg);
+                break;
+            case 'e':
+                em_depth = std::atoi(optarg);
+                break;
+            case 'c':
+                check_depth = std::atoi(optarg);
+                break;
+            case 'j':{
+                thread_counts.clear();
+                std::stringstream ss(optarg);
+                std::string tok;
+                while (std::getline(ss, tok, ',')) thread_counts.push_back(std::atoi(tok.c_str()));
+                break;
+            }
+            case 'n':
+                positions = std::atoi(optarg);
+                break;
+            case 'o':
+                plies = std::atoi(optarg);
+                break;
+            case 's':
+                seed = std::atoi(optarg);
+                break;
+            case '?':
+                return help();
+        }
+    }
+
+    // Random openings that leave the game open
+    std::mt19937 rng(seed);
+    std::vector<std::string> openings;
+    while ((int)openings.size() < positions){
+        ConnectFour g;
+        std::string seq;
+        for (int i=0;i<plies;++i){
+            std::shared_ptr<State> s = g.get_state();
+            int moves[ConnectFour::COLS];
+            int n = g.get_moves(s.get(), moves);
+            std::string next(1, '1' + moves[rng() % n]);
+            if (!g.load_moves(next)) break;
+            seq += next;
+        }
+        if ((int)seq.size() < plies) continue;
+        // and not decided within a few plies
+        ConnectFourState s = *std::static_pointer_cast<ConnectFourState>(g.get_state());
+        if (std::abs(minimax(g, s, 4, 0)) < AdversarialGame::WIN_BOUND) openings.push_back(seq);
+    }
+
+    SolveOptions options;
+    options.verbose = false;
+    int failures = 0;
+    for (const std::string& seq: openings){
+        ConnectFour g;
+        g.load_moves(seq);
+        std::shared_ptr<State> root = g.get_state();
+        ConnectFourState s = *std::static_pointer_cast<ConnectFourState>(root);
+        int ref_ab = minimax(g, s, check_depth, 0);
+        int ref_em = expectimax(g, s, g.to_move(&s), check_depth, 0);
+        AlphaBetaAgent ab(&g);
+        ExpectimaxAgent em(&g);
+        for (AdversarialAgent* a: {(AdversarialAgent*)&ab, (AdversarialAgent*)&em}){
+            a->set_options(options);
+            a->set_max_depth(check_depth);
+            std::vector<std::shared_ptr<Action>> va;
+            a->solve(va);
+        }
+        if (ab.get_value() != ref_ab || em.get_value() != ref_em){
+            std::cerr << "(main) Error: opening " << seq << " at depth " << check_depth << ": alpha-beta " << ab.get_value()
+                      << " vs minimax " << ref_ab << ", expectimax " << em.get_value() << " vs " << ref_em << std::endl;
+            failures++;
+        }
+    }
+    printf("checked %d openings at depth %d against plain minimax/expectimax: %d mismatches\n\n", positions, check_depth, failures);
+
+    printf("%-10s %-11s %7s %5s %9s %12s %9s %12s\n", "opening", "agent", "threads", "depth", "value", "nodes", "ms", "nodes/s");
+    for (const std::string& seq: openings){
+        for (int expecti=0;expecti<2;++expecti){
+            for (int threads: thread_counts){
+                ConnectFour g;
+                g.load_moves(seq);
+                std::unique_ptr<AdversarialAgent> a(expecti ? (AdversarialAgent*)new ExpectimaxAgent(&g) : (AdversarialAgent*)new AlphaBetaAgent(&g));
+                a->set_options(options);
+                a->set_threads(threads);
+                a->set_max_depth(expecti ? em_depth : ab_depth);
+                std::vector<std::shared_ptr<Action>> va;
+                if (a->solve(va)){
+                    failures++;
+                    continue;
+                }
+                double ms = a->get_stats().time_ms;
+                printf("%-10s %-11s %7d %5d %9d %12lld %9.1f %12.0f\n", seq.c_str(), expecti ? "expectimax" : "alphabeta", threads,
+                       a->get_depth(), a->get_value(), a->get_nodes(), ms, ms > 0 ? 1000.0*a->get_nodes()/ms : 0.0);
+                fflush(stdout);
+            }
+        }
+    }
+    if (failures){
+        std::cerr << "(main) Error: " << failures << " failed checks or searches" << std::endl;
+        return 1;
+    }
+    return 0;
+}
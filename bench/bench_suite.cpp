@@ -0,0 +1,403 @@
+#include "Bench.h"
+#include "../src/game/NPuzzle.h"
+#include "../src/game/NPuzzleCorpus.h"
+#include "../src/game/FixedNPuzzle.h"
+#include "../src/game/Sokoban.h"
+#include "../src/game/SokobanLevel.h"
+#include "../src/heuristic/NPuzzleHeuristic.h"
+#include "../src/heuristic/FixedNPuzzleHeuristic.h"
+#include "../src/heuristic/SokobanHeuristic.h"
+#include "../src/agent/AstarSearchAgent.h"
+#include "../src/agent/MemoryBoundedAgent.h"
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+// Reproducible benchmark suite (make bench)
+// Micro: Game::get_successors, play_action, State::hash and operator==, every
+// Heuristic::score (and score_child), and the two open lists (the std::set of
+// AstarSearchAgent and the binary heap of AStar), on states from fixed-seed
+// random walks. Macro: A* solves of NPuzzle corpus boards, fixed-seed 4x4
+// scrambles and every level of a Sokoban collection, and MemoryBoundedAgent
+// under tight bounds. Every solution is replayed and must reach a goal, and a
+// bounded search must not run out of time, otherwise the suite exits non-zero.
+
+int help(){
+    printf("Usage: ./bench_suite [-o: results json] [-l: label, e.g. commit] [-b: only benchmarks whose name contains this] [-w: micro warm-up samples] [-r: micro samples] [-m: min ms per micro sample] [-W: macro warm-up runs] [-R: macro runs] [-T: seconds per solve] [-s: seed] [-n: states per micro benchmark] [-k: 3x3 corpus boards] [-f: sokoban level for micro] [-L: sokoban collection for macro] [-P: hardware counters per search phase for macro solves] [-c: compare before.json after.json]\n");
+    return 1;
+}
+
+typedef std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> successors;
+
+// Game and heuristic micro benchmarks on states of g
+static void micro_game(Bench& bench, const std::string& prefix, Game* g, Heuristic* h, int count, unsigned seed){
+    std::mt19937 rng(seed);
+    std::vector<std::shared_ptr<State>> states;
+    std::vector<std::shared_ptr<Action>> moves;
+    Bench::random_walk(g, count, rng, states, moves);
+    // Equal copies in other objects (through the packed encoding)
+    std::vector<std::shared_ptr<State>> copies;
+    std::vector<uint8_t> buf(g->max_packed_size());
+    for (std::shared_ptr<State>& s: states){
+        g->pack(s.get(), buf.data());
+        std::shared_ptr<State> c = g->unpack(buf.data(), buf.size());
+        copies.push_back(c ? c : s);
+    }
+    // (parent, action, child) for score_child
+    struct Edge{
+        const State* parent;
+        double parent_h;
+        std::shared_ptr<Action> action;
+        std::shared_ptr<State> child;
+    };
+    std::vector<Edge> edges;
+    for (size_t i=0;i<states.size() && edges.size()<states.size();++i){
+        successors vsa;
+        g->get_successors(states[i].get(), vsa);
+        for (std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>& sa: vsa){
+            edges.push_back(Edge{states[i].get(), h->score(states[i].get(), g), sa.second, sa.first});
+        }
+    }
+    size_t n = states.size();
+
+    bench.micro(prefix + "/get_successors", n, [&](){
+        successors vsa;
+        for (std::shared_ptr<State>& s: states){
+            vsa.clear();
+            g->get_successors(s.get(), vsa);
+            Bench::sink() += vsa.size();
+        }
+    });
+    size_t played = 0;
+    for (std::shared_ptr<Action>& a: moves) played += a != nullptr;
+    bench.micro(prefix + "/play_action", played, [&](){
+        std::shared_ptr<State> s = g->get_state();
+        for (std::shared_ptr<Action>& a: moves){
+            if (!a) s = g->get_state();
+            else Bench::sink() += g->play_action(s.get(), a.get());
+        }
+    });
+    bench.micro(prefix + "/hash", n, [&](){
+        for (std::shared_ptr<State>& s: states) Bench::sink() += s->hash();
+    });
+    bench.micro(prefix + "/operator==/equal", n, [&](){
+        for (size_t i=0;i<n;++i) Bench::sink() += *states[i] == *copies[i];
+    });
+    bench.micro(prefix + "/operator==/differ", n - 1, [&](){
+        for (size_t i=1;i<n;++i) Bench::sink() += *states[i-1] == *states[i];
+    });
+    bench.micro(prefix + "/score", n, [&](){
+        for (std::shared_ptr<State>& s: states) Bench::sink() += (size_t)h->score(s.get(), g);
+    });
+    if (h->is_incremental()){
+        bench.micro(prefix + "/score_child", edges.size(), [&](){
+            for (Edge& e: edges) Bench::sink() += (size_t)h->score_child(e.parent_h, e.parent, e.action.get(), e.child.get(), g);
+        });
+    }
+}
+
+// Open list entry, in AstarSearchAgent's order (lowest f, then lowest h, then newest)
+struct OpenNode{
+    double f, h;
+    long long seq;
+};
+struct OpenNodeOrder{
+    bool operator()(const std::shared_ptr<OpenNode>& a, const std::shared_ptr<OpenNode>& b) const{
+        if (a->f != b->f) return a->f < b->f;
+        if (a->h != b->h) return a->h < b->h;
+        return a->seq > b->seq;
+    }
+};
+// AStar's heap entry (std::priority_queue pops the largest)
+struct HeapEntry{
+    double f, h;
+    long long seq;
+    uint32_t id;
+    bool operator<(const HeapEntry& o) const{
+        if (f != o.f) return f > o.f;
+        if (h != o.h) return h > o.h;
+        return seq < o.seq;
+    }
+};
+
+static void micro_open_list(Bench& bench, int count, unsigned seed){
+    std::mt19937 rng(seed);
+    // Integer f and h in a narrow band, as in unit-cost searches (many ties)
+    std::vector<std::shared_ptr<OpenNode>> nodes;
+    for (int i=0;i<count;++i){
+        double h = rng() % 40;
+        nodes.push_back(std::make_shared<OpenNode>(OpenNode{h + rng() % 20, h, i}));
+    }
+    typedef std::set<std::shared_ptr<OpenNode>, OpenNodeOrder> open_set;
+    bench.micro("micro/open_list/set_push_pop", count, [&](){
+        open_set open;
+        for (std::shared_ptr<OpenNode>& p: nodes) open.insert(p);
+        while (!open.empty()){
+            Bench::sink() += open.begin()->get()->seq;
+            open.erase(open.begin());
+        }
+    });
+    // Cheaper path to an open state: erase by iterator and insert again
+    open_set open(nodes.begin(), nodes.end());
+    std::vector<open_set::iterator> where;
+    for (std::shared_ptr<OpenNode>& p: nodes) where.push_back(open.find(p));
+    std::vector<int> order(count);
+    for (int i=0;i<count;++i) order[i] = rng() % count;
+    bench.micro("micro/open_list/set_reprioritize", count, [&](){
+        for (int i: order){
+            std::shared_ptr<OpenNode> p = *where[i];
+            open.erase(where[i]);
+            p->f = p->f > p->h ? p->f - 1 : p->h + 20;
+            where[i] = open.insert(p).first;
+        }
+    });
+    bench.micro("micro/open_list/heap_push_pop", count, [&](){
+        std::priority_queue<HeapEntry> heap;
+        for (int i=0;i<count;++i) heap.push(HeapEntry{nodes[i]->f, nodes[i]->h, nodes[i]->seq, (uint32_t)i});
+        while (!heap.empty()){
+            Bench::sink() += heap.top().id;
+            heap.pop();
+        }
+    });
+}
+
+// Solve of g's current state by agent, replayed to check the solution
+// With options.perf, the counts of each phase go into the run's counters
+static Bench::Run run_agent(Agent& agent, Game* g, const SolveOptions& options, int& failures){
+    agent.set_options(options);
+    if (options.perf) options.perf->reset();
+    std::vector<std::shared_ptr<Action>> va;
+    int code = agent.solve(va);
+    const SearchStats& st = agent.get_stats();
+    Bench::Run run;
+    run.status = Agent::status_name(code);
+    run.counters["expanded"] = st.expanded;
+    run.counters["generated"] = st.generated;
+    run.counters["moves"] = va.size();
+    for (int p=0;options.perf && p<PerfCounters::NUM_PHASES;++p){
+        for (int e=0;e<PerfCounters::NUM_EVENTS;++e){
+            if (!options.perf->available(e)) continue;
+            run.counters[std::string(PerfCounters::phase_name(p)) + "." + PerfCounters::event_name(e)] = options.perf->get(p, e);
+        }
+    }
+    // Runs out of budget: timing it again says nothing new
+    run.repeat = code == Agent::SOLVE_STATUS::SOLVED;
+    if (code == Agent::SOLVE_STATUS::SOLVED){
+        if (!Bench::replays(g, va)){
+            run.status = "wrong_solution";
+            failures++;
+        }
+    }
+    return run;
+}
+
+static Bench::Run solve(Game* g, Heuristic* h, const SolveOptions& options, int& failures){
+    AstarSearchAgent astar(g, h, 1.0);
+    return run_agent(astar, g, options, failures);
+}
+
+// MemoryBoundedAgent under a tight bound must solve or give up with memory_limit,
+// running out of time means leaf pruning thrashed
+static Bench::Run solve_bounded(Game* g, Heuristic* h, double bound_mb, const SolveOptions& options, int& failures){
+    MemoryBoundedAgent bounded(g, h);
+    bounded.set_memory_bound((size_t)(bound_mb*1024*1024));
+    Bench::Run run = run_agent(bounded, g, options, failures);
+    if (run.status != Agent::status_name(Agent::SOLVE_STATUS::SOLVED) && run.status != Agent::status_name(Agent::SOLVE_STATUS::MEMORY_LIMIT)
+        && run.status != "wrong_solution"){
+        run.status = "thrashed";
+        failures++;
+    }
+    return run;
+}
+
+int main(int argc, char* argv[]){
+    int warmup = 3, reps = 21, macro_warmup = 1, macro_reps = 3;
+    double min_sample_ms = 5, seconds = 2;
+    unsigned seed = 23;
+    int count = 4096, corpus_boards = 20;
+    std::string out_file, label, filter;
+    std::string micro_level = "sokoban_61kids/Dimitri-Yorick_52.in";
+    std::string collection = "sokoban_61kids/Dimitri-Yorick.txt";
+    std::string corpus_file = "npuzzle_corpus/3x3_100.npc";
+    bool compare = false, perf_counters = false;
+    int c;
+    while((c = getopt(argc, argv, "o:l:b:w:r:m:W:R:T:s:n:k:f:L:Pc")) != -1){
+        switch(c){
+            case 'o':
+                out_file = optarg;
+                break;
+            case 'l':
+                label = optarg;
+                break;
+            case 'b':
+                filter = optarg;
+                break;
+            case 'w':
+                warmup = std::atoi(optarg);
+                break;
+            case 'r':
+                reps = std::atoi(optarg);
+                break;
+            case 'm':
+                min_sample_ms = std::atof(optarg);
+                break;
+            case 'W':
+                macro_warmup = std::atoi(optarg);
+                break;
+            case 'R':
+                macro_reps = std::atoi(optarg);
+                break;
+            case 'T':
+                seconds = std::atof(optarg);
+                break;
+            case 's':
+                seed = std::atoi(optarg);
+                break;
+            case 'n':
+                count = std::atoi(optarg);
+                break;
+            case 'k':
+                corpus_boards = std::atoi(optarg);
+                break;
+            case 'f':
+                micro_level = optarg;
+                break;
+            case 'L':
+                collection = optarg;
+                break;
+            case 'P':
+                perf_counters = true;
+                break;
+            case 'c':
+                compare = true;
+                break;
+            case '?':
+                return help();
+        }
+    }
+    if (compare){
+        if (argc - optind != 2) return help();
+        return Bench::compare(argv[optind], argv[optind + 1]);
+    }
+    if (count < 2) return help();
+
+    Bench bench(warmup, reps, min_sample_ms);
+    bench.set_filter(filter);
+    Bench::header();
+
+    // Micro benchmarks
+    {
+        NPuzzle np(4, 4, seed);
+        np.randomize();
+        NPuzzleHeuristic h;
+        micro_game(bench, "micro/npuzzle4x4", &np, &h, count, seed);
+        // Compile-time board from the same start
+        FixedNPuzzle<4, 4> fp(*dynamic_cast<TileState*>(np.get_state().get()));
+        FixedNPuzzleHeuristic<4, 4> fh;
+        micro_game(bench, "micro/fixed4x4", &fp, &fh, count, seed);
+    }
+    {
+        std::vector<SokobanLevel> levels;
+        if (SokobanLevel::load_path(micro_level, levels) || levels.empty()) return 1;
+        std::unique_ptr<Sokoban> sokoban(levels[0].make_game(true));
+        if (!sokoban) return 1;
+        SokobanHeuristic h;
+        micro_game(bench, "micro/sokoban", sokoban.get(), &h, count, seed);
+    }
+    micro_open_list(bench, count, seed);
+
+    // Macro benchmarks
+    SolveOptions options;
+    options.time_limit_ms = seconds*1000.0;
+    options.verbose = false;
+    PerfCounters perf;
+    if (perf_counters) options.perf = &perf;
+    int failures = 0;
+    {
+        NPuzzleCorpus corpus;
+        if (corpus.load(corpus_file)) return 1;
+        pii dims = corpus.get_dims();
+        NPuzzle np(dims.second, dims.first, seed);
+        NPuzzleHeuristic h;
+        for (size_t i=0;i<corpus.size() && (int)i<corpus_boards;++i){
+            np.set_board(corpus.get(i));
+            bench.macro("macro/npuzzle" + std::to_string(dims.first) + "x" + std::to_string(dims.second) + "/" + std::to_string(i), macro_warmup, macro_reps, [&](){
+                return solve(&np, &h, options, failures);
+            });
+        }
+    }
+    for (unsigned k=0;k<5;++k){
+        NPuzzle np(4, 4, seed + k);
+        np.scramble(60);
+        NPuzzleHeuristic h;
+        bench.macro("macro/npuzzle4x4/scramble60_" + std::to_string(seed + k), macro_warmup, macro_reps, [&](){
+            return solve(&np, &h, options, failures);
+        });
+    }
+    {
+        std::vector<SokobanLevel> levels;
+        if (SokobanLevel::load_path(collection, levels)) return 1;
+        SokobanHeuristic h;
+        for (SokobanLevel& level: levels){
+            std::string name = "macro/sokoban/" + level._name;
+            if (!bench.enabled(name)) continue;
+            std::unique_ptr<Sokoban> sokoban(level.make_game(true));
+            if (!sokoban) continue;
+            bench.macro(name, macro_warmup, macro_reps, [&](){
+                return solve(sokoban.get(), &h, options, failures);
+            });
+        }
+    }
+    {
+        // Tight bounds that once made leaf pruning thrash: 3x3 board 24 at 1 MB,
+        // level 50 at 4 MB (solves) and 2 MB (memory_limit), with 10x the time limit
+        SolveOptions bounded_options = options;
+        bounded_options.time_limit_ms *= 10;
+        NPuzzleCorpus corpus;
+        if (corpus.load(corpus_file)) return 1;
+        pii dims = corpus.get_dims();
+        NPuzzle np(dims.second, dims.first, seed);
+        NPuzzleHeuristic nh;
+        if (corpus.size() > 24){
+            np.set_board(corpus.get(24));
+            bench.macro("macro/bounded/npuzzle" + std::to_string(dims.first) + "x" + std::to_string(dims.second) + "/24_1MB", macro_warmup, macro_reps, [&](){
+                return solve_bounded(&np, &nh, 1, bounded_options, failures);
+            });
+        }
+        std::vector<SokobanLevel> levels;
+        if (SokobanLevel::load_path(collection, levels)) return 1;
+        SokobanHeuristic sh;
+        for (SokobanLevel& level: levels){
+            if (level._name != "Dimitri-Yorick_50") continue;
+            std::unique_ptr<Sokoban> sokoban(level.make_game(true));
+            if (!sokoban) continue;
+            for (double mb: {4.0, 2.0}){
+                bench.macro("macro/bounded/sokoban/" + level._name + "_" + std::to_string((int)mb) + "MB", macro_warmup, macro_reps, [&](){
+                    return solve_bounded(sokoban.get(), &sh, mb, bounded_options, failures);
+                });
+            }
+        }
+    }
+
+    if (!out_file.empty()){
+        std::map<std::string, std::string> meta;
+        meta["label"] = label;
+        meta["seed"] = std::to_string(seed);
+        meta["micro_samples"] = std::to_string(warmup) + " warm-up + " + std::to_string(reps);
+        meta["macro_runs"] = std::to_string(macro_warmup) + " warm-up + " + std::to_string(macro_reps);
+        char limit[32];
+        snprintf(limit, sizeof(limit), "%g", seconds);
+        meta["time_limit_s"] = limit;
+        if (bench.write_json(out_file, meta)) return 1;
+    }
+    if (failures){
+        std::cerr << "(main) Error: " << failures << " solutions did not replay to a goal or bounded searches ran out of time" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,177 @@
+#include "../src/game/Sokoban.h"
+#include "../src/game/SokobanLevel.h"
+#include "../src/game/NPuzzle.h"
+#include "../src/agent/Agent.h"
+#include "../src/util/FlatStateMap.h"
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+
+// Times the visited-map operations of a search (insert, hit, miss, erase) on
+// std::unordered_map<shared_ptr<State>, V, StatePointerHash, DerefCompare>
+// against FlatStateMap<V>. Hits look up equal copies, not the inserted pointers,
+// as a search does with freshly generated successors. Both maps must agree on
+// every answer, otherwise the bench exits non-zero.
+
+typedef std::shared_ptr<State> state_ptr;
+typedef std::unordered_map<state_ptr, long, StatePointerHash, DerefCompare> std_map;
+typedef FlatStateMap<long> flat_map;
+
+int help(){
+    printf("Usage: ./flat_map_bench [-n: states per game] [-r: repetitions] [-s: seed] [-G: hash diagnostics] [level paths...]\n");
+    return 1;
+}
+
+// Breadth-first states from the start, up to count (distinct, so they make a visited set)
+static void bfs_states(Game* g, size_t count, std::vector<state_ptr>& out){
+    std_map seen;
+    std::deque<state_ptr> frontier;
+    state_ptr start = g->get_state();
+    seen[start] = 0;
+    frontier.push_back(start);
+    while (!frontier.empty() && seen.size() < count){
+        state_ptr s = frontier.front();
+        frontier.pop_front();
+        out.push_back(s);
+        std::vector<std::pair<state_ptr, std::shared_ptr<Action>>> vsa;
+        g->get_successors(s.get(), vsa);
+        for (auto& sa: vsa){
+            if (seen.size() >= count) break;
+            if (seen.insert(std::make_pair(sa.first, 0)).second) frontier.push_back(sa.first);
+        }
+    }
+    while (!frontier.empty()){
+        out.push_back(frontier.front());
+        frontier.pop_front();
+    }
+}
+
+// Equal but separately allocated copies
+static void copies(Game* g, const std::vector<state_ptr>& in, std::vector<state_ptr>& out){
+    std::vector<uint8_t> buf(g->max_packed_size());
+    for (const state_ptr& s: in){
+        g->pack(s.get(), buf.data());
+        out.push_back(g->unpack(buf.data(), buf.size()));
+    }
+}
+
+struct Timing{
+    double insert_ns, hit_ns, miss_ns, erase_ns;
+    long checksum;
+};
+
+template<class M>
+static Timing run(const std::vector<state_ptr>& keys, const std::vector<state_ptr>& hits,
+                  const std::vector<state_ptr>& misses, int reps){
+    typedef std::chrono::high_resolution_clock clock;
+    Timing t = {0, 0, 0, 0, 0};
+    for (int r=0;r<reps;++r){
+        M m;
+        auto t0 = clock::now();
+        for (size_t i=0;i<keys.size();++i) m.insert(std::make_pair(keys[i], (long)i));
+        auto t1 = clock::now();
+        for (const state_ptr& s: hits){
+            auto it = m.find(s);
+            t.checksum += it == m.end() ? -1 : it->second;
+        }
+        auto t2 = clock::now();
+        for (const state_ptr& s: misses) t.checksum += m.find(s) == m.end() ? 0 : 1000000007;
+        auto t3 = clock::now();
+        for (const state_ptr& s: hits) t.checksum += m.erase(s);
+        auto t4 = clock::now();
+        t.checksum += m.size();
+        t.insert_ns += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        t.hit_ns += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        t.miss_ns += std::chrono::duration<double, std::nano>(t3 - t2).count();
+        t.erase_ns += std::chrono::duration<double, std::nano>(t4 - t3).count();
+    }
+    double n = (double)reps;
+    t.insert_ns /= n*keys.size();
+    t.hit_ns /= n*hits.size();
+    t.miss_ns /= n*(misses.empty() ? 1 : misses.size());
+    t.erase_ns /= n*hits.size();
+    return t;
+}
+
+static int compare(const std::string& name, Game* g, std::vector<state_ptr>& states, int reps, bool diagnostics){
+    // Odd positions are held out as misses
+    std::vector<state_ptr> keys, misses, hits;
+    for (size_t i=0;i<states.size();++i) (i % 2 ? misses : keys).push_back(states[i]);
+    copies(g, keys, hits);
+    Timing a = run<std_map>(keys, hits, misses, reps);
+    Timing b = run<flat_map>(keys, hits, misses, reps);
+    printf("%-14s %8zu keys  insert %7.1f / %7.1f ns  hit %7.1f / %7.1f ns  miss %7.1f / %7.1f ns  erase %7.1f / %7.1f ns  %s\n",
+           name.c_str(), keys.size(), a.insert_ns, b.insert_ns, a.hit_ns, b.hit_ns, a.miss_ns, b.miss_ns,
+           a.erase_ns, b.erase_ns, a.checksum == b.checksum ? "ok" : "MISMATCH");
+    if (diagnostics){
+        flat_map m;
+        for (size_t i=0;i<keys.size();++i) m.insert(std::make_pair(keys[i], (long)i));
+        printf("  hash: ");
+        fflush(stdout);
+        m.report(std::cout);
+        std::cout << std::endl;
+    }
+    return a.checksum == b.checksum ? 0 : 1;
+}
+
+int main(int argc, char* argv[]){
+    size_t count = 50000;
+    int reps = 3;
+    unsigned seed = 23;
+    bool diagnostics = false;
+    int c;
+    while((c = getopt(argc, argv, "n:r:s:G")) != -1){
+        switch(c){
+            case 'n':
+                count = std::atoll(optarg);
+                break;
+            case 'r':
+                reps = std::atoi(optarg);
+                break;
+            case 's':
+                seed = std::atoi(optarg);
+                break;
+            case 'G':
+                diagnostics = true;
+                break;
+            case '?':
+                return help();
+        }
+    }
+    std::vector<std::string> paths;
+    for (int i=optind;i<argc;++i) paths.push_back(argv[i]);
+    if (paths.empty()) paths.push_back("sokoban_61kids/Dimitri-Yorick_61.in");
+
+    printf("std::unordered_map / FlatStateMap, ns per operation\n");
+    int failures = 0;
+    for (int d: {3, 4}){
+        NPuzzle np(d, d, seed);
+        np.randomize();
+        std::vector<state_ptr> states;
+        bfs_states(&np, count, states);
+        failures += compare("npuzzle " + std::to_string(d) + "x" + std::to_string(d), &np, states, reps, diagnostics);
+    }
+    for (const std::string& path: paths){
+        std::vector<SokobanLevel> loaded;
+        if (SokobanLevel::load_path(path, loaded)) return 1;
+        for (SokobanLevel& level: loaded){
+            Sokoban* sokoban = level.make_game(true);
+            if (!sokoban) continue;
+            std::vector<state_ptr> states;
+            bfs_states(sokoban, count, states);
+            failures += compare("sokoban " + level._name, sokoban, states, reps, diagnostics);
+            delete sokoban;
+        }
+    }
+    if (failures){
+        std::cerr << "(main) Error: the maps disagreed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
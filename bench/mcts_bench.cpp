@@ -0,0 +1,127 @@
+#include "Bench.h"
+#include "../src/game/Sokoban.h"
+#include "../src/game/SokobanLevel.h"
+#include "../src/heuristic/SokobanHeuristic.h"
+#include "../src/agent/AstarSearchAgent.h"
+#include "../src/agent/MCTSAgent.h"
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Solve rate and rollouts per second of MCTSAgent within a time budget, for
+// each thread count in tree and root parallel mode, over several seeds. A* gets
+// the same budget for contrast (-A). Every solution is replayed and must reach a
+// goal, otherwise the bench exits non-zero.
+
+int help(){
+    printf("Usage: ./mcts_bench [-T: seconds per run] [-j: thread counts, e.g. 1,2,4] [-n: seeds per configuration] [-A: also run A*] [-c: exploration] [-d: rollout depth] [-e: rollout epsilon] [level paths...]\n");
+    return 1;
+}
+
+int main(int argc, char* argv[]){
+    double seconds = 10;
+    std::vector<int> thread_counts = {1, 2, 4};
+    int seeds = 3;
+    bool with_astar = false;
+    double exploration = 1.0, epsilon = 0.3;
+    int depth = 200;
+    int c;
+    while((c = getopt(argc, argv, "T:j:n:Ac:d:e:")) != -1){
+        switch(c){
+            case 'T':
+                seconds = std::atof(optarg);
+                break;
+            case 'j':{
+                thread_counts.clear();
+                std::stringstream ss(optarg);
+                std::string tok;
+                while (std::getline(ss, tok, ',')) thread_counts.push_back(std::atoi(tok.c_str()));
+                break;
+            }
+            case 'n':
+                seeds = std::atoi(optarg);
+                break;
+            case 'A':
+                with_astar = true;
+                break;
+            case 'c':
+                exploration = std::atof(optarg);
+                break;
+            case 'd':
+                depth = std::atoi(optarg);
+                break;
+            case 'e':
+                epsilon = std::atof(optarg);
+                break;
+            case '?':
+                return help();
+        }
+    }
+    std::vector<std::string> paths;
+    for (int i=optind;i<argc;++i) paths.push_back(argv[i]);
+    if (paths.empty()){
+        for (int l: {52, 57, 58, 61}) paths.push_back("sokoban_61kids/Dimitri-Yorick_" + std::to_string(l) + ".in");
+    }
+
+    SolveOptions options;
+    options.time_limit_ms = seconds*1000.0;
+    options.verbose = false;
+    int failures = 0;
+    printf("%-22s %-14s %8s %12s %10s\n", "level", "agent", "solved", "rollouts/s", "mean s");
+    for (const std::string& path: paths){
+        std::vector<SokobanLevel> loaded;
+        if (SokobanLevel::load_path(path, loaded)) return 1;
+        for (SokobanLevel& level: loaded){
+            Sokoban* sokoban = level.make_game(true);
+            if (!sokoban) continue;
+            SokobanHeuristic heuristic;
+            if (with_astar){
+                AstarSearchAgent astar(sokoban, &heuristic, 1.0);
+                astar.set_options(options);
+                std::vector<std::shared_ptr<Action>> va;
+                int code = astar.solve(va);
+                printf("%-22s %-14s %6d/1 %12s %10.2f\n", level._name.c_str(), "astar", code == Agent::SOLVE_STATUS::SOLVED ? 1 : 0,
+                       "-", astar.get_stats().time_ms/1000.0);
+                if (code == Agent::SOLVE_STATUS::SOLVED && !Bench::replays(sokoban, va)) failures++;
+            }
+            for (int parallel=MCTSAgent::TREE;parallel<=MCTSAgent::ROOT;++parallel){
+                for (int threads: thread_counts){
+                    // Root parallelism on one thread is the same search as tree
+                    if (parallel == MCTSAgent::ROOT && threads == 1) continue;
+                    int solved = 0;
+                    double rollouts = 0, ms = 0;
+                    for (int s=0;s<seeds;++s){
+                        MCTSAgent mcts(sokoban, &heuristic);
+                        mcts.set_threads(threads, (MCTSAgent::parallel_type)parallel);
+                        mcts.set_seed(s + 1);
+                        mcts.set_exploration(exploration);
+                        mcts.set_rollout(depth, epsilon);
+                        mcts.set_options(options);
+                        std::vector<std::shared_ptr<Action>> va;
+                        int code = mcts.solve(va);
+                        if (code == Agent::SOLVE_STATUS::SOLVED){
+                            if (Bench::replays(sokoban, va)) solved++;
+                            else failures++;
+                        }
+                        rollouts += mcts.get_rollouts();
+                        ms += mcts.get_stats().time_ms;
+                    }
+                    std::ostringstream name;
+                    name << "mcts " << (parallel == MCTSAgent::TREE ? "tree" : "root") << " x" << threads;
+                    printf("%-22s %-14s %6d/%d %12.0f %10.2f\n", level._name.c_str(), name.str().c_str(), solved, seeds,
+                           ms > 0 ? 1000.0*rollouts/ms : 0.0, ms/1000.0/seeds);
+                    fflush(stdout);
+                }
+            }
+            delete sokoban;
+        }
+    }
+    if (failures){
+        std::cerr << "(main) Error: " << failures << " solutions did not replay to a goal" << std::endl;
+        return 1;
+    }
+    return 0;
+}
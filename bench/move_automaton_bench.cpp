@@ -0,0 +1,185 @@
+#include "Bench.h"
+#include "../src/game/NPuzzle.h"
+#include "../src/game/Sokoban.h"
+#include "../src/game/SokobanLevel.h"
+#include "../src/heuristic/NPuzzleHeuristic.h"
+#include "../src/heuristic/SokobanHeuristic.h"
+#include "../src/agent/DepthFirstAgent.h"
+#include "../src/agent/MoveAutomaton.h"
+#include <getopt.h>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// What learned move automata (FSM pruning) save depth-first search
+// 1. NPuzzle trees: nodes of a full-width tree of fixed depth from random boards,
+//    with no pruning, with the inverse pairs only (parent pruning) and with the
+//    whole automaton, plus how many distinct states each tree holds.
+// 2. DepthFirstAgent with and without the automaton: tree search (iterative
+//    deepening, no closed set) on random 8-puzzles, where the pruning is exact,
+//    and a bitstate closed set on Sokoban levels (one automaton learned per
+//    level, only checked on sample states).
+// Every solution is replayed and must reach a goal, otherwise the bench exits non-zero.
+
+int help(){
+    printf("Usage: ./move_automaton_bench [-n: npuzzle tree dims] [-d: tree depth] [-L: npuzzle pattern length] [-l: sokoban pattern length] [-k: 8-puzzle instances] [-T: seconds per dfs run] [-H: sokoban bitstate closed set (MB)] [sokoban level paths...]\n");
+    return 1;
+}
+
+// Nodes of the tree below s to depth, moves filtered by fsm (if any)
+static long long tree(Game* g, const std::shared_ptr<State>& s, const MoveAutomaton* fsm, int q, int depth, std::unordered_set<size_t>& distinct){
+    distinct.insert(s->hash());
+    if (depth == 0) return 1;
+    std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+    g->get_successors(s.get(), vsa);
+    long long nodes = 1;
+    for (std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>& sa: vsa){
+        int next = fsm ? fsm->next(q, g->action_code(s.get(), sa.second.get())) : 0;
+        if (next == MoveAutomaton::REJECT) continue;
+        nodes += tree(g, sa.first, fsm, next, depth - 1, distinct);
+    }
+    return nodes;
+}
+
+static void learn(Game* g, int max_len, MoveAutomaton& fsm){
+    std::shared_ptr<State> start = g->get_state();
+    std::vector<std::shared_ptr<State>> roots(1, start), samples;
+    MoveAutomaton::random_states(g, start, 3, 100, 23, roots);
+    MoveAutomaton::random_states(g, start, 64, 100, 24, samples);
+    MoveAutomaton::LearnStats stats;
+    auto t0 = std::chrono::steady_clock::now();
+    MoveAutomaton::learn(g, roots, samples, max_len, 1000000, fsm, stats);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    printf("  learned to length %d: %zu patterns, %zu states, %zu disproved, %.0f ms\n", max_len, stats.patterns, fsm.states(), stats.rejected, ms);
+}
+
+// One DepthFirstAgent run, @return false if a solution does not replay
+static bool run_dfs(const std::string& name, Game* g, Heuristic* h, const MoveAutomaton* fsm, ClosedSet* closed, const SolveOptions& options){
+    DepthFirstAgent dfs(g, h);
+    dfs.set_options(options);
+    dfs.set_tree_search(!closed);
+    dfs.set_closed_set(closed);
+    dfs.set_move_automaton(fsm);
+    std::vector<std::shared_ptr<Action>> va;
+    int code = dfs.solve(va);
+    const SearchStats& st = dfs.get_stats();
+    printf("%-24s %-5s %12lld %12lld %10lld %9.1f %8s %6zu\n", name.c_str(), fsm ? "fsm" : "-", st.expanded, st.generated, dfs.get_pruned(),
+           st.time_ms, Agent::status_name(code), code == Agent::SOLVE_STATUS::SOLVED ? va.size() : 0);
+    fflush(stdout);
+    return code != Agent::SOLVE_STATUS::SOLVED || Bench::replays(g, va);
+}
+
+int main(int argc, char* argv[]){
+    int dims = 4, depth = 12, np_len = 12, sok_len = 3, instances = 5;
+    double seconds = 30, bitstate_mb = 16;
+    int c;
+    while((c = getopt(argc, argv, "n:d:L:l:k:T:H:")) != -1){
+        switch(c){
+            case 'n':
+                dims = std::atoi(optarg);
+                break;
+            case 'd':
+                depth = std::atoi(optarg);
+                break;
+            case 'L':
+                np_len = std::atoi(optarg);
+                break;
+            case 'l':
+                sok_len = std::atoi(optarg);
+                break;
+            case 'k':
+                instances = std::atoi(optarg);
+                break;
+            case 'T':
+                seconds = std::atof(optarg);
+                break;
+            case 'H':
+                bitstate_mb = std::atof(optarg);
+                break;
+            case '?':
+                return help();
+        }
+    }
+    std::vector<std::string> paths;
+    for (int i=optind;i<argc;++i) paths.push_back(argv[i]);
+    if (paths.empty()){
+        for (int l: {52, 57, 58}) paths.push_back("sokoban_61kids/Dimitri-Yorick_" + std::to_string(l) + ".in");
+    }
+    int failures = 0;
+
+    // 1. Tree sizes
+    {
+        NPuzzle np(dims, dims);
+        printf("%dx%d NPuzzle\n", dims, dims);
+        MoveAutomaton fsm, inverse;
+        learn(&np, np_len, fsm);
+        std::vector<std::vector<int>> pairs;
+        for (const std::vector<int>& p: fsm.get_patterns()){
+            if (p.size() == 2) pairs.push_back(p);
+        }
+        inverse.build(fsm.codes(), pairs);
+        printf("\n%-12s %14s %14s %10s %12s\n", "pruning", "nodes", "distinct", "dup %", "branching");
+        const MoveAutomaton* modes[3] = {nullptr, &inverse, &fsm};
+        const char* names[3] = {"none", "inverse", "automaton"};
+        std::vector<std::shared_ptr<State>> boards;
+        for (int k=0;k<3;++k){
+            np.randomize();
+            boards.push_back(np.get_state());
+        }
+        for (int m=0;m<3;++m){
+            long long nodes = 0, distinct = 0;
+            for (std::shared_ptr<State>& b: boards){
+                std::unordered_set<size_t> seen;
+                nodes += tree(&np, b, modes[m], 0, depth, seen);
+                distinct += seen.size();
+            }
+            printf("%-12s %14lld %14lld %10.1f %12.3f\n", names[m], nodes, distinct, 100.0*(nodes - distinct)/nodes, std::pow(nodes/3.0, 1.0/depth));
+            fflush(stdout);
+        }
+    }
+
+    // 2. Depth-first search
+    SolveOptions options;
+    options.time_limit_ms = seconds*1000.0;
+    options.verbose = false;
+    printf("\n%-24s %-5s %12s %12s %10s %9s %8s %6s\n", "instance", "fsm", "expanded", "generated", "pruned", "ms", "status", "moves");
+    {
+        NPuzzle np(3, 3);
+        MoveAutomaton fsm;
+        printf("3x3 NPuzzle\n");
+        learn(&np, 14, fsm);
+        NPuzzleHeuristic h;
+        for (int k=0;k<instances;++k){
+            np.randomize();
+            for (int with=0;with<2;++with){
+                if (!run_dfs("8-puzzle #" + std::to_string(k + 1), &np, &h, with ? &fsm : nullptr, nullptr, options)) failures++;
+            }
+        }
+    }
+    for (const std::string& path: paths){
+        std::vector<SokobanLevel> loaded;
+        if (SokobanLevel::load_path(path, loaded)) return 1;
+        for (SokobanLevel& level: loaded){
+            Sokoban* sokoban = level.make_game(true);
+            if (!sokoban) continue;
+            printf("%s\n", level._name.c_str());
+            MoveAutomaton fsm;
+            learn(sokoban, sok_len, fsm);
+            SokobanHeuristic h;
+            BitstateClosedSet closed(sokoban, (size_t)(bitstate_mb*1024*1024));
+            for (int with=0;with<2;++with){
+                if (!run_dfs(level._name, sokoban, &h, with ? &fsm : nullptr, &closed, options)) failures++;
+            }
+            delete sokoban;
+        }
+    }
+    if (failures){
+        std::cerr << "(main) Error: " << failures << " solutions did not replay to a goal" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "Bench.h"
+#include "../src/game/NPuzzle.h"
+#include "../src/game/FixedNPuzzle.h"
+#include "../src/heuristic/NPuzzleHeuristic.h"
+#include "../src/heuristic/SimdManhattan.h"
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+// Checks every SimdManhattan kernel against NPuzzleHeuristic on random boards,
+// then times single and batched evaluation (ns per board)
+
+int help(){
+    printf("Usage: ./simd_manhattan_bench [-b: boards per size] [-r: repetitions] [-s: seed]\n");
+    return 1;
+}
+
+// Random walk from the goal, recording every visited state
+static void random_boards(NPuzzle* np, int count, std::mt19937& rng,
+                          std::vector<std::shared_ptr<State>>& states, std::vector<std::vector<uint8_t>>& boards){
+    pii dims = np->get_dims();
+    std::shared_ptr<State> cur = np->get_goal_state();
+    for (int i=0;i<count;++i){
+        // Decorrelate consecutive samples with a few moves
+        for (int k=0;k<1+(int)(rng()%20);++k){
+            std::vector<std::shared_ptr<Action>> va;
+            np->get_actions(cur.get(), va);
+            np->play_action(cur.get(), va[rng() % va.size()].get());
+        }
+        std::shared_ptr<State> copy = std::make_shared<TileState>(*dynamic_cast<TileState*>(cur.get()));
+        const TileState* ts = dynamic_cast<const TileState*>(copy.get());
+        std::vector<uint8_t> board(dims.first*dims.second);
+        for (int y=0;y<dims.second;++y){
+            for (int x=0;x<dims.first;++x){
+                pii home = ts->get_tile_home_position(x, y);
+                board[y*dims.first+x] = home.second*dims.first + home.first;
+            }
+        }
+        states.push_back(copy);
+        boards.push_back(board);
+    }
+}
+
+int main(int argc, char* argv[]){
+    int count = 10000;
+    int reps = 20;
+    unsigned seed = 23;
+    int c;
+    while((c = getopt(argc, argv, "b:r:s:")) != -1){
+        switch(c){
+            case 'b':
+                count = std::atoi(optarg);
+                break;
+            case 'r':
+                reps = std::atoi(optarg);
+                break;
+            case 's':
+                seed = std::atoi(optarg);
+                break;
+            case '?':
+                return help();
+        }
+    }
+    std::mt19937 rng(seed);
+    NPuzzleHeuristic np_heu;
+    int dims[][2] = {{3,3},{2,4},{4,4},{5,5}};
+    int failures = 0;
+    volatile long long sink = 0;
+
+    printf("Detected kernel: %s\n", SimdManhattan::kernel_name(SimdManhattan::detect()));
+    for (int d=0;d<4;++d){
+        int rows = dims[d][0], cols = dims[d][1];
+        NPuzzle np(rows, cols);
+        std::vector<std::shared_ptr<State>> states;
+        std::vector<std::vector<uint8_t>> boards;
+        random_boards(&np, count, rng, states, boards);
+        std::vector<const uint8_t*> ptrs;
+        for (std::vector<uint8_t>& b: boards) ptrs.push_back(b.data());
+        std::vector<int> out(count);
+
+        printf("\n%dx%d (%d boards x %d reps)\n", cols, rows, count, reps);
+        // Reference: NPuzzleHeuristic's manhattan term (blank included)
+        double ns_ref = Bench::time_ns(reps, count, [&](){
+            for (std::shared_ptr<State>& s: states) sink += (long long)np_heu.manhattan(dynamic_cast<const TileState*>(s.get()), &np);
+        });
+        printf("  %-10s %8.2f ns/board\n", "reference", ns_ref);
+
+        for (int k=SimdManhattan::SCALAR;k<=SimdManhattan::AVX2;++k){
+            SimdManhattan with_blank(rows, cols, true);
+            SimdManhattan without_blank(rows, cols, false);
+            if (with_blank.set_kernel((SimdManhattan::kernel_type)k) != k) continue;
+            without_blank.set_kernel((SimdManhattan::kernel_type)k);
+            const char* name = SimdManhattan::kernel_name((SimdManhattan::kernel_type)k);
+
+            // Correctness against NPuzzleHeuristic (and blank-free scalar reference)
+            with_blank.score_batch(ptrs.data(), ptrs.size(), out.data());
+            for (int i=0;i<count;++i){
+                int expect = (int)np_heu.manhattan(dynamic_cast<const TileState*>(states[i].get()), &np);
+                int blank = 0;
+                while (boards[i][blank]) ++blank;
+                int expect_nb = expect - (blank % cols) - (blank / cols);
+                if (with_blank.score(ptrs[i]) != expect || out[i] != expect || without_blank.score(ptrs[i]) != expect_nb){
+                    if (failures++ < 10){
+                        printf("  MISMATCH %s board %d: expected %d/%d got %d/%d/%d\n", name, i, expect, expect_nb,
+                               with_blank.score(ptrs[i]), out[i], without_blank.score(ptrs[i]));
+                    }
+                }
+            }
+
+            double ns_single = Bench::time_ns(reps, count, [&](){
+                for (const uint8_t* b: ptrs) sink += without_blank.score(b);
+            });
+            double ns_batch = Bench::time_ns(reps, count, [&](){
+                without_blank.score_batch(ptrs.data(), ptrs.size(), out.data());
+                sink += out[0];
+            });
+            printf("  %-10s %8.2f ns/board  batch %8.2f ns/board\n", name, ns_single, ns_batch);
+        }
+        // Compile-time board for comparison where we have an instantiation
+        if (rows == cols && rows >= 3 && rows <= 5){
+            double ns_fixed = 0.0;
+            if (rows == 3){
+                std::vector<FixedTileState<3,3>> fs;
+                for (std::shared_ptr<State>& s: states) fs.push_back(FixedTileState<3,3>(*dynamic_cast<TileState*>(s.get())));
+                ns_fixed = Bench::time_ns(reps, count, [&](){ for (auto& f: fs) sink += FixedNPuzzle<3,3>::manhattan(f); });
+            }
+            else if (rows == 4){
+                std::vector<FixedTileState<4,4>> fs;
+                for (std::shared_ptr<State>& s: states) fs.push_back(FixedTileState<4,4>(*dynamic_cast<TileState*>(s.get())));
+                ns_fixed = Bench::time_ns(reps, count, [&](){ for (auto& f: fs) sink += FixedNPuzzle<4,4>::manhattan(f); });
+            }
+            else{
+                std::vector<FixedTileState<5,5>> fs;
+                for (std::shared_ptr<State>& s: states) fs.push_back(FixedTileState<5,5>(*dynamic_cast<TileState*>(s.get())));
+                ns_fixed = Bench::time_ns(reps, count, [&](){ for (auto& f: fs) sink += FixedNPuzzle<5,5>::manhattan(f); });
+            }
+            printf("  %-10s %8.2f ns/board\n", "fixed", ns_fixed);
+        }
+    }
+    if (failures){
+        printf("\n%d mismatches\n", failures);
+        return 1;
+    }
+    printf("\nAll kernels match NPuzzleHeuristic\n");
+    return 0;
+}
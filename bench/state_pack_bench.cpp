@@ -0,0 +1,162 @@
+#include "Bench.h"
+#include "../src/game/Sokoban.h"
+#include "../src/game/SokobanLevel.h"
+#include "../src/game/NPuzzle.h"
+#include "../src/game/FixedNPuzzle.h"
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstring>
+
+// Round-trips random states of every Sokoban level and NPuzzle size through
+// Game::pack / Game::unpack, then times both (ns per state) against the
+// states' in-memory footprint. Exits non-zero if any round trip fails.
+
+int help(){
+    printf("Usage: ./state_pack_bench [-b: states per game] [-r: repetitions] [-s: seed] [level paths...]\n");
+    return 1;
+}
+
+struct PackResult{
+    size_t states, bytes, footprint;
+    int failures;
+    double pack_ns, unpack_ns;
+};
+
+static PackResult run(Game* g, const std::vector<std::shared_ptr<State>>& states, int reps){
+    PackResult res = {states.size(), g->max_packed_size(), 0, 0, 0, 0};
+    size_t n = res.bytes;
+    std::vector<uint8_t> buf(n*states.size()), again(n);
+    // Round trip: unpack(pack(s)) == s and pack(unpack(b)) == b
+    for (size_t i=0;i<states.size();++i){
+        res.footprint += states[i]->footprint();
+        uint8_t* b = buf.data() + i*n;
+        if (g->pack(states[i].get(), b) != n){
+            ++res.failures;
+            continue;
+        }
+        std::shared_ptr<State> s = g->unpack(b, n);
+        if (!s || *s != *states[i] || g->pack(s.get(), again.data()) != n || memcmp(b, again.data(), n)){
+            ++res.failures;
+        }
+    }
+    // Corrupted buffers must be rejected rather than crash
+    std::vector<uint8_t> junk(n, 0xFF);
+    if (g->unpack(junk.data(), n) || g->unpack(buf.data(), n ? n-1 : 0)) ++res.failures;
+
+    volatile size_t sink = 0;
+    res.pack_ns = Bench::time_ns(reps, states.size(), [&](){
+        for (size_t i=0;i<states.size();++i) sink += g->pack(states[i].get(), buf.data() + i*n);
+    });
+    res.unpack_ns = Bench::time_ns(reps, states.size(), [&](){
+        for (size_t i=0;i<states.size();++i) sink += (size_t)g->unpack(buf.data() + i*n, n).get();
+    });
+    return res;
+}
+
+static void report(const std::string& name, const PackResult& r){
+    printf("%-24s %8zu states %5zu B/state %8zu B footprint %9.1f ns pack %9.1f ns unpack %s\n",
+           name.c_str(), r.states, r.bytes, r.states ? r.footprint/r.states : 0, r.pack_ns, r.unpack_ns,
+           r.failures ? "FAILED" : "ok");
+}
+
+int main(int argc, char* argv[]){
+    int count = 2000;
+    int reps = 5;
+    unsigned seed = 23;
+    int c;
+    while((c = getopt(argc, argv, "b:r:s:")) != -1){
+        switch(c){
+            case 'b':
+                count = std::atoi(optarg);
+                break;
+            case 'r':
+                reps = std::atoi(optarg);
+                break;
+            case 's':
+                seed = std::atoi(optarg);
+                break;
+            case '?':
+                return help();
+        }
+    }
+    std::vector<std::string> paths;
+    for (int i=optind;i<argc;++i) paths.push_back(argv[i]);
+    if (paths.empty()) paths.push_back("sokoban_61kids/Dimitri-Yorick.txt");
+
+    std::mt19937 rng(seed);
+    int failures = 0;
+
+    // NPuzzle (runtime and compile-time boards share one encoding)
+    int dims[][2] = {{3,3},{4,4},{5,5}};
+    for (auto& d: dims){
+        NPuzzle np(d[0], d[1], seed);
+        np.randomize();
+        std::vector<std::shared_ptr<State>> states;
+        Bench::random_walk(&np, count, rng, states);
+        std::string name = std::to_string(d[0]) + "x" + std::to_string(d[1]);
+        PackResult r = run(&np, states, reps);
+        report("npuzzle " + name, r);
+        failures += r.failures;
+
+        std::shared_ptr<State> start = np.get_state();
+        Game* fixed = make_fixed_npuzzle(d[0], d[1], *dynamic_cast<TileState*>(start.get()));
+        std::vector<std::shared_ptr<State>> fixed_states;
+        Bench::random_walk(fixed, count, rng, fixed_states);
+        PackResult fr = run(fixed, fixed_states, reps);
+        report("fixed " + name, fr);
+        failures += fr.failures;
+        // Bytes are interchangeable between the two
+        std::vector<uint8_t> buf(np.max_packed_size());
+        for (size_t i=0;i<fixed_states.size();++i){
+            std::shared_ptr<State> ts;
+            if (!fixed->pack(fixed_states[i].get(), buf.data()) || !(ts = np.unpack(buf.data(), buf.size()))
+                || !fixed->unpack(buf.data(), buf.size())){
+                ++failures;
+                break;
+            }
+        }
+        delete fixed;
+    }
+
+    // Sokoban levels, summed over every level
+    PackResult total = {0, 0, 0, 0, 0, 0};
+    size_t levels = 0, level_bytes = 0;
+    for (const std::string& path: paths){
+        std::vector<SokobanLevel> loaded;
+        if (SokobanLevel::load_path(path, loaded)) return 1;
+        for (SokobanLevel& level: loaded){
+            Sokoban* sokoban = level.make_game(true);
+            if (!sokoban) continue;
+            std::vector<std::shared_ptr<State>> states;
+            Bench::random_walk(sokoban, count, rng, states);
+            PackResult r = run(sokoban, states, reps);
+            if (r.failures) report("sokoban " + level._name, r);
+            total.states += r.states;
+            total.footprint += r.footprint;
+            total.failures += r.failures;
+            total.pack_ns += r.pack_ns*r.states;
+            total.unpack_ns += r.unpack_ns*r.states;
+            level_bytes += r.bytes;
+            ++levels;
+            delete sokoban;
+        }
+    }
+    if (levels){
+        total.bytes = level_bytes/levels;
+        total.pack_ns /= total.states;
+        total.unpack_ns /= total.states;
+        report("sokoban (" + std::to_string(levels) + " levels)", total);
+        failures += total.failures;
+    }
+
+    if (failures){
+        std::cerr << "(main) Error: " << failures << " round trips failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "src/game/ConnectFour.h"
+#include "src/agent/AlphaBetaAgent.h"
+#include "src/agent/ExpectimaxAgent.h"
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Connect-Four against (or between) the game-tree agents
+// X moves first. Human moves are column numbers 1-7 on stdin.
+
+int help(){
+    printf("Usage: ./connect_four [-p: alphabeta|expectimax] [-x: agent for X, if different] [-T: seconds per move] [-d: max depth] [-j: threads] [-t: table size (MB)] [-H: human plays X|O] [-m: opening moves, e.g. 4453] [-v: print every iteration]\n");
+    return 1;
+}
+
+AdversarialAgent* make_agent(const std::string& algo, ConnectFour* game){
+    if (algo == "alphabeta") return new AlphaBetaAgent(game);
+    if (algo == "expectimax") return new ExpectimaxAgent(game);
+    return nullptr;
+}
+
+int main(int argc, char* argv[]){
+    std::string algo = "alphabeta", algo_x;
+    double seconds = 1;
+    int depth = 0, threads = 1;
+    double table_mb = 16;
+    int human = -1;
+    std::string opening;
+    bool verbose = false;
+    int c;
+    while((c = getopt(argc, argv, "p:x:T:d:j:t:H:m:v")) != -1){
+        switch(c){
+            case 'p':
+                algo = optarg;
+                break;
+            case 'x':
+                algo_x = optarg;
+                break;
+            case 'T':
+                seconds = std::atof(optarg);
+                break;
+            case 'd':
+                depth = std::atoi(optarg);
+                break;
+            case 'j':
+                threads = std::atoi(optarg);
+                break;
+            case 't':
+                table_mb = std::atof(optarg);
+                break;
+            case 'H':
+                human = (optarg[0] == 'O' || optarg[0] == 'o') ? AdversarialGame::MIN_PLAYER : AdversarialGame::MAX_PLAYER;
+                break;
+            case 'm':
+                opening = optarg;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case '?':
+                return help();
+        }
+    }
+    if (algo_x.empty()) algo_x = algo;
+
+    ConnectFour game;
+    if (!game.load_moves(opening)){
+        std::cerr << "(main) Error: illegal opening <" << opening << ">" << std::endl;
+        return 1;
+    }
+    // One agent per side, so each keeps its own table
+    std::unique_ptr<AdversarialAgent> agents[2] = {
+        std::unique_ptr<AdversarialAgent>(make_agent(algo_x, &game)),
+        std::unique_ptr<AdversarialAgent>(make_agent(algo, &game))
+    };
+    if (!agents[0] || !agents[1]) return help();
+    SolveOptions options;
+    options.time_limit_ms = seconds*1000.0;
+    options.verbose = verbose;
+    for (std::unique_ptr<AdversarialAgent>& a: agents){
+        a->set_options(options);
+        a->set_threads(threads);
+        if (depth > 0) a->set_max_depth(depth);
+        a->set_table_size(table_mb*(1 << 20));
+    }
+
+    std::cout << game;
+    for (;;){
+        std::shared_ptr<State> s = game.get_state();
+        if (game.is_terminal(s.get())) break;
+        int side = game.to_move(s.get());
+        if (side == human){
+            std::cout << (side ? 'O' : 'X') << " to move (1-7): ";
+            std::string line;
+            if (!std::getline(std::cin, line)) return 0;
+            std::shared_ptr<Action> a = game.to_action(s.get(), std::atoi(line.c_str()) - 1);
+            if (game.play(a.get())) std::cout << "Illegal move" << std::endl;
+        }
+        else{
+            std::vector<std::shared_ptr<Action>> va;
+            int code = agents[side]->solve(va);
+            if (code != Agent::SOLVE_STATUS::SOLVED){
+                std::cerr << "(main) Error: agent returned " << Agent::status_name(code) << std::endl;
+                return 1;
+            }
+            std::cout << (side ? 'O' : 'X') << " plays " << va[0]->_name << " (value " << agents[side]->get_value()
+                      << ", depth " << agents[side]->get_depth() << ", " << agents[side]->get_nodes() << " nodes)" << std::endl;
+            game.play(va[0].get());
+        }
+        std::cout << game;
+    }
+    std::shared_ptr<State> end = game.get_state();
+    int x = game.evaluate(end.get(), AdversarialGame::MAX_PLAYER);
+    std::cout << (x > 0 ? "X wins" : x < 0 ? "O wins" : "Draw") << std::endl;
+    return 0;
+}
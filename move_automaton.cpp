@@ -0,0 +1,129 @@
+#include "src/game/NPuzzle.h"
+#include "src/game/Sokoban.h"
+#include "src/game/SokobanLevel.h"
+#include "src/agent/MoveAutomaton.h"
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+
+int help(){
+    printf("Usage: ./move_automaton -o <automaton file> [-g: npuzzle|sokoban] [-n: n*n dims] [-f: sokoban level file] [-L: longest sequence] [-N: states per root] [-r: roots] [-s: check samples] [-w: random walk length] [-S: seed] [-v: print patterns]\n");
+    return 1;
+}
+
+int main(int argc, char* argv[]){
+
+    std::string game_name = "npuzzle";
+    int dims = 4;
+    char* level_file = nullptr;
+    char* out_file = nullptr;
+    int max_len = 0;
+    size_t max_nodes = 1000000;
+    int roots = 4, samples = 64, walk = 100;
+    unsigned int seed = 23;
+    bool verbose = false;
+    int c;
+    while((c = getopt(argc, argv, "o:g:n:f:L:N:r:s:w:S:v")) != -1){
+        switch(c){
+            case 'o':
+                out_file = optarg;
+                break;
+            case 'g':
+                game_name = optarg;
+                break;
+            case 'n':
+                dims = std::atoi(optarg);
+                break;
+            case 'f':
+                level_file = optarg;
+                break;
+            case 'L':
+                max_len = std::atoi(optarg);
+                break;
+            case 'N':
+                max_nodes = std::atoll(optarg);
+                break;
+            case 'r':
+                roots = std::atoi(optarg);
+                break;
+            case 's':
+                samples = std::atoi(optarg);
+                break;
+            case 'w':
+                walk = std::atoi(optarg);
+                break;
+            case 'S':
+                seed = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case '?':
+                return help();
+        }
+    }
+    if (!out_file) return help();
+
+    // Codes are blank directions for NPuzzle and box pushes for one Sokoban level
+    Game* game = nullptr;
+    if (game_name == "npuzzle"){
+        game = new NPuzzle(dims, dims);
+        if (!max_len) max_len = 12;
+    }
+    else if (game_name == "sokoban"){
+        if (!level_file) return help();
+        SokobanLevel level;
+        if (SokobanLevel::load_file(level_file, level)) return 1;
+        game = level.make_game(true);
+        if (!game){
+            std::cerr << "(main) Error: <" << level_file << "> is not a valid level" << std::endl;
+            return 1;
+        }
+        if (!max_len) max_len = 3;
+    }
+    else return help();
+
+    // Roots and check states are random walks from the start
+    std::shared_ptr<State> start = game->get_state();
+    std::vector<std::shared_ptr<State>> root_states, sample_states;
+    root_states.push_back(start);
+    MoveAutomaton::random_states(game, start, roots - 1, walk, seed, root_states);
+    MoveAutomaton::random_states(game, start, samples, walk, seed + 1, sample_states);
+
+    printf("Learning duplicate move sequences: %s, %d action codes\n", game_name.c_str(), game->action_codes());
+    printf("Up to %d moves from %d roots (%zu states each), checked from %d samples\n\n", max_len, roots, max_nodes, samples);
+    MoveAutomaton fsm;
+    MoveAutomaton::LearnStats stats;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    int run_code = MoveAutomaton::learn(game, root_states, sample_states, max_len, max_nodes, fsm, stats);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    delete game;
+    if (run_code){
+        std::cerr << "(main) Error: learning failed with: " << run_code << std::endl;
+        return run_code;
+    }
+
+    // Patterns by length
+    std::vector<int> by_len(max_len + 1, 0);
+    for (const std::vector<int>& p: fsm.get_patterns()){
+        if ((int)p.size() <= max_len) by_len[p.size()]++;
+        if (verbose){
+            for (size_t i=0;i<p.size();++i) std::cout << (i ? " " : "") << p[i];
+            std::cout << std::endl;
+        }
+    }
+    std::cout << "length patterns" << std::endl;
+    for (int l=1;l<=max_len;++l){
+        if (by_len[l]) std::cout << l << " " << by_len[l] << std::endl;
+    }
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+    std::cout << "States explored: " << stats.sequences << " (depth " << stats.depth << (stats.truncated ? ", truncated" : "") << ")" << std::endl;
+    std::cout << "Duplicates: " << stats.duplicates << ", " << stats.rejected << " disproved by samples" << std::endl;
+    std::cout << "Automaton: " << stats.patterns << " patterns, " << fsm.states() << " states, " << fsm.memory_bytes() << " bytes" << std::endl;
+    std::cout << "Took " << ms << " milliseconds" << std::endl;
+    if (game_name == "sokoban") std::cerr << "(main) Warning: Sokoban patterns are only checked on sample states, sokoban_test needs -U to use them" << std::endl;
+    return fsm.save(out_file);
+}
@@ -0,0 +1,88 @@
+#include "src/game/NPuzzle.h"
+#include "src/game/NPuzzleCorpus.h"
+#include <getopt.h>
+#include <iostream>
+#include <string>
+
+int help(){
+    printf("Usage: ./npuzzle_corpus -o <corpus file> [-n: n*n dims] [-x: dim_x] [-y: dim_y] [-k: instances] [-S: seed] [-v: print boards]\n");
+    return 1;
+}
+
+int main(int argc, char* argv[]){
+
+    // Parse argument on dimension of NPuzzle
+    int dim_x = 4; int dim_y = 4;
+    int count = 100;
+    unsigned int seed = 23;
+    bool verbose = false;
+    int c, d;
+    char* out_file = nullptr;
+    while((c = getopt(argc, argv, "x:y:n:k:S:o:v")) != -1){
+        switch(c){
+            case 'n':
+                d = std::atoi(optarg);
+                dim_x = d;
+                dim_y = d;
+                break;
+            case 'x':
+                dim_x = std::atoi(optarg);
+                break;
+            case 'y':
+                dim_y = std::atoi(optarg);
+                break;
+            case 'k':
+                count = std::atoi(optarg);
+                break;
+            case 'S':
+                seed = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'o':
+                out_file = optarg;
+                break;
+            case 'v':
+                verbose = true;
+                break;
+            case '?':
+                return help();
+        }
+    }
+    if (!out_file || count < 1) return help();
+
+    printf("Generating %dx%d NPuzzle corpus:\n",dim_x,dim_y);
+    printf("Instances: %d\n",count);
+    printf("Seed: %u\n",seed);
+    printf("Corpus: %s\n",out_file);
+    std::cout << std::endl;
+
+    NPuzzle np(dim_y, dim_x, seed);
+    NPuzzleCorpus corpus;
+    corpus.generate(&np, count);
+    int run_code = corpus.save(out_file);
+    if (run_code){
+        std::cerr << "(main) Error: corpus save failed with: " << run_code << std::endl;
+        return run_code;
+    }
+
+    // Read it back and check every board survives the round trip
+    NPuzzleCorpus check;
+    if (check.load(out_file)) return 1;
+    double mean_manhattan = 0.0;
+    for (size_t i=0;i<check.size();++i){
+        std::vector<uint8_t> board = check.get(i);
+        if (board != corpus.get(i) || !NPuzzle::is_solvable(board, dim_y, dim_x)){
+            std::cerr << "(main) Error: instance " << i << " did not round trip" << std::endl;
+            return 1;
+        }
+        for (int p=0;p<(int)board.size();++p){
+            if (!board[p]) continue;
+            mean_manhattan += std::abs(board[p] % dim_x - p % dim_x) + std::abs(board[p] / dim_x - p / dim_x);
+        }
+        if (verbose){
+            for (int p=0;p<(int)board.size();++p) std::cout << (int)board[p] << (p+1 < (int)board.size() ? " " : "\n");
+        }
+    }
+    std::cout << "Wrote " << check.size() << " instances" << std::endl;
+    std::cout << "Mean Manhattan distance: " << mean_manhattan/check.size() << std::endl;
+    return 0;
+}
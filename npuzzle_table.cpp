@@ -0,0 +1,103 @@
+#include "src/game/NPuzzle.h"
+#include "src/game/NPuzzleTable.h"
+#include "src/util/Trace.h"
+#include <getopt.h>
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <thread>
+
+int help(){
+    printf("Usage: ./npuzzle_table -o <table file> [-n: n*n dims] [-x: dim_x] [-y: dim_y] [-t: threads] [-H: histogram csv] [-Z: chrome trace file]\n");
+    return 1;
+}
+
+int main(int argc, char* argv[]){
+
+    // Parse argument on dimension of NPuzzle
+    int dim_x = 3; int dim_y = 3;
+    int threads = std::thread::hardware_concurrency();
+    int c, d;
+    char* out_file = nullptr;
+    char* hist_file = nullptr;
+    char* trace_file = nullptr;
+    while((c = getopt(argc, argv, "x:y:n:t:o:H:Z:")) != -1){
+        switch(c){
+            case 'n':
+                d = std::atoi(optarg);
+                dim_x = d;
+                dim_y = d;
+                break;
+            case 'x':
+                dim_x = std::atoi(optarg);
+                break;
+            case 'y':
+                dim_y = std::atoi(optarg);
+                break;
+            case 't':
+                threads = std::atoi(optarg);
+                break;
+            case 'o':
+                out_file = optarg;
+                break;
+            case 'H':
+                hist_file = optarg;
+                break;
+            case 'Z':
+                trace_file = optarg;
+                break;
+            case '?':
+                return help();
+        }
+    }
+    if (!out_file) return help();
+    if (threads < 1) threads = 1;
+
+    printf("Enumerating %dx%d NPuzzle state space:\n",dim_x,dim_y);
+    printf("Threads: %d\n",threads);
+    printf("Table: %s\n",out_file);
+    std::cout << std::endl;
+
+    if (trace_file) Trace::enable();
+    NPuzzle* np = new NPuzzle(dim_y, dim_x);
+    std::vector<uint64_t> histogram;
+    auto start = std::chrono::high_resolution_clock::now();
+    int run_code = NPuzzleTable::generate(np, out_file, threads, histogram);
+    auto stop = std::chrono::high_resolution_clock::now();
+    delete np;
+    if (trace_file && Trace::write(trace_file)) return 1;
+    if (run_code){
+        std::cerr << "(main) Error: table generation failed with: " << run_code << std::endl;
+        return run_code;
+    }
+
+    // Distance histogram
+    uint64_t total = 0;
+    double mean = 0.0;
+    std::cout << "depth count" << std::endl;
+    for (size_t i=0;i<histogram.size();++i){
+        std::cout << i << " " << histogram[i] << std::endl;
+        total += histogram[i];
+        mean += (double)i*histogram[i];
+    }
+    long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+    std::cout << "Reachable states: " << total << std::endl;
+    std::cout << "Max depth: " << histogram.size()-1 << std::endl;
+    std::cout << "Mean depth: " << mean/total << std::endl;
+    std::cout << "Took " << ms << " milliseconds (" << (long long)(total*1000.0/std::max(1LL, ms)) << " states/s)" << std::endl;
+
+    if (hist_file){
+        std::ofstream fout(hist_file);
+        if (!fout){
+            std::cerr << "ERROR: <" << hist_file << "> cannot be written" << std::endl;
+            return 1;
+        }
+        fout << "depth,count" << std::endl;
+        for (size_t i=0;i<histogram.size();++i){
+            fout << i << "," << histogram[i] << std::endl;
+        }
+    }
+    return 0;
+}
@@ -1,6 +1,12 @@
 #include "src/game/NPuzzle.h"
+#include "src/game/NPuzzleCorpus.h"
+#include "src/game/FixedNPuzzle.h"
 #include "src/heuristic/NPuzzleHeuristic.h"
+#include "src/heuristic/FixedNPuzzleHeuristic.h"
 #include "src/agent/AstarSearchAgent.h"
+#include "src/agent/StaticAstarAgent.h"
+#include "src/agent/OptimalTableAgent.h"
+#include "src/agent/MemoryBoundedAgent.h"
 #include <getopt.h>
 #include <iostream>
 #include <memory>
@@ -10,7 +16,7 @@
 //Note: exposing shared_ptr<>.get() pointer is probably a bad design pattern...
 
 int help(){
-    printf("Usage: ./npuzzle_test -p <astar|all> [-n: n*n dims] [-x: dim_x] [-y: dim_y] [-w: weight] [-s scrambles]\n");
+    printf("Usage: ./npuzzle_test -p <astar|fixed|static|table|bounded|all> [-n: n*n dims] [-x: dim_x] [-y: dim_y] [-w: weight] [-I: full heuristic rescoring] [-s scrambles] [-r: uniform random start] [-S: seed] [-c: corpus file] [-k: corpus index] [-t: table file] [-m: bounded memory (MB)] [-G: astar hash diagnostics] [-X: hardware counters per search phase] [-Z: chrome trace file]\n");
     return 1;
 }
 
@@ -22,7 +28,18 @@ int main(int argc, char* argv[]){
     double weight = 1;
     int c, d;
     std::string algo = "None";
-    while((c = getopt(argc, argv, "s:x:y:n:w:p:")) != -1){
+    bool incremental = true;
+    bool hash_diagnostics = false;
+    bool perf_counters = false;
+    PerfCounters perf;
+    char* table_file = nullptr;
+    bool random_start = false;
+    unsigned int seed = 23;
+    char* corpus_file = nullptr;
+    int corpus_index = -1;
+    double bound_mb = 0;
+    std::string trace_file;
+    while((c = getopt(argc, argv, "s:x:y:n:w:p:t:IrS:c:k:m:GXZ:")) != -1){
         switch(c){
             case 'n':
                 d = std::atoi(optarg);
@@ -44,6 +61,36 @@ int main(int argc, char* argv[]){
             case 'p':
                 algo = std::string(optarg);
                 break;
+            case 'I':
+                incremental = false;
+                break;
+            case 'G':
+                hash_diagnostics = true;
+                break;
+            case 'X':
+                perf_counters = true;
+                break;
+            case 'Z':
+                trace_file = optarg;
+                break;
+            case 't':
+                table_file = optarg;
+                break;
+            case 'r':
+                random_start = true;
+                break;
+            case 'S':
+                seed = std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'c':
+                corpus_file = optarg;
+                break;
+            case 'k':
+                corpus_index = std::atoi(optarg);
+                break;
+            case 'm':
+                bound_mb = std::atof(optarg);
+                break;
             case '?':
                 if (optopt == 'n')
                 fprintf (stderr, "Option -%c requires an argument.\n", optopt);
@@ -52,18 +99,54 @@ int main(int argc, char* argv[]){
     }
     
     // Check if we have agent (save us some startup time)
-    if (algo.compare("all") && algo.compare("astar") && algo.compare("all")){
+    if (algo.compare("all") && algo.compare("astar") && algo.compare("fixed") && algo.compare("static") && algo.compare("table") && algo.compare("bounded")){
         return help();
     }
 
+    // Benchmark corpus fixes the board dimensions
+    NPuzzleCorpus corpus;
+    std::vector<std::vector<uint8_t>> instances;
+    if (corpus_file){
+        if (corpus.load(corpus_file)) return 1;
+        pii dims = corpus.get_dims();
+        dim_x = dims.first;
+        dim_y = dims.second;
+        if (corpus_index >= (int)corpus.size()){
+            std::cerr << "ERROR: corpus has only " << corpus.size() << " instances" << std::endl;
+            return 1;
+        }
+        for (size_t i=0;i<corpus.size();++i){
+            if (corpus_index < 0 || (int)i == corpus_index) instances.push_back(corpus.get(i));
+        }
+    }
+
     // Debug chosen parameters:
     printf("Running %dx%d NPuzzle Test:\n",dim_x,dim_y);
-    printf("Scrambles: %d\n",scramble_num);
+    if (corpus_file) printf("Corpus: %s (%zu instances)\n",corpus_file,instances.size());
+    else if (random_start) printf("Start: uniform random\n");
+    else printf("Scrambles: %d\n",scramble_num);
+    printf("Seed: %u\n",seed);
     printf("Weight: %.3lf\n",weight);
     printf("Algo: %s\n",algo.c_str());
+    if (table_file) printf("Table: %s\n",table_file);
     std::cout << std::endl;
 
-    NPuzzle* np = new NPuzzle(dim_y, dim_x);
+    if (!trace_file.empty()){
+        Trace::enable();
+        Trace::set_thread_name("main");
+    }
+
+    // Complete distance table (only needed by the table agent)
+    NPuzzleTable table;
+    if (table_file && !table.open(table_file)){
+        return 1;
+    }
+    if (algo.compare("table") == 0 && !table.is_open()){
+        std::cerr << "ERROR: -p table requires a table file (-t)" << std::endl;
+        return help();
+    }
+
+    NPuzzle* np = new NPuzzle(dim_y, dim_x, seed);
     std::shared_ptr<State> goal = np->get_goal_state();
 
     if (!goal.get()){
@@ -72,63 +155,136 @@ int main(int argc, char* argv[]){
     }
     std::cout << goal.get();
     std::cout << "This is the goal state: " << np->is_goal_state(goal.get()) << " (should be 1)" << std::endl;
-    
-    np->scramble(scramble_num);
 
-    Heuristic* np_heu = new NPuzzleHeuristic();
-    std::vector<Heuristic*> hs = {np_heu};
-
-    // Start our search agent (initialize with problem & heuristic)
-    // Spawn search agents based on input string
-    std::vector<Agent*> agents;
-    if (algo.compare("all") == 0){
-        Agent* astar_search = new AstarSearchAgent(np, np_heu, weight);
-        agents.push_back(astar_search);
+    // Without a corpus we run the single scrambled (or random) start
+    if (instances.empty()){
+        if (random_start) np->randomize();
+        else np->scramble(scramble_num);
+        std::vector<uint8_t> board;
+        std::shared_ptr<State> start = np->get_state();
+        NPuzzle::get_board(dynamic_cast<TileState*>(start.get()), board);
+        instances.push_back(board);
     }
-    else if (algo.compare("astar") == 0){
-        Agent* astar_search = new AstarSearchAgent(np, np_heu, weight);
-        agents.push_back(astar_search);
-    }
-    else{
+
+    Heuristic* np_heu = new NPuzzleHeuristic();
+    Heuristic* fixed_heu = make_fixed_npuzzle_heuristic(dim_y, dim_x);
+    if ((algo.compare("fixed") == 0 || algo.compare("static") == 0) && !fixed_heu){
+        std::cerr << "ERROR: -p fixed and -p static support 3x3, 4x4 and 5x5 boards only" << std::endl;
         return help();
     }
+
+    // Totals per agent over all instances
+    std::vector<std::string> names;
+    std::vector<long long> total_moves, total_ms;
     int status = 0;
-    for(int i = 0; i<agents.size(); i++){
-        std::shared_ptr<State> current_state = np->get_state();
-        std::cout << std::endl << "Original problem start state after scrambling:" << std::endl;
-        std::cout << np;
-        std::cout << "This is the goal state: " << np->is_goal_state(current_state.get()) << " (should be 0)" << std::endl;
-        // Solve our puzzle (hopefully)
-        std::vector<std::shared_ptr<Action>> ans;
-        auto start = std::chrono::high_resolution_clock::now();
-        int run_code = agents[i]->solve(ans);
-        auto stop = std::chrono::high_resolution_clock::now();
-
-        if (run_code){
-            std::cerr << "(main) Error: solver threw error code: " << run_code << std::endl;
-            status = run_code;
+    for (size_t k=0;k<instances.size() && !status;++k){
+        if (!np->set_board(instances[k])){
+            status = 1;
             break;
         }
+        if (instances.size() > 1) std::cout << std::endl << "Instance " << k << ":" << std::endl;
+
+        // Compile-time sized board (3x3, 4x4, 5x5) started from the same state
+        std::shared_ptr<State> np_start = np->get_state();
+        Game* fixed_np = make_fixed_npuzzle(dim_y, dim_x, *dynamic_cast<TileState*>(np_start.get()));
+
+        // Start our search agent (initialize with problem & heuristic)
+        // Spawn search agents based on input string
+        std::vector<Agent*> agents;
+        names.clear();
+        if (!algo.compare("all") || !algo.compare("astar")){
+            AstarSearchAgent* astar_search = new AstarSearchAgent(np, np_heu, weight);
+            astar_search->set_incremental(incremental);
+            astar_search->set_hash_diagnostics(hash_diagnostics);
+            agents.push_back(astar_search);
+            names.push_back("astar");
+        }
+        if (fixed_np && (!algo.compare("all") || !algo.compare("fixed"))){
+            AstarSearchAgent* fixed_search = new AstarSearchAgent(fixed_np, fixed_heu, weight);
+            fixed_search->set_incremental(incremental);
+            fixed_search->set_hash_diagnostics(hash_diagnostics);
+            agents.push_back(fixed_search);
+            names.push_back("fixed");
+        }
+        if (fixed_np && (!algo.compare("all") || !algo.compare("static"))){
+            agents.push_back(make_static_astar(fixed_np, weight));
+            names.push_back("static");
+        }
+        if (table.is_open() && (!algo.compare("all") || !algo.compare("table"))){
+            Agent* table_search = new OptimalTableAgent(np, &table);
+            agents.push_back(table_search);
+            names.push_back("table");
+        }
+        if (!algo.compare("all") || !algo.compare("bounded")){
+            MemoryBoundedAgent* bounded = new MemoryBoundedAgent(np, np_heu, weight);
+            bounded->set_incremental(incremental);
+            bounded->set_memory_bound((size_t)(bound_mb*1024*1024));
+            agents.push_back(bounded);
+            names.push_back("bounded");
+        }
+        total_moves.resize(agents.size(), 0);
+        total_ms.resize(agents.size(), 0);
 
-        // Print solution
-        NPuzzle copy(*np);
-        for (std::shared_ptr<Action> a: ans){
-            copy.play(a.get());
+        for(int i = 0; i<agents.size(); i++){
+            std::shared_ptr<State> current_state = np->get_state();
+            std::cout << std::endl << "Original problem start state after scrambling:" << std::endl;
+            std::cout << np;
+            std::cout << "This is the goal state: " << np->is_goal_state(current_state.get()) << " (should be 0)" << std::endl;
+            // Solve our puzzle (hopefully)
+            std::vector<std::shared_ptr<Action>> ans;
+            if (perf_counters){
+                SolveOptions options = agents[i]->get_options();
+                options.perf = &perf;
+                agents[i]->set_options(options);
+                perf.reset();
+            }
+            auto start = std::chrono::high_resolution_clock::now();
+            int run_code = agents[i]->solve(ans);
+            auto stop = std::chrono::high_resolution_clock::now();
+            if (perf_counters) perf.report(std::cout, agents[i]->get_stats().expanded);
+
+            if (run_code){
+                std::cerr << "(main) Error: solver threw error code: " << run_code << std::endl;
+                status = run_code;
+                break;
+            }
+
+            // Print solution
+            NPuzzle copy(*np);
+            for (std::shared_ptr<Action> a: ans){
+                copy.play(a.get());
+            }
+            long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count();
+            std::cout << "Found solution in " << ans.size() << " moves" << std::endl;
+            std::cout << "Took " << ms << " milliseconds" << std::endl;
+            current_state = copy.get_state();
+            std::cout << copy << std::endl;
+            std::cout << "This is the goal state: " << copy.is_goal_state(current_state.get()) << std::endl;
+            total_moves[i] += ans.size();
+            total_ms[i] += ms;
+        }
+
+        delete fixed_np;
+        for(int i = 0; i<agents.size(); i++){
+            delete agents[i];
         }
-        std::cout << "Found solution in " << ans.size() << " moves" << std::endl;
-        std::cout << "Took " << std::chrono::duration_cast<std::chrono::milliseconds>(stop - start).count() << " milliseconds" << std::endl;
-        current_state = copy.get_state();
-        std::cout << copy << std::endl;
-        std::cout << "This is the goal state: " << copy.is_goal_state(current_state.get()) << std::endl;
     }
 
+    // Corpus summary
+    if (instances.size() > 1 && !status){
+        std::cout << std::endl << "Corpus summary (" << instances.size() << " instances):" << std::endl;
+        for (size_t i=0;i<names.size();++i){
+            std::cout << names[i] << ": " << total_moves[i] << " total moves, "
+                      << (double)total_moves[i]/instances.size() << " mean moves, "
+                      << total_ms[i] << " ms" << std::endl;
+        }
+    }
+
+    if (!trace_file.empty() && Trace::write(trace_file)) status = 1;
+
     // Cleanup
     delete np;
-    for(int i = 0; i<agents.size(); i++){
-        delete agents[i];
-    }
-    for(int i = 0; i<hs.size(); i++){
-        delete hs[i];
-    }
+    delete np_heu;
+    delete fixed_heu;
     return status;
 }
@@ -0,0 +1,215 @@
+#include "src/game/Sokoban.h"
+#include "src/game/SokobanLevel.h"
+#include "src/heuristic/SokobanHeuristic.h"
+#include "src/agent/AstarSearchAgent.h"
+#include "src/agent/PortfolioAgent.h"
+#include "src/util/WorkStealingPool.h"
+#include "src/util/Json.h"
+#include "src/util/Trace.h"
+#include <getopt.h>
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <sstream>
+
+int help(){
+    printf("Usage:  ./sokoban_batch [-o: results json] [-j: threads] [-T: seconds per level] [-M: MB per level] [-N: expansions per level] [-w: weight] [-I: full heuristic rescoring] [-W: race a portfolio of weights, e.g. 1,2,5] [-Z: chrome trace file] <level.in|collection.txt|directory> ...\n");
+    return 1;
+}
+
+// Outcome of one level
+struct LevelResult{
+    std::string status;
+    int moves, steps;
+    long long expanded, generated;
+    size_t memory_bytes;
+    double load_ms, solve_ms;
+    LevelResult():status("pending"),moves(0),steps(0),expanded(0),generated(0),memory_bytes(0),load_ms(0),solve_ms(0){}
+};
+
+int main(int argc, char* argv[]){
+
+    // Parse arguments
+    double weight = 1;
+    int threads = 0;
+    double time_limit_s = 60;
+    double memory_limit_mb = 0;
+    long long node_limit = 0;
+    bool incremental = true;
+    char* out_file = nullptr;
+    char* trace_file = nullptr;
+    std::vector<double> portfolio_weights;
+    int c;
+    while((c = getopt(argc, argv, "o:j:T:M:N:w:IW:Z:")) != -1){
+        switch(c){
+            case 'o':
+                out_file = optarg;
+                break;
+            case 'j':
+                threads = std::atoi(optarg);
+                break;
+            case 'T':
+                time_limit_s = std::atof(optarg);
+                break;
+            case 'M':
+                memory_limit_mb = std::atof(optarg);
+                break;
+            case 'N':
+                node_limit = std::atoll(optarg);
+                break;
+            case 'w':
+                weight = std::atof(optarg);
+                break;
+            case 'I':
+                incremental = false;
+                break;
+            case 'Z':
+                trace_file = optarg;
+                break;
+            case 'W':{
+                std::istringstream iss(optarg);
+                std::string item;
+                while (getline(iss, item, ',')){
+                    if (!item.empty()) portfolio_weights.push_back(std::atof(item.c_str()));
+                }
+                break;
+            }
+            case '?':
+                return help();
+        }
+    }
+    if (optind >= argc) return help();
+    if (trace_file){
+        Trace::enable();
+        Trace::set_thread_name("main");
+    }
+
+    // Load the whole corpus up front
+    std::vector<SokobanLevel> levels;
+    for (int i=optind;i<argc;++i){
+        int load_code = SokobanLevel::load_path(argv[i], levels);
+        if (load_code) return load_code;
+    }
+
+    WorkStealingPool pool(threads);
+    std::cerr << "Solving " << levels.size() << " levels on " << pool.size() << " threads" << std::endl;
+
+    SolveOptions options;
+    options.time_limit_ms = time_limit_s*1000.0;
+    options.memory_limit_bytes = (size_t)(memory_limit_mb*1024*1024);
+    options.node_limit = node_limit;
+    options.verbose = false;
+
+    // Heuristic is stateless and shared by every search
+    SokobanHeuristic sokoban_heu;
+    std::vector<LevelResult> results(levels.size());
+    std::mutex print_lock;
+    int done = 0;
+
+    auto wall_start = std::chrono::high_resolution_clock::now();
+    for (size_t i=0;i<levels.size();++i){
+        pool.submit([&, i](){
+            typedef std::chrono::high_resolution_clock clock;
+            Trace::Scope trace("level", "batch", levels[i]._name);
+            LevelResult& res = results[i];
+            // Level preprocessing (all-pairs BFS) runs on the worker too
+            clock::time_point load_start = clock::now();
+            std::unique_ptr<Sokoban> sokoban(levels[i].make_game(true));
+            res.load_ms = std::chrono::duration<double, std::milli>(clock::now() - load_start).count();
+            if (!sokoban){
+                res.status = "invalid";
+            }
+            else{
+                std::unique_ptr<Agent> agent;
+                if (portfolio_weights.empty()){
+                    AstarSearchAgent* astar_search = new AstarSearchAgent(sokoban.get(), &sokoban_heu, weight);
+                    astar_search->set_incremental(incremental);
+                    agent.reset(astar_search);
+                }
+                else{
+                    PortfolioAgent* portfolio = new PortfolioAgent(sokoban.get());
+                    for (double w: portfolio_weights){
+                        AstarSearchAgent* member = new AstarSearchAgent(sokoban.get(), &sokoban_heu, w);
+                        member->set_incremental(incremental);
+                        portfolio->add(member, "astar_w" + std::to_string(w));
+                    }
+                    agent.reset(portfolio);
+                }
+                agent->set_options(options);
+                std::vector<std::shared_ptr<Action>> ans;
+                int run_code = agent->solve(ans);
+                const SearchStats& stats = agent->get_stats();
+                res.status = Agent::status_name(run_code);
+                res.expanded = stats.expanded;
+                res.generated = stats.generated;
+                res.memory_bytes = stats.memory_bytes;
+                res.solve_ms = stats.time_ms;
+                if (run_code == Agent::SOLVE_STATUS::SOLVED){
+                    // Replay to check the solution
+                    Sokoban copy(*sokoban);
+                    double tot_cost = 0.0;
+                    for (std::shared_ptr<Action> a: ans){
+                        tot_cost += a->_cost;
+                        copy.play(a.get());
+                    }
+                    std::shared_ptr<State> end_state = copy.get_state();
+                    if (!copy.is_goal_state(end_state.get())) res.status = "wrong_solution";
+                    res.moves = ans.size();
+                    res.steps = (int)tot_cost;
+                }
+            }
+            std::lock_guard<std::mutex> guard(print_lock);
+            ++done;
+            fprintf(stderr, "[%d/%zu] %s: %s (%.0f ms)\n", done, levels.size(), levels[i]._name.c_str(), res.status.c_str(), res.load_ms + res.solve_ms);
+        });
+    }
+    pool.wait();
+    double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - wall_start).count();
+
+    // Write results
+    std::ofstream fout;
+    if (out_file){
+        fout.open(out_file);
+        if (!fout){
+            std::cerr << "ERROR: cannot write <" << out_file << ">" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& os = out_file ? fout : std::cout;
+    int solved = 0;
+    int status = 0;
+    os << "{" << std::endl;
+    os << "  \"threads\": " << pool.size() << "," << std::endl;
+    os << "  \"weight\": " << weight << "," << std::endl;
+    os << "  \"time_limit_ms\": " << options.time_limit_ms << "," << std::endl;
+    os << "  \"memory_limit_bytes\": " << options.memory_limit_bytes << "," << std::endl;
+    os << "  \"node_limit\": " << options.node_limit << "," << std::endl;
+    os << "  \"levels\": [" << std::endl;
+    for (size_t i=0;i<levels.size();++i){
+        const LevelResult& res = results[i];
+        if (res.status == "solved") ++solved;
+        if (res.status == "wrong_solution" || res.status == "error") status = 1;
+        os << "    {\"name\": \"" << json_escape(levels[i]._name) << "\", \"status\": \"" << res.status
+           << "\", \"moves\": " << res.moves << ", \"steps\": " << res.steps
+           << ", \"expanded\": " << res.expanded << ", \"generated\": " << res.generated
+           << ", \"memory_bytes\": " << res.memory_bytes
+           << ", \"load_ms\": " << res.load_ms << ", \"solve_ms\": " << res.solve_ms << "}"
+           << (i+1 < levels.size() ? "," : "") << std::endl;
+    }
+    os << "  ]," << std::endl;
+    os << "  \"total\": " << levels.size() << "," << std::endl;
+    os << "  \"solved\": " << solved << "," << std::endl;
+    os << "  \"steals\": " << pool.steals() << "," << std::endl;
+    os << "  \"wall_ms\": " << wall_ms << "," << std::endl;
+    os << "  \"levels_per_min\": " << (wall_ms > 0 ? levels.size()*60000.0/wall_ms : 0.0) << std::endl;
+    os << "}" << std::endl;
+
+    std::cerr << "Solved " << solved << "/" << levels.size() << " in " << wall_ms << " ms ("
+              << (wall_ms > 0 ? levels.size()*60000.0/wall_ms : 0.0) << " levels/min)" << std::endl;
+    if (trace_file && Trace::write(trace_file)) status = 1;
+    return status;
+}
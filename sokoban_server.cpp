@@ -0,0 +1,305 @@
+#include "src/game/Sokoban.h"
+#include "src/game/SokobanLevel.h"
+#include "src/heuristic/SokobanHeuristic.h"
+#include "src/agent/AstarSearchAgent.h"
+#include "src/util/WorkStealingPool.h"
+#include "src/util/Json.h"
+#include <getopt.h>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <chrono>
+#include <mutex>
+#include <atomic>
+#include <list>
+#include <thread>
+#include <string>
+#include <unordered_map>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// Long-running solver: one process, many levels
+//
+// Every message (both directions) is a 4-byte little-endian payload length
+// followed by the payload. A request payload is
+//     <id> <weight> <time limit ms>\n
+//     <level in .in format: "r c" line then r rows>
+// and each response is a single JSON object carrying the same id. Requests on
+// one connection are solved concurrently, so responses may arrive out of order.
+// Preprocessed games (Sokoban::load_board's BFS) are cached by board text and
+// shared read-only between searches.
+
+int help(){
+    printf("Usage:  ./sokoban_server [-u: unix socket path (default stdin/stdout)] [-j: threads] [-C: cached levels] [-I: full heuristic rescoring]\n");
+    return 1;
+}
+
+// Largest request we accept (a level is a few KB)
+static const uint32_t MAX_PAYLOAD = 1 << 20;
+
+// Read/write exactly n bytes
+// @return false on EOF or error
+static bool read_full(int fd, void* buf, size_t n){
+    char* p = (char*)buf;
+    while (n > 0){
+        ssize_t r = read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= r;
+    }
+    return true;
+}
+
+static bool write_full(int fd, const void* buf, size_t n){
+    const char* p = (const char*)buf;
+    while (n > 0){
+        ssize_t w = write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        p += w;
+        n -= w;
+    }
+    return true;
+}
+
+// One client (stdin/stdout pair or an accepted socket)
+class Connection{
+    private:
+        int _in, _out;
+        bool _owns;
+        std::mutex _write_lock;
+    public:
+        Connection(int in, int out, bool owns):_in(in),_out(out),_owns(owns){}
+        ~Connection(){
+            if (_owns) close(_in);
+        }
+        // Read one framed payload
+        // @return false on EOF, error or an oversized frame
+        bool receive(std::string& payload){
+            uint8_t len_bytes[4];
+            if (!read_full(_in, len_bytes, 4)) return false;
+            uint32_t len = len_bytes[0] | (len_bytes[1] << 8) | (len_bytes[2] << 16) | ((uint32_t)len_bytes[3] << 24);
+            if (len > MAX_PAYLOAD){
+                std::cerr << "(Connection::receive) Error: " << len << " byte request exceeds limit" << std::endl;
+                return false;
+            }
+            payload.resize(len);
+            return len == 0 || read_full(_in, &payload[0], len);
+        }
+        // Frames are written whole under a lock so concurrent responses don't interleave
+        bool send(const std::string& payload){
+            uint32_t len = payload.size();
+            uint8_t frame[4] = {(uint8_t)len, (uint8_t)(len >> 8), (uint8_t)(len >> 16), (uint8_t)(len >> 24)};
+            std::lock_guard<std::mutex> guard(_write_lock);
+            return write_full(_out, frame, 4) && write_full(_out, payload.data(), payload.size());
+        }
+};
+
+// LRU cache of preprocessed games keyed by board text
+class LevelCache{
+    private:
+        typedef std::pair<std::string, std::shared_ptr<Sokoban>> entry;
+        size_t _capacity;
+        std::list<entry> _lru;      // Most recently used at the front
+        std::unordered_map<std::string, std::list<entry>::iterator> _index;
+        std::mutex _lock;
+    public:
+        std::atomic<long long> _hits, _misses;
+        LevelCache(size_t capacity):_capacity(capacity),_hits(0),_misses(0){}
+        // Cached game for key, built from level on a miss (outside the lock)
+        // @return nullptr if the level is invalid
+        std::shared_ptr<Sokoban> get(const std::string& key, const SokobanLevel& level, bool& hit){
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                auto it = _index.find(key);
+                if (it != _index.end()){
+                    _lru.splice(_lru.begin(), _lru, it->second);
+                    hit = true;
+                    ++_hits;
+                    return it->second->second;
+                }
+            }
+            hit = false;
+            ++_misses;
+            std::shared_ptr<Sokoban> game(level.make_game(true));
+            if (!game || _capacity == 0) return game;
+            std::lock_guard<std::mutex> guard(_lock);
+            if (_index.find(key) == _index.end()){
+                _lru.push_front(entry(key, game));
+                _index[key] = _lru.begin();
+                if (_lru.size() > _capacity){
+                    _index.erase(_lru.back().first);
+                    _lru.pop_back();
+                }
+            }
+            return game;
+        }
+};
+
+// Shared server state
+struct Server{
+    WorkStealingPool* pool;
+    LevelCache* cache;
+    Heuristic* heuristic;
+    bool incremental;
+    std::atomic<long long> requests;
+};
+
+// Parse, solve and answer one request (runs on a pool worker)
+static void handle(Server& server, std::shared_ptr<Connection> conn, const std::string& payload){
+    typedef std::chrono::high_resolution_clock clock;
+    clock::time_point start = clock::now();
+    std::ostringstream os;
+    // Header line
+    size_t eol = payload.find('\n');
+    std::istringstream header(payload.substr(0, eol));
+    std::string id;
+    double weight = 1.0, time_limit_ms = 0.0;
+    header >> id >> weight >> time_limit_ms;
+    if (header.fail() || eol == std::string::npos){
+        os << "{\"id\": \"" << json_escape(id) << "\", \"status\": \"bad_request\", \"error\": \"expected '<id> <weight> <time limit ms>' header\"}";
+        conn->send(os.str());
+        return;
+    }
+    std::string board = payload.substr(eol+1);
+    std::istringstream board_in(board);
+    SokobanLevel level;
+    if (SokobanLevel::read(board_in, level)){
+        os << "{\"id\": \"" << json_escape(id) << "\", \"status\": \"bad_request\", \"error\": \"unreadable level\"}";
+        conn->send(os.str());
+        return;
+    }
+    bool hit = false;
+    std::shared_ptr<Sokoban> game = server.cache->get(board, level, hit);
+    if (!game){
+        os << "{\"id\": \"" << json_escape(id) << "\", \"status\": \"invalid\", \"cached\": false}";
+        conn->send(os.str());
+        return;
+    }
+    // Game is only read during search, so cached games are shared between requests
+    AstarSearchAgent agent(game.get(), server.heuristic, weight);
+    agent.set_incremental(server.incremental);
+    SolveOptions options;
+    options.time_limit_ms = time_limit_ms;
+    options.verbose = false;
+    agent.set_options(options);
+    std::vector<std::shared_ptr<Action>> ans;
+    int run_code = agent.solve(ans);
+    const SearchStats& stats = agent.get_stats();
+    std::string status = Agent::status_name(run_code);
+    // Replay on a copy of the start state to check the solution
+    double tot_cost = 0.0;
+    if (run_code == Agent::SOLVE_STATUS::SOLVED){
+        std::shared_ptr<State> s = game->get_state();
+        for (std::shared_ptr<Action> a: ans){
+            tot_cost += a->_cost;
+            game->play_action(s.get(), a.get());
+        }
+        if (!game->is_goal_state(s.get())) status = "wrong_solution";
+    }
+    double total_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    os << "{\"id\": \"" << json_escape(id) << "\", \"status\": \"" << status << "\", \"cached\": " << (hit ? "true" : "false")
+       << ", \"moves\": " << ans.size() << ", \"steps\": " << (int)tot_cost
+       << ", \"expanded\": " << stats.expanded << ", \"solve_ms\": " << stats.time_ms << ", \"total_ms\": " << total_ms
+       << ", \"solution\": [";
+    for (size_t i=0;i<ans.size();++i){
+        os << (i ? ", " : "") << "\"" << json_escape(ans[i]->_name) << "\"";
+    }
+    os << "]}";
+    conn->send(os.str());
+}
+
+// Read requests off a connection until EOF, solving them on the pool
+static void serve(Server& server, std::shared_ptr<Connection> conn){
+    std::string payload;
+    while (conn->receive(payload)){
+        ++server.requests;
+        server.pool->submit([&server, conn, payload](){
+            handle(server, conn, payload);
+        });
+    }
+}
+
+int main(int argc, char* argv[]){
+
+    // Parse arguments
+    char* socket_path = nullptr;
+    int threads = 0;
+    int capacity = 256;
+    bool incremental = true;
+    int c;
+    while((c = getopt(argc, argv, "u:j:C:I")) != -1){
+        switch(c){
+            case 'u':
+                socket_path = optarg;
+                break;
+            case 'j':
+                threads = std::atoi(optarg);
+                break;
+            case 'C':
+                capacity = std::atoi(optarg);
+                break;
+            case 'I':
+                incremental = false;
+                break;
+            case '?':
+                return help();
+        }
+    }
+    // A client hanging up mid-response must not kill the server
+    signal(SIGPIPE, SIG_IGN);
+
+    WorkStealingPool pool(threads);
+    LevelCache cache(capacity < 0 ? 0 : capacity);
+    SokobanHeuristic sokoban_heu;
+    Server server;
+    server.pool = &pool;
+    server.cache = &cache;
+    server.heuristic = &sokoban_heu;
+    server.incremental = incremental;
+    server.requests = 0;
+
+    if (!socket_path){
+        // Single client on stdin/stdout, exit once it closes stdin and we've answered everything
+        std::cerr << "sokoban_server: serving stdin on " << pool.size() << " threads" << std::endl;
+        serve(server, std::make_shared<Connection>(STDIN_FILENO, STDOUT_FILENO, false));
+        pool.wait();
+    }
+    else{
+        int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        struct sockaddr_un addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (listen_fd < 0 || strlen(socket_path) >= sizeof(addr.sun_path)){
+            std::cerr << "ERROR: cannot create socket <" << socket_path << ">" << std::endl;
+            return 1;
+        }
+        strncpy(addr.sun_path, socket_path, sizeof(addr.sun_path)-1);
+        unlink(socket_path);
+        if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(listen_fd, 64)){
+            std::cerr << "ERROR: cannot listen on <" << socket_path << ">: " << strerror(errno) << std::endl;
+            return 1;
+        }
+        std::cerr << "sokoban_server: listening on " << socket_path << " with " << pool.size() << " threads" << std::endl;
+        // One reader thread per client, solving happens on the pool
+        while (true){
+            int fd = accept(listen_fd, nullptr, nullptr);
+            if (fd < 0){
+                if (errno == EINTR) continue;
+                break;
+            }
+            std::shared_ptr<Connection> conn = std::make_shared<Connection>(fd, fd, true);
+            std::thread([&server, conn](){ serve(server, conn); }).detach();
+        }
+        close(listen_fd);
+        unlink(socket_path);
+        pool.wait();
+    }
+    std::cerr << "sokoban_server: " << server.requests << " requests, " << cache._hits << " cache hits, " << cache._misses << " misses" << std::endl;
+    return 0;
+}
@@ -1,23 +1,52 @@
 #include "src/game/Sokoban.h"
+#include "src/game/SokobanLevel.h"
 #include "src/heuristic/SokobanHeuristic.h"
 #include "src/agent/AstarSearchAgent.h"
+#include "src/agent/StaticAstarAgent.h"
+#include "src/agent/PortfolioAgent.h"
+#include "src/agent/ExternalAstarAgent.h"
+#include "src/agent/MemoryBoundedAgent.h"
+#include "src/agent/GreedyAgent.h"
+#include "src/agent/BeamAgent.h"
+#include "src/agent/DepthFirstAgent.h"
+#include "src/agent/BidirectionalAgent.h"
+#include "src/agent/MCTSAgent.h"
+#include "src/agent/MoveAutomaton.h"
 #include <getopt.h>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <memory>
 #include <chrono>
 #include <string>
+#include <sstream>
+#include <csignal>
+#include <atomic>
 
 #define SOK_DB_LIM 254        // Number of patterns to generate
 
 //Note: exposing shared_ptr<>.get() pointer is probably a bad design pattern...
 
 int help(){
-    printf("Usage:  ./sokoban_test -p <astar|all> [-f: level file]\n");
+    printf("Usage:  ./sokoban_test -p <astar|static|portfolio|external|bounded|greedy|beam|dfs|bidir|mcts|all> [-f: level file] [-w: weight] [-I: full heuristic rescoring] [-T: time limit (s)] [-N: node limit] [-M: memory limit (MB)] [-W: portfolio weights, e.g. 1,2,5] [-B: portfolio keeps best solution by the time limit] [-C: astar checkpoint file] [-K: checkpoint interval (s)] [-R: resume astar from checkpoint] [-D: external bucket directory] [-E: external sort memory (MB)] [-m: bounded memory (MB)] [-H: bitstate closed set (MB)] [-k: bitstate hashes] [-b: beam width] [-d: dfs depth limit] [-t: dfs tree search (iterative deepening, no closed set)] [-F: dfs move automaton file, with -t or -H] [-U: accept -F although Sokoban patterns are only checked on sample states] [-X: hardware counters per search phase] [-Z: chrome trace file] [-G: astar hash diagnostics] [-P: heuristic threads for batch scoring (only astar scores in batches)] [-j: mcts threads] [-r: mcts root parallelism]\n");
     return 1;
 }
 
+// Ctrl-C / SIGTERM cancel the search (astar writes its checkpoint on the way out)
+static std::atomic<bool> interrupted(false);
+static void on_signal(int){
+    interrupted = true;
+}
+
+// Comma separated list of numbers
+std::vector<double> parse_list(const std::string& s){
+    std::vector<double> v;
+    std::istringstream iss(s);
+    std::string item;
+    while (getline(iss, item, ',')){
+        if (!item.empty()) v.push_back(std::atof(item.c_str()));
+    }
+    return v;
+}
+
 int main(int argc, char* argv[]){
 
     // Parse argument for init Sokoban level
@@ -25,7 +54,30 @@ int main(int argc, char* argv[]){
     int c, d;
     char* in_file = nullptr;
     std::string algo = "None";
-    while((c = getopt(argc, argv, "f:w:p:")) != -1){
+    bool incremental = true;
+    bool hash_diagnostics = false;
+    int heuristic_threads = 0;
+    int mcts_threads = 1;
+    MCTSAgent::parallel_type mcts_parallel = MCTSAgent::TREE;
+    double time_limit_s = 0;
+    long long node_limit = 0;
+    double memory_limit_mb = 0;
+    std::vector<double> weights = {1, 2, 5};
+    PortfolioAgent::mode_type portfolio_mode = PortfolioAgent::mode_type::FIRST_SOLUTION;
+    std::string checkpoint_file, resume_file;
+    double checkpoint_interval_s = 0;
+    std::string external_dir = "/tmp";
+    double sort_memory_mb = 64;
+    double bound_mb = 0;
+    double bitstate_mb = 0;
+    int bitstate_k = 3;
+    int beam_width = 1000;
+    int depth_limit = 0;
+    std::string automaton_file;
+    bool tree_search = false, unsafe_automaton = false;
+    bool perf_counters = false;
+    std::string trace_file;
+    while((c = getopt(argc, argv, "f:w:p:IT:N:M:W:BC:K:R:D:E:m:H:k:b:d:tF:UGP:j:rXZ:")) != -1){
         switch(c){
             case 'f':
                 in_file = optarg;
@@ -36,6 +88,81 @@ int main(int argc, char* argv[]){
             case 'p':
                 algo = std::string(optarg);
                 break;
+            case 'I':
+                incremental = false;
+                break;
+            case 'G':
+                hash_diagnostics = true;
+                break;
+            case 'P':
+                heuristic_threads = std::atoi(optarg);
+                break;
+            case 'j':
+                mcts_threads = std::atoi(optarg);
+                break;
+            case 'r':
+                mcts_parallel = MCTSAgent::ROOT;
+                break;
+            case 'T':
+                time_limit_s = std::atof(optarg);
+                break;
+            case 'N':
+                node_limit = std::atoll(optarg);
+                break;
+            case 'M':
+                memory_limit_mb = std::atof(optarg);
+                break;
+            case 'W':
+                weights = parse_list(optarg);
+                break;
+            case 'B':
+                portfolio_mode = PortfolioAgent::mode_type::BEST_BY_DEADLINE;
+                break;
+            case 'C':
+                checkpoint_file = optarg;
+                break;
+            case 'K':
+                checkpoint_interval_s = std::atof(optarg);
+                break;
+            case 'R':
+                resume_file = optarg;
+                break;
+            case 'D':
+                external_dir = optarg;
+                break;
+            case 'E':
+                sort_memory_mb = std::atof(optarg);
+                break;
+            case 'm':
+                bound_mb = std::atof(optarg);
+                break;
+            case 'H':
+                bitstate_mb = std::atof(optarg);
+                break;
+            case 'k':
+                bitstate_k = std::atoi(optarg);
+                break;
+            case 'b':
+                beam_width = std::atoi(optarg);
+                break;
+            case 'd':
+                depth_limit = std::atoi(optarg);
+                break;
+            case 't':
+                tree_search = true;
+                break;
+            case 'F':
+                automaton_file = optarg;
+                break;
+            case 'U':
+                unsafe_automaton = true;
+                break;
+            case 'X':
+                perf_counters = true;
+                break;
+            case 'Z':
+                trace_file = optarg;
+                break;
             case '?':
                 if (optopt == 'n')
                 fprintf (stderr, "Option -%c requires an argument.\n", optopt);
@@ -52,131 +179,35 @@ int main(int argc, char* argv[]){
     std::cout << std::endl;
 
     // Check if we have agent (save us some startup time)
-    if (algo.compare("all") && algo.compare("astar") && algo.compare("all")){
+    if (algo.compare("all") && algo.compare("astar") && algo.compare("static") && algo.compare("portfolio") && algo.compare("external") && algo.compare("bounded")
+        && algo.compare("greedy") && algo.compare("beam") && algo.compare("dfs") && algo.compare("bidir") && algo.compare("mcts")){
         return help();
     }
 
-    // Pointer to our game
-    Sokoban* sokoban;
+    if (!trace_file.empty()){
+        Trace::enable();
+        Trace::set_thread_name("main");
+    }
 
+    // Read the level from file or console (see SokobanLevel.h for the format)
+    //IMPT! remember to add ending newline to file!!!
+    SokobanLevel level;
+    int load_code;
     if (in_file){
-        // Have input file, read game board from file
-        std::ifstream fin;
-        fin.open(in_file);
-        if (!fin){
-            std::cerr << "ERROR: <" << in_file << "> not found" << std::endl;
-            return 1;
-        }
-        // File has the following format
-        // .    : Empty cell
-        // x    : Box
-        // o    : Player starting location
-        // #    : Wall
-        // _    : Goal position for Box
-        // @    : Goal position with Box
-        //IMPT! remember to add ending newline to file!!!
-
-        // Parse file (Board Dimensions)
-        std::string line;
-        int r, c;
-        if (!getline(fin, line)){
-            std::cerr << "ERROR: Unable to read game board dimensions from file" << std::endl;
-            return 2;
-        }
-        else{
-            std::istringstream iss(line);
-            iss >> r >> c;
-            if (iss.fail()){
-                std::cerr << "ERROR: Unable to read game board dimensions from file" << std::endl;
-                return 2;
-            }
-        }
-        
-        // Create 2D char array for Sokoban init
-        char** game_board = (char**)malloc(sizeof(char*)*r);
-        for (int y=0;y<r;++y){
-            game_board[y] = (char*)malloc(sizeof(char)*c);
-        }
-        // Read into board
-        int y = 0;
-        while (!getline(fin, line).eof() && y < r){
-            std::istringstream iss(line);
-            for (int x=0;x<c;++x){
-                iss>>game_board[y][x];
-                if (iss.fail()){
-                    std::cerr << "ERROR: Unable to read game cell" << std::endl;
-                    // Cleanup
-                    for (int y=0;y<r;++y) free(game_board[y]);
-                    free(game_board);
-                    game_board = 0;
-                    return 3;
-                }
-            }
-            ++y;
-        }
-
-        // Create new sokoban game
-        sokoban = new Sokoban(r, c, game_board, true);    // Meant for Human players, no pruning
-        if (!sokoban->valid()){
-            std::cerr << "ERROR: Game Board is invalid" << std::endl;
-            // Cleanup
-            for (int y=0;y<r;++y) free(game_board[y]);
-            free(game_board);
-            game_board = 0;
-            return 4;
-        }
-
-        // Cleanup
-        for (int y=0;y<r;++y) free(game_board[y]);
-        free(game_board);
-        game_board = 0;
+        load_code = SokobanLevel::load_file(in_file, level);
     }
     else{
         // Seed by asking player to type in board
-        std::cout << "Input board dimensions (row, columns): " << std::endl;
-        int r, c;
-        std::cin >> r >> c; std::cin.ignore();
-        // Create 2D char array for Sokoban init
-        char** game_board = (char**)malloc(sizeof(char*)*r);
-        for (int y=0;y<r;++y){
-            game_board[y] = (char*)malloc(sizeof(char)*c);
-        }
-        std::string line;
-        // Read into board
-        int y = 0;
-        while (!getline(std::cin, line).eof() && y < r){
-            std::istringstream iss(line);
-            for (int x=0;x<c;++x){
-                iss>>game_board[y][x];
-                if (iss.fail()){
-                    std::cerr << "ERROR: Unable to read game cell" << std::endl;
-                    // Cleanup
-                    for (int y=0;y<r;++y) free(game_board[y]);
-                    free(game_board);
-                    game_board = 0;
-                    return 3;
-                }
-            }
-            ++y;
-        }
-
-        // Create new sokoban game
-        sokoban = new Sokoban(r, c, game_board, true);    // Meant for Human players, no pruning
-        if (!sokoban->valid()){
-            std::cerr << "ERROR: Game Board is invalid" << std::endl;
-            // Cleanup
-            for (int y=0;y<r;++y) free(game_board[y]);
-            free(game_board);
-            game_board = 0;
-            return 4;
-        }
+        std::cout << "Input board dimensions (row, columns) followed by the board: " << std::endl;
+        load_code = SokobanLevel::read(std::cin, level);
+    }
+    if (load_code) return load_code;
 
-        // Cleanup
-        for (int y=0;y<r;++y) free(game_board[y]);
-        free(game_board);
-        game_board = 0;
-        //std::cerr << "Seeding board by typing is currently not supported" << std::endl;
-        //return 5;
+    // Create new sokoban game
+    Sokoban* sokoban = level.make_game(true);
+    if (!sokoban){
+        std::cerr << "ERROR: Game Board is invalid" << std::endl;
+        return SokobanLevel::ERR_CODE::BOARD_ERROR;
     }
 
     std::cout << sokoban;
@@ -191,34 +222,137 @@ int main(int argc, char* argv[]){
     std::cout << std::endl << goal.get();
     std::cout << "This is the goal state: " << sokoban->is_goal_state(goal.get()) << " (should be 1)" << std::endl;
 
-    // Grab a puzzle heuristic class
-    Heuristic* sokoban_heu = new SokobanHeuristic();
+    // Grab a puzzle heuristic class (successor batches go over -P threads)
+    SokobanHeuristic* sokoban_heu = new SokobanHeuristic();
+    std::unique_ptr<WorkStealingPool> heuristic_pool;
+    if (heuristic_threads > 0){
+        heuristic_pool.reset(new WorkStealingPool(heuristic_threads));
+        sokoban_heu->set_pool(heuristic_pool.get());
+    }
     std::vector<Heuristic*> hs = {sokoban_heu};
 
     // Start our search agent (initialize with problem & heuristic)
     // Spawn search agents based on input string
     std::vector<Agent*> agents;
-    if (algo.compare("all") == 0){
-        Agent* astar_search = new AstarSearchAgent(sokoban, sokoban_heu, weight);
+    MoveAutomaton automaton;
+    if (algo.compare("all") == 0 || algo.compare("astar") == 0){
+        AstarSearchAgent* astar_search = new AstarSearchAgent(sokoban, sokoban_heu, weight);
+        astar_search->set_incremental(incremental);
+        astar_search->set_hash_diagnostics(hash_diagnostics);
+        astar_search->set_checkpoint(checkpoint_file, checkpoint_interval_s);
+        astar_search->set_resume(resume_file);
         agents.push_back(astar_search);
     }
-    else if (algo.compare("astar") == 0){
-        Agent* astar_search = new AstarSearchAgent(sokoban, sokoban_heu, weight);
-        agents.push_back(astar_search);
+    if (algo.compare("all") == 0 || algo.compare("static") == 0){
+        // Same search on value states with everything inlined
+        Agent* static_search = make_static_astar(sokoban, weight);
+        if (static_search) agents.push_back(static_search);
+        else std::cerr << "(main) Error: level too large for the static search kernel" << std::endl;
     }
-    else{
+    if (algo.compare("all") == 0 || algo.compare("portfolio") == 0){
+        // Race weighted A* configurations, first (or best) solution wins
+        PortfolioAgent* portfolio = new PortfolioAgent(sokoban, portfolio_mode);
+        for (double w: weights){
+            AstarSearchAgent* member = new AstarSearchAgent(sokoban, sokoban_heu, w);
+            member->set_incremental(incremental);
+            std::ostringstream name;
+            name << "astar_w" << w;
+            portfolio->add(member, name.str());
+        }
+        agents.push_back(portfolio);
+    }
+    if (algo.compare("all") == 0 || algo.compare("external") == 0){
+        // Open and closed lists in bucket files on disk
+        ExternalAstarAgent* external = new ExternalAstarAgent(sokoban, sokoban_heu, weight);
+        external->set_incremental(incremental);
+        external->set_temp_dir(external_dir);
+        external->set_sort_memory((size_t)(sort_memory_mb*1024*1024));
+        agents.push_back(external);
+    }
+    if (algo.compare("all") == 0 || algo.compare("bounded") == 0){
+        // Sheds nodes past -m (or half of -M) instead of running out of memory
+        MemoryBoundedAgent* bounded = new MemoryBoundedAgent(sokoban, sokoban_heu, weight);
+        bounded->set_incremental(incremental);
+        bounded->set_memory_bound((size_t)(bound_mb*1024*1024));
+        agents.push_back(bounded);
+    }
+    // Satisficing agents, each with its own closed set (bitstate with -H)
+    std::vector<ClosedSet*> closed_sets;
+    auto make_closed = [&](){
+        ClosedSet* cs = nullptr;
+        if (bitstate_mb > 0) cs = new BitstateClosedSet(sokoban, (size_t)(bitstate_mb*1024*1024), bitstate_k);
+        else cs = new ExactClosedSet();
+        closed_sets.push_back(cs);
+        return cs;
+    };
+    if (algo.compare("all") == 0 || algo.compare("greedy") == 0){
+        GreedyAgent* greedy = new GreedyAgent(sokoban, sokoban_heu);
+        greedy->set_incremental(incremental);
+        greedy->set_closed_set(make_closed());
+        agents.push_back(greedy);
+    }
+    if (algo.compare("all") == 0 || algo.compare("beam") == 0){
+        BeamAgent* beam = new BeamAgent(sokoban, sokoban_heu, beam_width);
+        beam->set_incremental(incremental);
+        beam->set_closed_set(make_closed());
+        agents.push_back(beam);
+    }
+    if (algo.compare("all") == 0 || algo.compare("dfs") == 0){
+        DepthFirstAgent* dfs = new DepthFirstAgent(sokoban, sokoban_heu);
+        dfs->set_incremental(incremental);
+        dfs->set_depth_limit(depth_limit);
+        dfs->set_tree_search(tree_search);
+        if (!tree_search) dfs->set_closed_set(make_closed());
+        // Learned offline by ./move_automaton -g sokoban on the same level
+        if (!automaton_file.empty()){
+            if (!unsafe_automaton){
+                std::cerr << "(main) Error: Sokoban move automata are only checked on sample states and can prune a level's only solution, pass -U to use one anyway" << std::endl;
+                return 1;
+            }
+            std::cerr << "(main) Warning: searching with an unverified Sokoban move automaton, a failed search does not mean the level is unsolvable" << std::endl;
+            if (automaton.load(automaton_file)) return 1;
+            dfs->set_move_automaton(&automaton);
+        }
+        agents.push_back(dfs);
+    }
+    if (algo.compare("all") == 0 || algo.compare("bidir") == 0){
+        // Push-optimal: forward pushes meet backward pulls from every goal region
+        agents.push_back(new BidirectionalAgent(sokoban));
+    }
+    if (algo.compare("all") == 0 || algo.compare("mcts") == 0){
+        // Satisficing: UCT with greedy rollouts, -j threads on one tree (or one each with -r)
+        MCTSAgent* mcts = new MCTSAgent(sokoban, sokoban_heu);
+        mcts->set_threads(mcts_threads, mcts_parallel);
+        agents.push_back(mcts);
+    }
+    if (agents.empty()){
         return help();
     }
+    SolveOptions options;
+    options.time_limit_ms = time_limit_s*1000.0;
+    options.node_limit = node_limit;
+    options.memory_limit_bytes = (size_t)(memory_limit_mb*1024*1024);
+    options.cancel = &interrupted;
+    PerfCounters perf;
+    if (perf_counters) options.perf = &perf;
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    for (Agent* a: agents) a->set_options(options);
     int status = 0;
     for(int i = 0; i<agents.size(); i++){
         // Solve our puzzle (hopefully)
         std::vector<std::shared_ptr<Action>> ans;
+        perf.reset();
         auto start = std::chrono::high_resolution_clock::now();
         int run_code = agents[i]->solve(ans);
         auto stop = std::chrono::high_resolution_clock::now();
+        if (perf_counters) perf.report(std::cout, agents[i]->get_stats().expanded);
 
         if (run_code){
-            std::cerr << "(main) Error: solver threw error code: " << run_code << std::endl;
+            std::cerr << "(main) Error: solver threw error code: " << run_code << " (" << Agent::status_name(run_code) << ")" << std::endl;
+            const SearchStats& stats = agents[i]->get_stats();
+            std::cerr << "(main) Partial search: " << stats.expanded << " expanded, " << stats.generated << " generated, "
+                      << stats.memory_bytes/1024 << " KB, " << stats.time_ms << " ms" << std::endl;
             status = run_code;
             break;
         }
@@ -237,6 +371,8 @@ int main(int argc, char* argv[]){
         std::cout << "This is the goal state: " << copy.is_goal_state(current_state.get()) << std::endl;
     }
 
+    if (!trace_file.empty() && Trace::write(trace_file)) status = 1;
+
     // Cleanup
     delete sokoban;
     for(int i = 0; i<agents.size(); i++){
@@ -245,5 +381,8 @@ int main(int argc, char* argv[]){
     for(int i = 0; i<hs.size(); i++){
         delete hs[i];
     }
+    for (ClosedSet* cs: closed_sets){
+        delete cs;
+    }
     return status;
 }
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <queue>
+#include <algorithm>
+
+// A* on value states, statically dispatched on the game and heuristic types
+// Nothing on the expansion path is virtual: states are concrete types stored by
+// value in one node array, successors come from a template callback and the
+// heuristic is called on the concrete state, so the compiler inlines all of it.
+//
+// GameT provides
+//   state_type, move_type                         copyable values
+//   bool is_goal(const state_type&) const
+//   uint64_t key_hash(const state_type&) const    equal keys must hash alike
+//   bool key_equal(const state_type&, const state_type&) const
+//   template<class F> void for_each_successor(const state_type&, F&& f) const
+//                                                 calls f(child, move, cost) per successor
+// HeuristicT provides
+//   double score(const GameT&, const state_type&) const
+//
+// Open list order and reopening follow AstarSearchAgent (lowest f, then lowest h,
+// then newest), so both expand the same states given the same successor order.
+template<class GameT, class HeuristicT>
+class AStar{
+    public:
+        typedef typename GameT::state_type state_type;
+        typedef typename GameT::move_type move_type;
+        // solve() return codes (a budget callback's nonzero code is passed through)
+        enum SEARCH_STATUS{
+            SOLVED      = 0,
+            NO_SOLUTION = -1
+        };
+    private:
+        static const uint32_t NONE = 0xffffffffu;
+        struct Node{
+            state_type _state;
+            move_type _move;        // Move into _state from _parent
+            double _g, _h;
+            long long _seq;         // Seq of the node's live open entry
+            uint32_t _parent;
+        };
+        struct OpenEntry{
+            double _f, _h;
+            long long _seq;
+            uint32_t _id;
+            // std::priority_queue pops the largest, so this is AstarSearchAgent's order reversed
+            bool operator<(const OpenEntry& o) const{
+                if (_f != o._f) return _f > o._f;
+                if (_h != o._h) return _h > o._h;
+                return _seq < o._seq;
+            }
+        };
+        struct Slot{
+            uint64_t _hash;
+            uint32_t _id;
+        };
+        const GameT& _game;
+        const HeuristicT& _heuristic;
+        double _w;
+        std::vector<Node> _nodes;
+        // Linear probing index over _nodes, at most half full
+        std::vector<Slot> _slots;
+        size_t _mask;
+        std::priority_queue<OpenEntry> _open;
+        long long _expanded, _generated, _next_seq;
+
+        // Slot holding s, or the empty slot it would go in
+        size_t find_slot(const state_type& s, uint64_t h) const{
+            size_t pos = h & _mask;
+            while (_slots[pos]._id != NONE){
+                if (_slots[pos]._hash == h && _game.key_equal(_nodes[_slots[pos]._id]._state, s)) break;
+                pos = (pos + 1) & _mask;
+            }
+            return pos;
+        }
+        void rehash(size_t n){
+            std::vector<Slot> old(n, Slot{0, NONE});
+            old.swap(_slots);
+            _mask = n - 1;
+            for (const Slot& sl: old){
+                if (sl._id == NONE) continue;
+                size_t pos = sl._hash & _mask;
+                while (_slots[pos]._id != NONE) pos = (pos + 1) & _mask;
+                _slots[pos] = sl;
+            }
+        }
+        void push_open(uint32_t id){
+            Node& n = _nodes[id];
+            n._seq = _next_seq++;
+            _open.push(OpenEntry{n._g + n._h*_w, n._h, n._seq, id});
+        }
+    public:
+        AStar(const GameT& g, const HeuristicT& h, double w=1.0)
+            :_game(g), _heuristic(h), _w(w), _mask(0), _expanded(0), _generated(0), _next_seq(0){}
+        void set_weight(double w){
+            _w = w;
+        }
+        // Search from start, moves receives the path on success
+        // budget(expanded, memory_bytes) is called before every expansion, nonzero stops the search
+        template<class Budget>
+        int solve(const state_type& start, std::vector<move_type>& moves, Budget&& budget){
+            clear();
+            rehash(1024);
+            _nodes.push_back(Node{start, move_type(), 0.0, _heuristic.score(_game, start), 0, NONE});
+            uint64_t h0 = _game.key_hash(start);
+            _slots[find_slot(start, h0)] = Slot{h0, 0};
+            push_open(0);
+            while (!_open.empty()){
+                int budget_code = budget(_expanded, memory_bytes());
+                if (budget_code) return budget_code;
+                OpenEntry e = _open.top();
+                _open.pop();
+                // Superseded by a cheaper path to the same state
+                if (e._seq != _nodes[e._id]._seq) continue;
+                if (_game.is_goal(_nodes[e._id]._state)){
+                    for (uint32_t id = e._id;_nodes[id]._parent != NONE;id = _nodes[id]._parent) moves.push_back(_nodes[id]._move);
+                    std::reverse(moves.begin(), moves.end());
+                    return SOLVED;
+                }
+                _expanded++;
+                // Copied out, _nodes grows while the successors are added
+                const uint32_t parent = e._id;
+                const state_type cur = _nodes[parent]._state;
+                const double g = _nodes[parent]._g;
+                _game.for_each_successor(cur, [&](const state_type& child, const move_type& m, double cost){
+                    _generated++;
+                    double child_g = g + cost;
+                    uint64_t h = _game.key_hash(child);
+                    size_t pos = find_slot(child, h);
+                    uint32_t id = _slots[pos]._id;
+                    if (id != NONE){
+                        // Reopen (or re-sort) on a strictly cheaper path
+                        Node& n = _nodes[id];
+                        if (child_g >= n._g) return;
+                        n._state = child;
+                        n._move = m;
+                        n._g = child_g;
+                        n._h = _heuristic.score(_game, child);
+                        n._parent = parent;
+                        push_open(id);
+                        return;
+                    }
+                    id = _nodes.size();
+                    _nodes.push_back(Node{child, m, child_g, _heuristic.score(_game, child), 0, parent});
+                    _slots[pos] = Slot{h, id};
+                    push_open(id);
+                    if (_nodes.size()*2 > _slots.size()) rehash(_slots.size()*2);
+                });
+            }
+            return NO_SOLUTION;
+        }
+        int solve(const state_type& start, std::vector<move_type>& moves){
+            return solve(start, moves, [](long long, size_t){ return 0; });
+        }
+        // Release the last search
+        void clear(){
+            std::vector<Node>().swap(_nodes);
+            std::vector<Slot>().swap(_slots);
+            std::priority_queue<OpenEntry>().swap(_open);
+            _mask = 0;
+            _expanded = _generated = _next_seq = 0;
+        }
+        long long expanded() const{return _expanded;}
+        long long generated() const{return _generated;}
+        // Distinct states seen
+        size_t size() const{return _nodes.size();}
+        // Bytes held by nodes, index and open list
+        size_t memory_bytes() const{
+            return _nodes.capacity()*sizeof(Node) + _slots.size()*sizeof(Slot) + _open.size()*sizeof(OpenEntry);
+        }
+};
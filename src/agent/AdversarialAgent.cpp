@@ -0,0 +1,148 @@
+#include "AdversarialAgent.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+AdversarialAgent::AdversarialAgent(AdversarialGame* g)
+    :Agent(g), _game(g), _threads(1), _max_depth(MAX_PLY), _stop(false), _nodes(0), _value(0), _depth(0), _best_move(-1){}
+
+AdversarialAgent::~AdversarialAgent(){
+    _game = nullptr;
+}
+
+void AdversarialAgent::set_threads(int n){
+    _threads = n > 0 ? n : std::max(1u, std::thread::hardware_concurrency());
+}
+
+void AdversarialAgent::set_max_depth(int d){
+    _max_depth = std::min(std::max(d, 1), (int)MAX_PLY);
+}
+
+void AdversarialAgent::set_table_size(size_t bytes){
+    _tt.resize(bytes);
+}
+
+int AdversarialAgent::order_moves(Worker& w, int ply, int side, int tt_move){
+    int mm = _game->max_moves();
+    int* moves = &w._moves[ply*mm];
+    int* scores = &w._scores[ply*mm];
+    int n = _game->get_moves(w._state.get(), moves);
+    const int* history = side == AdversarialGame::CHANCE ? nullptr : &w._history[side*mm];
+    for (int i=0;i<n;++i){
+        scores[i] = moves[i] == tt_move ? INT_MAX : history ? history[moves[i]] : 0;
+    }
+    // Insertion sort (few moves), stable so ties keep the game's order
+    for (int i=1;i<n;++i){
+        int m = moves[i], sc = scores[i], j = i;
+        for (;j > 0 && scores[j-1] < sc;--j){
+            moves[j] = moves[j-1];
+            scores[j] = scores[j-1];
+        }
+        moves[j] = m;
+        scores[j] = sc;
+    }
+    return n;
+}
+
+void AdversarialAgent::add_history(Worker& w, int side, int move, int depth){
+    int mm = _game->max_moves();
+    int* history = &w._history[side*mm];
+    history[move] += depth*depth;
+    if (history[move] > (1 << 24)){
+        for (int i=0;i<mm;++i) history[i] >>= 1;
+    }
+}
+
+void AdversarialAgent::deepen(Worker& w){
+    Trace::set_thread_name(std::string(name()) + " worker " + std::to_string(w._id));
+    for (int d=(w._id & 1) ? 2 : 1;d<=_max_depth;++d){
+        w._abortable = w._id != 0 || d > 1;
+        w._aborted = false;
+        w._root_move = -1;
+        uint64_t trace_start = Trace::enabled() ? Trace::now() : 0;
+        int v = search_root(w, d);
+        Trace::record(w._aborted ? "depth_aborted" : "depth", "search", trace_start, d);
+        if (w._aborted) break;
+        if (w._id) continue;
+        _value = v;
+        _depth = d;
+        _best_move = w._root_move;
+        if (_options.verbose){
+            std::cout << name() << " depth " << d << ": value " << v << ", move "
+                      << _game->to_action(w._state.get(), w._root_move)->_name << ", " << _nodes + w._nodes << " nodes" << std::endl;
+        }
+        // Proven win or loss
+        if (std::abs(v) >= AdversarialGame::WIN_BOUND) break;
+    }
+    _nodes += w._nodes;
+    w._nodes = 0;
+    if (w._id == 0) _stop = true;
+}
+
+int AdversarialAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    begin_solve();
+    _stop = false;
+    _nodes = 0;
+    _value = _depth = 0;
+    _best_move = -1;
+
+    std::shared_ptr<State> root = search_problem->get_state();
+    int mm = _game->max_moves();
+    std::vector<int> moves(mm);
+    if (_game->is_terminal(root.get()) || _game->get_moves(root.get(), moves.data()) == 0){
+        end_solve();
+        if (_options.verbose) std::cerr << "(AdversarialAgent::solve) Game is over, no move to make..." << std::endl;
+        return Agent::SOLVE_STATUS::NO_SOLUTION;
+    }
+    if (_game->to_move(root.get()) == AdversarialGame::CHANCE){
+        end_solve();
+        std::cerr << "(AdversarialAgent::solve) Error: chance is to move in the root state" << std::endl;
+        return Agent::SOLVE_STATUS::NO_SOLUTION;
+    }
+    _tt.new_search();
+    prepare(root.get());
+
+    std::vector<Worker> workers(_threads);
+    for (int i=0;i<_threads;++i){
+        Worker& w = workers[i];
+        w._id = i;
+        w._state = search_problem->get_state();
+        w._moves.assign((MAX_PLY + 1)*mm, 0);
+        w._scores.assign((MAX_PLY + 1)*mm, 0);
+        w._history.assign(2*mm, 0);
+        w._nodes = 0;
+        w._abortable = w._aborted = false;
+        w._root_move = -1;
+    }
+    std::vector<std::thread> threads;
+    for (int i=0;i<_threads;++i){
+        threads.push_back(std::thread([this, &workers, i](){
+            deepen(workers[i]);
+        }));
+    }
+
+    // Budgets are checked here, workers only watch _stop (the main worker sets
+    // it when it is done deepening)
+    int code = Agent::SOLVE_STATUS::SOLVED;
+    while (!_stop){
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        code = check_budget(_nodes, _tt.bytes(), true);
+        if (code) break;
+    }
+    _stop = true;
+    for (std::thread& th: threads) th.join();
+    check_budget(_nodes, _tt.bytes(), true);
+    end_solve();
+    _stats.generated = _nodes;
+
+    if (code == Agent::SOLVE_STATUS::CANCELLED) return code;
+    if (_options.verbose){
+        std::cout << name() << ": depth " << _depth << ", " << _nodes << " nodes on " << _threads << " threads ("
+                  << (_stats.time_ms > 0 ? 1000.0*_nodes/_stats.time_ms : 0.0) << "/s)" << std::endl;
+    }
+    va.push_back(_game->to_action(root.get(), _best_move));
+    return Agent::SOLVE_STATUS::SOLVED;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Agent.h"
+#include "../game/AdversarialGame.h"
+#include "../util/TranspositionTable.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Shared driver of the game-tree agents (AlphaBetaAgent, ExpectimaxAgent)
+// solve() picks one move for the side to move in the game's current state.
+// The search deepens one ply at a time until the depth limit, a proven result or
+// the budget (time, nodes, cancel); the move of the deepest finished iteration is
+// returned, and the first iteration always finishes. Lazy SMP: with N threads,
+// N workers search the same root on their own copies of the state, sharing only
+// the transposition table. Helpers start one ply deeper on odd ids, so they fill
+// the table ahead of the main worker, whose result is the one used. Each worker
+// keeps its own history table (cutoff counts per side and move) for ordering.
+class AdversarialAgent: public Agent{
+    protected:
+        static const int MAX_PLY = 64;
+        // Beyond every evaluation
+        static const int INF = AdversarialGame::WIN_SCORE + 1;
+        struct Worker{
+            int _id;
+            std::shared_ptr<State> _state;  // Made and unmade in place
+            std::vector<int> _moves;        // MAX_PLY + 1 move lists of max_moves()
+            std::vector<int> _scores;       // Ordering scores, parallel to _moves
+            std::vector<int> _history;      // [side*max_moves() + move]
+            long long _nodes;               // Not yet added to _nodes
+            bool _abortable;                // Watches _stop
+            bool _aborted;
+            int _root_move;                 // Best root move of the current iteration
+        };
+        AdversarialGame* _game;
+        TranspositionTable _tt;
+        int _threads;
+        int _max_depth;
+        std::atomic<bool> _stop;
+        std::atomic<long long> _nodes;
+        // Result of the last solve
+        int _value, _depth, _best_move;
+
+        // Value of the root of w._state searched depth plies, setting w._root_move
+        // Ignored once w._aborted is set
+        virtual int search_root(Worker& w, int depth) = 0;
+        // Before the workers start (e.g. clear the table)
+        virtual void prepare(const State* root){};
+        // Count a node, @return true if the worker must unwind
+        inline bool visit(Worker& w){
+            if ((++w._nodes & 1023) == 0){
+                _nodes += w._nodes;
+                w._nodes = 0;
+            }
+            if (w._abortable && _stop.load(std::memory_order_relaxed)) w._aborted = true;
+            return w._aborted;
+        }
+        // Legal moves of w._state at ply, table move first and then by history
+        // @return number of moves, listed from w._moves[ply*max_moves()]
+        int order_moves(Worker& w, int ply, int side, int tt_move);
+        void add_history(Worker& w, int side, int move, int depth);
+        // Win/loss scores are stored relative to the node, not the root, so
+        // faster wins keep scoring higher wherever they are probed from
+        static inline int to_tt(int v, int ply){
+            return v >= AdversarialGame::WIN_BOUND ? v + ply : v <= -AdversarialGame::WIN_BOUND ? v - ply : v;
+        }
+        static inline int from_tt(int v, int ply){
+            return v >= AdversarialGame::WIN_BOUND ? v - ply : v <= -AdversarialGame::WIN_BOUND ? v + ply : v;
+        }
+        // Evaluation at ply, wins sooner (losses later) scoring higher
+        inline int leaf_value(const State* s, int player, int ply) const{
+            return from_tt(_game->evaluate(s, player), ply);
+        }
+        virtual const char* name() const = 0;
+    private:
+        void deepen(Worker& w);
+    public:
+        AdversarialAgent(AdversarialGame* g);
+        virtual ~AdversarialAgent();
+        // Worker threads (<= 0: hardware threads)
+        void set_threads(int n);
+        // Deepest iteration, at most MAX_PLY
+        void set_max_depth(int d);
+        // Transposition table size (drops its entries)
+        void set_table_size(size_t bytes);
+        // @return SOLVED with one move, NO_SOLUTION if the game is over, CANCELLED
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+        // Value of the chosen move for the side to move, depth it was searched to, and nodes visited
+        int get_value() const{return _value;}
+        int get_depth() const{return _depth;}
+        long long get_nodes() const{return _nodes.load();}
+};
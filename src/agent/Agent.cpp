@@ -7,3 +7,52 @@ size_t StatePointerHash::operator()(const std::shared_ptr<const State> &s) const
 size_t StateRawPointerHash::operator()(const State* const &s) const{
     return s->hash();
 }
+
+const char* Agent::status_name(int code){
+    switch(code){
+        case Agent::SOLVE_STATUS::SOLVED: return "solved";
+        case Agent::SOLVE_STATUS::NO_SOLUTION: return "no_solution";
+        case Agent::SOLVE_STATUS::TIME_LIMIT: return "time_limit";
+        case Agent::SOLVE_STATUS::MEMORY_LIMIT: return "memory_limit";
+        case Agent::SOLVE_STATUS::CANCELLED: return "cancelled";
+        case Agent::SOLVE_STATUS::NODE_LIMIT: return "node_limit";
+        case Agent::SOLVE_STATUS::CHECKPOINT_ERROR: return "checkpoint_error";
+        default: return "error";
+    }
+}
+
+void Agent::begin_solve(){
+    _stats = SearchStats();
+    _budget_calls = 0;
+    _solve_start = SolveOptions::clock::now();
+    _has_deadline = false;
+    _tracing = Trace::enabled();
+    if (_tracing) _trace_start = Trace::now();
+    if (_options.perf) _options.perf->start();
+    if (_options.time_limit_ms > 0){
+        _solve_deadline = _solve_start + std::chrono::duration_cast<SolveOptions::clock::duration>(std::chrono::duration<double, std::milli>(_options.time_limit_ms));
+        _has_deadline = true;
+    }
+    if (_options.deadline != SolveOptions::clock::time_point()){
+        if (!_has_deadline || _options.deadline < _solve_deadline) _solve_deadline = _options.deadline;
+        _has_deadline = true;
+    }
+}
+
+int Agent::check_budget(long long expanded, size_t memory_bytes, bool force){
+    _stats.expanded = expanded;
+    if (memory_bytes > _stats.memory_bytes) _stats.memory_bytes = memory_bytes;
+    if (_options.cancelled()) return Agent::SOLVE_STATUS::CANCELLED;
+    if (_options.node_limit > 0 && expanded >= _options.node_limit) return Agent::SOLVE_STATUS::NODE_LIMIT;
+    if (!force && (++_budget_calls & (BUDGET_CHECK_INTERVAL-1))) return Agent::SOLVE_STATUS::SOLVED;
+    if (_options.memory_limit_bytes > 0 && _stats.memory_bytes > _options.memory_limit_bytes) return Agent::SOLVE_STATUS::MEMORY_LIMIT;
+    if (_has_deadline && SolveOptions::clock::now() >= _solve_deadline) return Agent::SOLVE_STATUS::TIME_LIMIT;
+    return Agent::SOLVE_STATUS::SOLVED;
+}
+
+void Agent::end_solve(){
+    if (_options.perf) _options.perf->stop();
+    _stats.time_ms = std::chrono::duration<double, std::milli>(SolveOptions::clock::now() - _solve_start).count();
+    if (_tracing) Trace::record("solve", "search", _trace_start, _stats.expanded);
+    _tracing = false;
+}
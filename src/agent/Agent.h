@@ -2,6 +2,8 @@
 
 #include "../game/Game.h"
 #include "../heuristic/Heuristic.h"
+#include "../util/PerfCounters.h"
+#include "../util/Trace.h"
 #include <vector>
 #include <memory>
 #include <ctime>
@@ -11,12 +13,84 @@
 #include <unordered_map>
 #include <limits>
 #include <queue>
+#include <atomic>
+#include <chrono>
+
+// Budgets an Agent checks while solving (0 / unset = unlimited)
+struct SolveOptions{
+    typedef std::chrono::steady_clock clock;
+    // Relative to the start of solve()
+    double time_limit_ms;
+    // Absolute deadline (clock::time_point() = none), whichever of the two comes first applies
+    clock::time_point deadline;
+    // States expanded
+    long long node_limit;
+    // Estimated bytes held by the search
+    size_t memory_limit_bytes;
+    // Print progress and summaries to stdout
+    bool verbose;
+    // Cooperative cancellation, solve() gives up soon after *cancel becomes true (not owned)
+    std::atomic<bool>* cancel;
+    // Hardware counters charged per search phase by agents that report phases (not owned)
+    PerfCounters* perf;
+    SolveOptions():time_limit_ms(0), node_limit(0), memory_limit_bytes(0), verbose(true), cancel(nullptr), perf(nullptr){}
+    bool cancelled() const{return cancel && cancel->load(std::memory_order_relaxed);}
+};
+
+// Counters filled in by the last call to solve (also on failure)
+struct SearchStats{
+    long long expanded;     // States expanded
+    long long generated;    // Successors generated
+    size_t memory_bytes;    // Peak estimated bytes held by the search
+    double time_ms;
+    long long bytes_read;   // Disk traffic of external-memory searches
+    long long bytes_written;
+    SearchStats():expanded(0), generated(0), memory_bytes(0), time_ms(0), bytes_read(0), bytes_written(0){}
+};
 
 class Agent{
     protected:
         Game* search_problem;
+        SolveOptions _options;
+        SearchStats _stats;
+        // Calls to check_budget between clock/memory checks (power of 2)
+        static const int BUDGET_CHECK_INTERVAL = 64;
+        // Reset _stats and start the clock (call at the top of solve)
+        void begin_solve();
+        // Record progress and test the budgets. Cancel and node limit are tested on
+        // every call, time and memory every BUDGET_CHECK_INTERVAL calls (or when forced)
+        // @return SOLVED to keep searching, otherwise the SOLVE_STATUS to return
+        int check_budget(long long expanded, size_t memory_bytes, bool force=false);
+        // Stop the clock, _stats.time_ms is the time since begin_solve (traced as "solve")
+        void end_solve();
+        // Charge SolveOptions::perf counters since the last switch and enter phase
+        // (PerfCounters::PHASE), one branch without counters
+        inline void perf_phase(int phase){
+            if (_options.perf) _options.perf->phase(phase);
+        }
+    private:
+        SolveOptions::clock::time_point _solve_start, _solve_deadline;
+        bool _has_deadline;
+        long long _budget_calls;
+        bool _tracing;          // begin_solve saw Trace enabled
+        uint64_t _trace_start;
     public:
-        Agent(Game* sp):search_problem(sp){};
+        // solve() return codes owned by the agent (Game ERR_CODEs are positive)
+        enum SOLVE_STATUS{
+            SOLVED          = 0,
+            NO_SOLUTION     = -1,
+            TIME_LIMIT      = -2,
+            MEMORY_LIMIT    = -3,
+            CANCELLED       = -4,
+            NODE_LIMIT      = -5,
+            CHECKPOINT_ERROR= -6
+        };
+        Agent(Game* sp):search_problem(sp), _has_deadline(false), _budget_calls(0), _tracing(false), _trace_start(0){};
         virtual int solve(std::vector<std::shared_ptr<Action>>& va) = 0;
         virtual ~Agent(){search_problem = 0;};
+        void set_options(const SolveOptions& o){_options = o;}
+        const SolveOptions& get_options() const{return _options;}
+        const SearchStats& get_stats() const{return _stats;}
+        // Short name for a solve() return code
+        static const char* status_name(int code);
 };
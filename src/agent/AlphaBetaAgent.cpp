@@ -0,0 +1,59 @@
+#include "AlphaBetaAgent.h"
+#include <iostream>
+
+AlphaBetaAgent::AlphaBetaAgent(AdversarialGame* g):AdversarialAgent(g), _chance_error(false){}
+
+int AlphaBetaAgent::negamax(Worker& w, int depth, int ply, int alpha, int beta){
+    if (visit(w)) return 0;
+    State* s = w._state.get();
+    int side = _game->to_move(s);
+    if (depth == 0 || _game->is_terminal(s)) return leaf_value(s, side, ply);
+    if (side == AdversarialGame::CHANCE){
+        if (!_chance_error.exchange(true)) std::cerr << "(AlphaBetaAgent::negamax) Error: chance node reached, use ExpectimaxAgent" << std::endl;
+        return 0;
+    }
+    uint64_t key = _game->key(s);
+    TranspositionTable::Entry e;
+    int tt_move = -1;
+    if (_tt.probe(key, e)){
+        tt_move = e.move;
+        // The root always searches, it has to name a move
+        if (ply > 0 && e.depth >= depth){
+            int v = from_tt(e.value, ply);
+            if (e.bound == TranspositionTable::EXACT || (e.bound == TranspositionTable::LOWER && v >= beta)
+                || (e.bound == TranspositionTable::UPPER && v <= alpha)) return v;
+        }
+    }
+    int n = order_moves(w, ply, side, tt_move);
+    if (n == 0) return leaf_value(s, side, ply);
+    const int* moves = &w._moves[ply*_game->max_moves()];
+    int alpha0 = alpha, best = -INF, best_move = -1;
+    for (int i=0;i<n;++i){
+        int m = moves[i];
+        _game->make_move(s, m);
+        // Players usually alternate, but a side may also move twice
+        int v = _game->to_move(s) == side ? negamax(w, depth - 1, ply + 1, alpha, beta)
+                                          : -negamax(w, depth - 1, ply + 1, -beta, -alpha);
+        _game->undo_move(s, m);
+        if (w._aborted) return 0;
+        if (v > best){
+            best = v;
+            best_move = m;
+            if (v > alpha){
+                alpha = v;
+                if (alpha >= beta){
+                    add_history(w, side, m, depth);
+                    break;
+                }
+            }
+        }
+    }
+    int bound = best <= alpha0 ? TranspositionTable::UPPER : best >= beta ? TranspositionTable::LOWER : TranspositionTable::EXACT;
+    _tt.store(key, to_tt(best, ply), depth, bound, best_move);
+    if (ply == 0) w._root_move = best_move;
+    return best;
+}
+
+int AlphaBetaAgent::search_root(Worker& w, int depth){
+    return negamax(w, depth, 0, -INF, INF);
+}
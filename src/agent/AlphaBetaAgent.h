@@ -0,0 +1,21 @@
+#pragma once
+
+#include "AdversarialAgent.h"
+
+// Minimax with alpha-beta pruning (negamax) for two-player games
+// Each node probes the shared transposition table for a cutoff and for the move
+// to try first, then orders the rest by history. Cutoffs credit the move's
+// history by depth^2. Table entries from earlier solves are kept (and replaced
+// first), so a game played move by move reuses them. Games with CHANCE nodes
+// need ExpectimaxAgent; reaching one is an error.
+class AlphaBetaAgent: public AdversarialAgent{
+    private:
+        std::atomic<bool> _chance_error;
+        int negamax(Worker& w, int depth, int ply, int alpha, int beta);
+    protected:
+        virtual int search_root(Worker& w, int depth) override;
+        virtual const char* name() const override{return "AlphaBeta";}
+    public:
+        AlphaBetaAgent(AdversarialGame* g);
+        virtual ~AlphaBetaAgent(){};
+};
@@ -1,10 +1,12 @@
 #include "AstarSearchAgent.h"
+#include <cstdio>
+#include <cstring>
 
-int AstarSearchAgent::AugmentedState::count = 0;
+std::atomic<int> AstarSearchAgent::AugmentedState::count(0);
 
-AstarSearchAgent::AstarSearchAgent(Game* g, Heuristic* h): Agent(g), search_heuristic(h), _w(1.0){}
+AstarSearchAgent::AstarSearchAgent(Game* g, Heuristic* h): AstarSearchAgent(g, h, 1.0){}
 
-AstarSearchAgent::AstarSearchAgent(Game* g, Heuristic* h, double weight): Agent(g), search_heuristic(h), _w(weight){}
+AstarSearchAgent::AstarSearchAgent(Game* g, Heuristic* h, double weight): Agent(g), search_heuristic(h), _w(weight), _incremental(true), _hash_diagnostics(false), _checkpoint_interval_s(0){}
 
 AstarSearchAgent::~AstarSearchAgent(){
     // !IMPORTANT Release control of pointers
@@ -16,6 +18,23 @@ void AstarSearchAgent::set_weight(double d){
     this->_w = d;
 }
 
+void AstarSearchAgent::set_incremental(bool b){
+    this->_incremental = b;
+}
+
+void AstarSearchAgent::set_hash_diagnostics(bool b){
+    this->_hash_diagnostics = b;
+}
+
+void AstarSearchAgent::set_checkpoint(const std::string& path, double interval_s){
+    this->_checkpoint_path = path;
+    this->_checkpoint_interval_s = interval_s;
+}
+
+void AstarSearchAgent::set_resume(const std::string& path){
+    this->_resume_path = path;
+}
+
 int AstarSearchAgent::random(std::vector<std::shared_ptr<Action>>& va){
     //TODO: actual algo (this is just to test infrastructure)
     // Make 10 random (valid) moves
@@ -55,59 +74,129 @@ int AstarSearchAgent::random(std::vector<std::shared_ptr<Action>>& va){
 
 int AstarSearchAgent::greedy_search(std::vector<std::shared_ptr<Action>>& va){
     typedef std::pair<std::shared_ptr<State>, std::shared_ptr<Action>> pair_sa;
-    typedef std::unordered_map<std::shared_ptr<State>, std::shared_ptr<AugmentedState>, StatePointerHash, DerefCompare> aug_map;
-    typedef std::pair<double, std::shared_ptr<AugmentedState>> open_item;
-    typedef std::set<open_item> aug_pq;
-    typedef aug_pq::iterator pq_iter;
-    typedef std::unordered_map<std::shared_ptr<State>, pq_iter, StatePointerHash, DerefCompare> pq_iter_map;
     typedef std::pair<std::shared_ptr<State>, pq_iter> pq_iter_pair;
-    typedef std::unordered_set<std::shared_ptr<State>, StatePointerHash> closed_set;
-    aug_map visited;
-    aug_pq pq;
-    pq_iter_map pq_map;
-    closed_set closed;
+    SearchSpace space;
+    aug_map& visited = space.visited;
+    aug_pq& pq = space.pq;
+    pq_iter_map& pq_map = space.pq_map;
+    closed_set& closed = space.closed;
 
     // Track number of states traversed
-    int num_states = 0;
+    long long& num_states = space.expanded;
+    begin_solve();
 
     // Track max number of living AugmentedStates
     int living_augStates = 0;
 
+    // Track time spent inside the heuristic against the whole search
+    typedef std::chrono::high_resolution_clock clock;
+    clock::time_point search_start = clock::now();
+    clock::duration heuristic_time = clock::duration::zero();
+    // Successor and move pointers for the batch scorers, reused across expansions
+    std::vector<const State*> batch;
+    std::vector<const Action*> batch_actions;
+    bool incremental = _incremental && search_heuristic->is_incremental();
+
     // Grab the start state
     std::shared_ptr<State> init_state = std::shared_ptr<State>(search_problem->get_state());
 
-    // Add to pq
-    std::shared_ptr<AugmentedState> init_augState = std::make_shared<AugmentedState>(0.0, 0.0, init_state, nullptr, nullptr);
-    std::pair<pq_iter, bool> insert_pq = pq.insert(open_item(init_augState->_priority, init_augState));
-    if (insert_pq.second) pq_map.insert(pq_iter_pair(init_state, insert_pq.first));
-    visited[init_state] = init_augState;
+    // Estimated bytes per visited state: the state, its AugmentedState and a node
+    // in each of visited, pq, pq_map and closed
+    const size_t bytes_per_state = init_state->footprint() + sizeof(AugmentedState) + 4*(32 + sizeof(void*));
+    auto record_stats = [&](){
+        check_budget(num_states, visited.size()*bytes_per_state, true);
+        _stats.generated = space.generated;
+        end_solve();
+        if (_hash_diagnostics){
+            std::cout << "Astar visited map: ";
+            visited.report(std::cout);
+            std::cout << std::endl;
+        }
+    };
+    auto search_ms = [&](){
+        return space.prior_ms + std::chrono::duration<double, std::milli>(clock::now() - search_start).count();
+    };
+
+    // Periodic checkpoints are tested every 1024 expansions
+    bool checkpointing = !_checkpoint_path.empty();
+    clock::time_point next_checkpoint = search_start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(_checkpoint_interval_s));
 
+    if (!_resume_path.empty()){
+        std::string path = _resume_path;
+        _resume_path.clear();
+        if (!load_checkpoint(space, init_state.get(), path)){
+            end_solve();
+            return Agent::SOLVE_STATUS::CHECKPOINT_ERROR;
+        }
+        if (_options.verbose){
+            std::cout << "Astar resumed from " << path << ": " << num_states << " expanded, "
+                      << pq.size() << " open, " << closed.size() << " closed" << std::endl;
+        }
+    }
+    else{
+        // Add to pq
+        double init_h = search_heuristic->score(init_state.get(), search_problem);
+        std::shared_ptr<AugmentedState> init_augState = std::make_shared<AugmentedState>(0.0, 0.0, init_h, space.next_seq++, init_state, nullptr, nullptr);
+        std::pair<pq_iter, bool> insert_pq = pq.insert(init_augState);
+        if (insert_pq.second) pq_map.insert(pq_iter_pair(init_state, insert_pq.first));
+        visited[init_state] = init_augState;
+    }
+
+    // One trace event per TRACE_BATCH expansions
+    const long long TRACE_BATCH = 1024;
+    uint64_t trace_batch = Trace::enabled() ? Trace::now() : 0;
     while(!pq.empty()){
+        perf_phase(PerfCounters::OTHER);
+        // Budgets (time and memory checks are amortized inside check_budget), tested
+        // before popping so a checkpoint written on the way out holds the whole open list
+        int budget_code = check_budget(num_states, visited.size()*bytes_per_state);
+        if (budget_code){
+            if (checkpointing) save_checkpoint(space, init_state.get(), search_ms());
+            record_stats();
+            return budget_code;
+        }
+        if (checkpointing && _checkpoint_interval_s > 0 && !(num_states & 1023) && clock::now() >= next_checkpoint){
+            save_checkpoint(space, init_state.get(), search_ms());
+            next_checkpoint = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(_checkpoint_interval_s));
+        }
+
         // Grab top
-        std::shared_ptr<AugmentedState> curState = pq.begin()->second;
+        perf_phase(PerfCounters::OPEN_LIST);
+        std::shared_ptr<AugmentedState> curState = *pq.begin();
         pq.erase(pq_map[curState->_state]);
         pq_map.erase(curState->_state);
         double cur_cost = curState->_cost;
+        perf_phase(PerfCounters::OTHER);
 
         living_augStates = std::max(living_augStates, curState->get_count());
 
         if (search_problem->is_goal_state(curState->_state.get())){
-            // Traceback
-            va.push_back(curState->_action);
-            std::shared_ptr<State> cur_prev = curState->_prev;
-            while(cur_prev){
-                std::shared_ptr<Action> prev_action = visited[cur_prev]->_action;
-                cur_prev = visited[cur_prev]->_prev;
-                if (cur_prev){
-                    va.push_back(prev_action);
+            // Traceback (nodes restored from a checkpoint recover their action from the parent)
+            for (std::shared_ptr<AugmentedState> node = curState;node->_prev;node = visited[node->_prev]){
+                std::shared_ptr<Action> a = node->_action ? node->_action : find_action(node->_prev.get(), node->_state.get());
+                if (!a){
+                    std::cerr << "(AstarSearchAgent::greedy_search) Error: no action leads to a restored state from its parent" << std::endl;
+                    va.clear();
+                    record_stats();
+                    return Agent::SOLVE_STATUS::CHECKPOINT_ERROR;
                 }
+                va.push_back(a);
             }
             // Reverse va
             std::reverse(va.begin(), va.end());
-            std::cout << "Astar visited: " << num_states << " States" << std::endl;
-            std::cout << "Astar created: " << living_augStates << " AugmentedStates" << std::endl;
-            return 0;
+            record_stats();
+            if (_options.verbose){
+                std::cout << "Astar visited: " << num_states << " States" << std::endl;
+                std::cout << "Astar created: " << living_augStates << " AugmentedStates" << std::endl;
+                double search_ms = _stats.time_ms;
+                double heuristic_ms = std::chrono::duration<double, std::milli>(heuristic_time).count();
+                std::cout << "Astar heuristic time: " << heuristic_ms << " ms (" << (search_ms > 0 ? 100.0*heuristic_ms/search_ms : 0.0)
+                          << "% of search, " << (incremental ? "incremental" : "full") << " scoring)" << std::endl;
+                if (space.prior_ms > 0) std::cout << "Astar time before resume: " << space.prior_ms << " ms" << std::endl;
+            }
+            return Agent::SOLVE_STATUS::SOLVED;
         }
+        perf_phase(PerfCounters::LOOKUP);
         if (visited.find(curState->_state) != visited.end()){
             // Skip this already expanded state and cur_cost is higher or same
             if (cur_cost > visited[curState->_state]->_cost) continue;
@@ -141,24 +230,48 @@ int AstarSearchAgent::greedy_search(std::vector<std::shared_ptr<Action>>& va){
 
         // Track number of states traversed
         num_states++;
+        if (!(num_states % TRACE_BATCH) && Trace::enabled()){
+            Trace::record("expand_batch", "search", trace_batch, num_states);
+            trace_batch = Trace::now();
+        }
 
         // Ping every 10K states
-        if (num_states%10000 == 0) std::cout << "Astar visited: " << num_states << " States" << std::endl;
-        if (living_augStates%10000 == 0) std::cout << "Astar created: " << living_augStates << " AugmentedStates" << std::endl;
+        if (_options.verbose){
+            if (num_states%10000 == 0) std::cout << "Astar visited: " << num_states << " States" << std::endl;
+            if (living_augStates%10000 == 0) std::cout << "Astar created: " << living_augStates << " AugmentedStates" << std::endl;
+        }
 
         // Expand state
+        perf_phase(PerfCounters::SUCCESSORS);
         std::vector<pair_sa> vsa;
         int expand_code = search_problem->get_successors(curState->_state.get(), vsa);
         if (expand_code){
             std::cerr << "(AstarSearchAgent::greedy_search) get_successors failed with " << expand_code << std::endl;
+            record_stats();
             return expand_code;
         }
+        space.generated += vsa.size();
         if (vsa.size() < 1){
             // gg... no more moves
             continue;
         }
-        for (pair_sa state_action: vsa){
-            double cur_h = search_heuristic->score(state_action.first.get(), search_problem);
+        // Score all successors up front as one batch the heuristic may vectorize or
+        // spread over threads (per-move deltas from curState when supported)
+        std::vector<double> vh(vsa.size());
+        perf_phase(PerfCounters::HEURISTIC);
+        clock::time_point h_start = clock::now();
+        batch.resize(vsa.size());
+        for (size_t i=0;i<vsa.size();++i) batch[i] = vsa[i].first.get();
+        if (incremental){
+            batch_actions.resize(vsa.size());
+            for (size_t i=0;i<vsa.size();++i) batch_actions[i] = vsa[i].second.get();
+            search_heuristic->score_child_batch(curState->_h, curState->_state.get(), batch_actions.data(), batch.data(), batch.size(), search_problem, vh.data());
+        }
+        else search_heuristic->score_batch(batch.data(), batch.size(), search_problem, vh.data());
+        heuristic_time += clock::now() - h_start;
+        for (size_t i=0;i<vsa.size();++i){
+            pair_sa& state_action = vsa[i];
+            double cur_h = vh[i];
             double cur_c = state_action.second->_cost;
             double cur_cost_to_come = curState->_cost + cur_c;
             #ifdef DEBUG
@@ -171,35 +284,218 @@ int AstarSearchAgent::greedy_search(std::vector<std::shared_ptr<Action>>& va){
             //     std::cerr << it->first << ":" << &it->second << std::endl;
             // }
             // #endif
+            perf_phase(PerfCounters::LOOKUP);
             if (visited.find(state_action.first) != visited.end()){
                 // Look to see if our lowest priority expansion is lower than current
                 if (cur_cost_to_come < visited[state_action.first]->_cost){
                     // Only add if our cost to come could possibly be less
-                    std::shared_ptr<AugmentedState> new_state = std::make_shared<AugmentedState>(cur_cost_to_come + cur_h*this->_w, cur_cost_to_come, state_action.first, curState->_state, state_action.second);
+                    perf_phase(PerfCounters::OPEN_LIST);
+                    std::shared_ptr<AugmentedState> new_state = std::make_shared<AugmentedState>(cur_cost_to_come + cur_h*this->_w, cur_cost_to_come, cur_h, space.next_seq++, state_action.first, curState->_state, state_action.second);
                     // Handle pq
                     if (pq_map.find(new_state->_state) != pq_map.end()){
                         pq.erase(pq_map[new_state->_state]);
                         pq_map.erase(new_state->_state);
                     }
-                    std::pair<pq_iter, bool> insert_pq = pq.insert(open_item(new_state->_priority, new_state));
+                    std::pair<pq_iter, bool> insert_pq = pq.insert(new_state);
                     if (insert_pq.second) pq_map.insert(pq_iter_pair(new_state->_state, insert_pq.first));
                     // Maybe push into visited as well?
                     // Update stored state in map
+                    perf_phase(PerfCounters::LOOKUP);
                     visited[new_state->_state] = new_state;
                 }
             }
             else{
-                std::shared_ptr<AugmentedState> new_state = std::make_shared<AugmentedState>(cur_cost_to_come + cur_h*this->_w, cur_cost_to_come, state_action.first, curState->_state, state_action.second);
-                std::pair<pq_iter, bool> insert_pq = pq.insert(open_item(new_state->_priority, new_state));
+                perf_phase(PerfCounters::OPEN_LIST);
+                std::shared_ptr<AugmentedState> new_state = std::make_shared<AugmentedState>(cur_cost_to_come + cur_h*this->_w, cur_cost_to_come, cur_h, space.next_seq++, state_action.first, curState->_state, state_action.second);
+                std::pair<pq_iter, bool> insert_pq = pq.insert(new_state);
                 if (insert_pq.second) pq_map.insert(pq_iter_pair(new_state->_state, insert_pq.first));
+                perf_phase(PerfCounters::LOOKUP);
                 visited[new_state->_state] = new_state;
             }
         }
     }
-    std::cerr << "(AstarSearchAgent::greedy_search) No solution path found..." << std::endl;
-    return -1;  // ERR no path
+    record_stats();
+    if (_options.verbose) std::cerr << "(AstarSearchAgent::greedy_search) No solution path found..." << std::endl;
+    return Agent::SOLVE_STATUS::NO_SOLUTION;
 }
 
 int AstarSearchAgent::solve(std::vector<std::shared_ptr<Action>>& va){
     return greedy_search(va);
 }
+
+/////////////////
+// Checkpoints //
+/////////////////
+// On-disk layout (host byte order): CheckpointHeader, the packed start state, then
+// node_count records of
+//   packed state, double priority, double cost, double h,
+//   u64 parent record (NO_PARENT for the start), i64 seq, u8 open
+// Every packed state is state_bytes (Game::max_packed_size) long
+struct CheckpointHeader{
+    char magic[4];
+    uint32_t state_bytes;
+    double weight;
+    int64_t expanded;
+    int64_t generated;
+    int64_t next_seq;
+    double elapsed_ms;
+    uint64_t node_count;
+};
+
+static const char CHECKPOINT_MAGIC[4] = {'A','S','C','K'};
+static const uint64_t NO_PARENT = ~(uint64_t)0;
+
+template<class T>
+static void put_bytes(std::vector<uint8_t>& buf, const T& v){
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&v);
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+template<class T>
+static bool get_bytes(FILE* f, T& v){
+    return fread(&v, sizeof(T), 1, f) == 1;
+}
+
+bool AstarSearchAgent::save_checkpoint(const SearchSpace& sp, const State* init_state, double elapsed_ms){
+    size_t state_bytes = search_problem->max_packed_size();
+    std::vector<uint8_t> start(state_bytes);
+    if (!state_bytes || !search_problem->pack(init_state, start.data())){
+        std::cerr << "(AstarSearchAgent::save_checkpoint) Error: states of this game cannot be packed" << std::endl;
+        return false;
+    }
+    // Number the nodes so back pointers can be written as record indices
+    std::unordered_map<const AugmentedState*, uint64_t> index;
+    index.reserve(sp.visited.size());
+    for (const auto& kv: sp.visited) index.emplace(kv.second.get(), index.size());
+
+    CheckpointHeader header;
+    memcpy(header.magic, CHECKPOINT_MAGIC, 4);
+    header.state_bytes = state_bytes;
+    header.weight = _w;
+    header.expanded = sp.expanded;
+    header.generated = sp.generated;
+    header.next_seq = sp.next_seq;
+    header.elapsed_ms = elapsed_ms;
+    header.node_count = sp.visited.size();
+
+    std::string tmp_path = _checkpoint_path + ".tmp";
+    FILE* f = fopen(tmp_path.c_str(), "wb");
+    if (!f){
+        std::cerr << "(AstarSearchAgent::save_checkpoint) Error: cannot open " << tmp_path << std::endl;
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 && fwrite(start.data(), 1, start.size(), f) == start.size();
+    // Records go out in chunks rather than one buffer the size of the search
+    std::vector<uint8_t> buf;
+    for (aug_map::const_iterator it=sp.visited.begin();ok && it!=sp.visited.end();++it){
+        const AugmentedState& node = *it->second;
+        size_t at = buf.size();
+        buf.resize(at + state_bytes);
+        if (!search_problem->pack(node._state.get(), buf.data() + at)){
+            ok = false;
+            break;
+        }
+        uint64_t parent = NO_PARENT;
+        if (node._prev){
+            aug_map::const_iterator pit = sp.visited.find(node._prev);
+            if (pit != sp.visited.end()) parent = index[pit->second.get()];
+        }
+        put_bytes(buf, node._priority);
+        put_bytes(buf, node._cost);
+        put_bytes(buf, node._h);
+        put_bytes(buf, parent);
+        put_bytes(buf, (int64_t)node._seq);
+        put_bytes(buf, (uint8_t)(sp.pq_map.find(it->first) != sp.pq_map.end()));
+        if (buf.size() >= (1 << 20)){
+            ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+            buf.clear();
+        }
+    }
+    if (ok && !buf.empty()) ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp_path.c_str(), _checkpoint_path.c_str())){
+        std::cerr << "(AstarSearchAgent::save_checkpoint) Error: failed writing " << _checkpoint_path << std::endl;
+        remove(tmp_path.c_str());
+        return false;
+    }
+    if (_options.verbose){
+        std::cout << "Astar checkpoint: " << header.node_count << " nodes (" << sp.pq.size() << " open) to "
+                  << _checkpoint_path << std::endl;
+    }
+    return true;
+}
+
+bool AstarSearchAgent::load_checkpoint(SearchSpace& sp, const State* init_state, const std::string& path){
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f){
+        std::cerr << "(AstarSearchAgent::load_checkpoint) Error: cannot open " << path << std::endl;
+        return false;
+    }
+    CheckpointHeader header;
+    size_t state_bytes = search_problem->max_packed_size();
+    std::vector<uint8_t> start(state_bytes), saved_start;
+    bool ok = state_bytes && search_problem->pack(init_state, start.data())
+           && get_bytes(f, header) && !memcmp(header.magic, CHECKPOINT_MAGIC, 4) && header.state_bytes == state_bytes;
+    if (ok){
+        saved_start.resize(state_bytes);
+        ok = fread(saved_start.data(), 1, saved_start.size(), f) == saved_start.size();
+    }
+    if (!ok || saved_start != start || header.weight != _w){
+        std::cerr << "(AstarSearchAgent::load_checkpoint) Error: " << path
+                  << " is not a checkpoint of this start state and weight" << std::endl;
+        fclose(f);
+        return false;
+    }
+    std::vector<std::shared_ptr<AugmentedState>> nodes;
+    std::vector<uint64_t> parents;
+    std::vector<uint8_t> open, packed(state_bytes);
+    nodes.reserve(header.node_count);
+    parents.reserve(header.node_count);
+    open.reserve(header.node_count);
+    for (uint64_t i=0;ok && i<header.node_count;++i){
+        double priority, cost, h;
+        uint64_t parent;
+        int64_t seq;
+        uint8_t is_open;
+        ok = fread(packed.data(), 1, state_bytes, f) == state_bytes && get_bytes(f, priority) && get_bytes(f, cost) && get_bytes(f, h)
+          && get_bytes(f, parent) && get_bytes(f, seq) && get_bytes(f, is_open);
+        if (!ok) break;
+        std::shared_ptr<State> s = search_problem->unpack(packed.data(), state_bytes);
+        if (!s || (parent != NO_PARENT && parent >= header.node_count)){
+            ok = false;
+            break;
+        }
+        nodes.push_back(std::make_shared<AugmentedState>(priority, cost, h, seq, s, nullptr, nullptr));
+        parents.push_back(parent);
+        open.push_back(is_open);
+    }
+    fclose(f);
+    if (!ok){
+        std::cerr << "(AstarSearchAgent::load_checkpoint) Error: " << path << " is truncated or holds invalid states" << std::endl;
+        return false;
+    }
+    sp = SearchSpace();
+    sp.visited.reserve(nodes.size());
+    for (size_t i=0;i<nodes.size();++i){
+        if (parents[i] != NO_PARENT) nodes[i]->_prev = nodes[parents[i]]->_state;
+        sp.visited[nodes[i]->_state] = nodes[i];
+        if (open[i]) sp.pq_map[nodes[i]->_state] = sp.pq.insert(nodes[i]).first;
+        else sp.closed.insert(nodes[i]->_state);
+    }
+    sp.expanded = header.expanded;
+    sp.generated = header.generated;
+    sp.next_seq = header.next_seq;
+    sp.prior_ms = header.elapsed_ms;
+    return true;
+}
+
+std::shared_ptr<Action> AstarSearchAgent::find_action(const State* parent, const State* child){
+    std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+    if (search_problem->get_successors(parent, vsa)) return nullptr;
+    // Cheapest action reaching the child (several may, e.g. different player walks)
+    std::shared_ptr<Action> best = nullptr;
+    for (size_t i=0;i<vsa.size();++i){
+        if (*vsa[i].first == *child && (!best || vsa[i].second->_cost < best->_cost)) best = vsa[i].second;
+    }
+    return best;
+}
@@ -3,6 +3,7 @@
 #include "Agent.h"
 #include "../game/Game.h"
 #include "../heuristic/Heuristic.h"
+#include "../util/FlatStateMap.h"
 #include <vector>
 #include <memory>
 #include <ctime>
@@ -13,6 +14,9 @@
 #include <limits>
 #include <queue>
 #include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <string>
 
 // #define DEBUG
 
@@ -20,48 +24,82 @@ class AstarSearchAgent: public Agent{
     private:
         // Custom wrapper state for priority queue/map
         struct AugmentedState{
-            static int count;
-            double _priority, _cost;            // Actual g() cost_to_come, g+h for priority
+            // Shared by every search (agents may run on several threads)
+            static std::atomic<int> count;
+            double _priority, _cost, _h;        // Actual g() cost_to_come, g+h for priority, h alone
+            long long _seq;                     // Creation order, breaks priority ties
             std::shared_ptr<State> _state;      // Current state
             std::shared_ptr<State> _prev;       // Back pointer
-            std::shared_ptr<Action> _action;    // Action taken from _prev->_state
+            std::shared_ptr<Action> _action;    // Action taken from _prev->_state (null when restored from a checkpoint)
             // Should never happen?
-            AugmentedState():_priority(-1.0), _cost(-1.0), _state(nullptr), _prev(nullptr), _action(nullptr){count++;}
-            AugmentedState(double priority, double cost, 
+            AugmentedState():_priority(-1.0), _cost(-1.0), _h(0.0), _seq(0), _state(nullptr), _prev(nullptr), _action(nullptr){count++;}
+            AugmentedState(double priority, double cost, double h, long long seq,
                             std::shared_ptr<State> state,
                             std::shared_ptr<State> prev,
                             std::shared_ptr<Action> action)
-                           :_priority(priority), _cost(cost),
+                           :_priority(priority), _cost(cost), _h(h), _seq(seq),
                             _state(state), _prev(prev), _action(action){count++;}
             virtual ~AugmentedState(){count--;}
             // Copy constructor
             AugmentedState(const AugmentedState& as)
-                           :_priority(as._priority), _cost(as._cost),
+                           :_priority(as._priority), _cost(as._cost), _h(as._h), _seq(as._seq),
                             _state(as._state), _prev(as._prev), _action(as._action){count++;}
             // Copy assignment
             AugmentedState& operator=(AugmentedState as){
                 std::swap(this->_cost, as._cost);
                 std::swap(this->_priority, as._priority);
+                std::swap(this->_h, as._h);
+                std::swap(this->_seq, as._seq);
                 std::swap(this->_state, as._state);
                 std::swap(this->_prev, as._prev);
                 std::swap(this->_action, as._action);
                 return *this;
             }
             // Get num living descendants
-            int get_count(){return count;}
-            // Overload comparators
+            int get_count(){return count.load();}
+            // Open list order: lowest priority, then lowest h (deepest), then newest first
+            // A total order, so a search restored from a checkpoint pops in the same order
             bool operator<(const AugmentedState& other) const{
-                return _priority < other._priority;
+                if (_priority != other._priority) return _priority < other._priority;
+                if (_h != other._h) return _h < other._h;
+                return _seq > other._seq;
             }
-            bool operator>(const AugmentedState& other) const{
-                return _priority > other._priority;
+        };
+        struct OpenOrder{
+            bool operator()(const std::shared_ptr<AugmentedState>& a, const std::shared_ptr<AugmentedState>& b) const{
+                return *a < *b;
             }
         };
+        typedef FlatStateMap<std::shared_ptr<AugmentedState>> aug_map;
+        typedef std::set<std::shared_ptr<AugmentedState>, OpenOrder> aug_pq;
+        typedef aug_pq::iterator pq_iter;
+        typedef FlatStateMap<pq_iter> pq_iter_map;
+        typedef std::unordered_set<std::shared_ptr<State>, StatePointerHash> closed_set;
+        // Everything a search needs to carry on (what a checkpoint holds)
+        struct SearchSpace{
+            aug_map visited;        // Best node found for every generated state
+            aug_pq pq;              // Open list
+            pq_iter_map pq_map;     // Open list position by state
+            closed_set closed;      // Expanded states
+            long long expanded, generated, next_seq;
+            double prior_ms;        // Search time spent before the last resume
+            SearchSpace():expanded(0), generated(0), next_seq(0), prior_ms(0){}
+        };
 
         Heuristic* search_heuristic;
         double _w;      // w-weighted A*
+        bool _incremental;  // Use Heuristic::score_child when the heuristic supports it
+        bool _hash_diagnostics;
+        std::string _checkpoint_path, _resume_path;
+        double _checkpoint_interval_s;
         int random(std::vector<std::shared_ptr<Action>>& va);
         int greedy_search(std::vector<std::shared_ptr<Action>>& va);
+        // Write sp to _checkpoint_path (via a temporary file, so a crash keeps the last good one)
+        bool save_checkpoint(const SearchSpace& sp, const State* init_state, double elapsed_ms);
+        // Replace sp with the search saved at path, which must have started from init_state
+        bool load_checkpoint(SearchSpace& sp, const State* init_state, const std::string& path);
+        // Action leading from parent to child (restored nodes do not keep theirs)
+        std::shared_ptr<Action> find_action(const State* parent, const State* child);
     public:
         // Heuristics are always tied to Search_Problems
         // we can implement this by overloading functions
@@ -70,6 +108,16 @@ class AstarSearchAgent: public Agent{
         AstarSearchAgent(Game* g, Heuristic* h, double weight);
         // Set the weight
         void set_weight(double d);
+        // Toggle per-move heuristic deltas (on by default)
+        void set_incremental(bool b);
+        // Print the visited map's probe lengths, bucket loads and hash collisions after each solve
+        void set_hash_diagnostics(bool b);
+        // Save the search to path every interval_s seconds (<= 0: never on a timer) and
+        // whenever a budget stops it, empty path turns checkpoints off
+        // Needs Game::pack and Game::unpack for the game being searched
+        void set_checkpoint(const std::string& path, double interval_s=0);
+        // Continue the search saved at path on the next solve() (used once, then cleared)
+        void set_resume(const std::string& path);
         // Destructor (don't destroy heuristic)
         virtual ~AstarSearchAgent();
         // Solution
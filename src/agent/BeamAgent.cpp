@@ -0,0 +1,112 @@
+#include "BeamAgent.h"
+#include <algorithm>
+#include <cmath>
+
+// Layer bytes charged per node on top of its state's footprint
+static const size_t LAYER_NODE_OVERHEAD = sizeof(GreedyAgent::Node) + 32;
+
+BeamAgent::BeamAgent(Game* g, Heuristic* h, size_t width)
+    :Agent(g), search_heuristic(h), _incremental(true), _width(width < 1 ? 1 : width), _closed(nullptr){}
+
+BeamAgent::~BeamAgent(){
+    search_problem = nullptr;
+    search_heuristic = nullptr;
+    _closed = nullptr;
+}
+
+void BeamAgent::set_incremental(bool b){
+    _incremental = b;
+}
+
+void BeamAgent::set_width(size_t w){
+    _width = w < 1 ? 1 : w;
+}
+
+void BeamAgent::set_closed_set(ClosedSet* c){
+    _closed = c;
+}
+
+int BeamAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    begin_solve();
+    ClosedSet* closed = _closed ? _closed : &_exact;
+    closed->clear();
+    bool incremental = _incremental && search_heuristic->is_incremental();
+    long long num_states = 0, seq = 0;
+    int depth = 0;
+    size_t layer_bytes = 0;
+
+    std::shared_ptr<Node> root = std::make_shared<Node>();
+    root->_state = search_problem->get_state();
+    root->_h = search_heuristic->score(root->_state.get(), search_problem);
+    root->_seq = seq++;
+    closed->insert(root->_state);
+    std::vector<std::shared_ptr<Node>> layer(1, root), next;
+
+    auto finish = [&](int code){
+        check_budget(num_states, closed->memory_bytes() + layer_bytes, true);
+        end_solve();
+        if (_options.verbose){
+            std::cout << "Beam visited: " << num_states << " States in " << depth << " layers (width " << _width << ")" << std::endl;
+            std::cout << "Beam ";
+            closed->report(std::cout);
+            std::cout << std::endl;
+        }
+        return code;
+    };
+
+    while (!layer.empty()){
+        uint64_t trace_start = Trace::enabled() ? Trace::now() : 0;
+        next.clear();
+        layer_bytes = 0;
+        for (const std::shared_ptr<Node>& node: layer){
+            perf_phase(PerfCounters::OTHER);
+            int budget_code = check_budget(num_states, closed->memory_bytes() + layer_bytes);
+            if (budget_code) return finish(budget_code);
+            if (search_problem->is_goal_state(node->_state.get())){
+                GreedyAgent::trace_back(node, va);
+                return finish(Agent::SOLVE_STATUS::SOLVED);
+            }
+            num_states++;
+            perf_phase(PerfCounters::SUCCESSORS);
+            std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+            int expand_code = search_problem->get_successors(node->_state.get(), vsa);
+            if (expand_code){
+                std::cerr << "(BeamAgent::solve) get_successors failed with " << expand_code << std::endl;
+                return finish(expand_code);
+            }
+            _stats.generated += vsa.size();
+            for (size_t i=0;i<vsa.size();++i){
+                perf_phase(PerfCounters::LOOKUP);
+                if (!closed->insert(vsa[i].first)) continue;
+                perf_phase(PerfCounters::HEURISTIC);
+                double h = incremental ? search_heuristic->score_child(node->_h, node->_state.get(), vsa[i].second.get(), vsa[i].first.get(), search_problem)
+                                       : search_heuristic->score(vsa[i].first.get(), search_problem);
+                if (std::isinf(h)) continue;
+                perf_phase(PerfCounters::OPEN_LIST);
+                std::shared_ptr<Node> child = std::make_shared<Node>();
+                child->_state = vsa[i].first;
+                child->_parent = node;
+                child->_action = vsa[i].second;
+                child->_h = h;
+                child->_seq = seq++;
+                next.push_back(child);
+                layer_bytes += child->_state->footprint() + LAYER_NODE_OVERHEAD;
+            }
+        }
+        // Keep the best width of the next layer (ties to the oldest, so runs repeat)
+        perf_phase(PerfCounters::OPEN_LIST);
+        if (next.size() > _width){
+            std::nth_element(next.begin(), next.begin() + _width, next.end(),
+                [](const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b){
+                    if (a->_h != b->_h) return a->_h < b->_h;
+                    return a->_seq < b->_seq;
+                });
+            next.resize(_width);
+        }
+        layer.swap(next);
+        Trace::record("beam_layer", "search", trace_start, depth);
+        depth++;
+    }
+    if (_options.verbose) std::cerr << "(BeamAgent::solve) No solution path found..." << std::endl;
+    return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Agent.h"
+#include "ClosedSet.h"
+#include "GreedyAgent.h"
+#include "../game/Game.h"
+#include "../heuristic/Heuristic.h"
+#include <vector>
+#include <memory>
+
+// Beam search: breadth-first by layers, keeping only the width states with the
+// lowest h of each layer
+// Memory is bounded by width per layer plus the closed set. It is incomplete,
+// since good states cut from a full layer are gone for good. Duplicates are
+// dropped at generation through any ClosedSet (see BitstateClosedSet).
+class BeamAgent: public Agent{
+    private:
+        typedef GreedyAgent::Node Node;
+        Heuristic* search_heuristic;
+        bool _incremental;
+        size_t _width;
+        ClosedSet* _closed;
+        ExactClosedSet _exact;
+    public:
+        BeamAgent(Game* g, Heuristic* h, size_t width=1000);
+        // Destructor (don't destroy heuristic or closed set)
+        virtual ~BeamAgent();
+        // Toggle per-move heuristic deltas (on by default)
+        void set_incremental(bool b);
+        // States kept per layer
+        void set_width(size_t w);
+        // Closed set used by solve (not owned, null: an exact set)
+        void set_closed_set(ClosedSet* c);
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+};
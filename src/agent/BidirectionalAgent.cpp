@@ -0,0 +1,262 @@
+#include "BidirectionalAgent.h"
+#include "../util/Hash.h"
+#include <algorithm>
+#include <climits>
+
+// Same NESW offsets as Game::ADJ
+static const int DIR[4][2] = {{0,-1},{1,0},{0,1},{-1,0}};
+
+size_t BidirectionalAgent::KeyHash::operator()(const std::string& k) const{
+    return hash_bytes(reinterpret_cast<const uint8_t*>(k.data()), k.size());
+}
+
+BidirectionalAgent::BidirectionalAgent(Sokoban* sok)
+    :Agent(sok), _sokoban(sok), _cols(0), _best(INT_MAX), _bytes(0){
+    _meet[0] = _meet[1] = -1;
+}
+
+BidirectionalAgent::~BidirectionalAgent(){
+    search_problem = nullptr;
+    _sokoban = nullptr;
+}
+
+long long BidirectionalAgent::get_expanded(int side) const{
+    return _sides[side]._expanded;
+}
+
+void BidirectionalAgent::push_distances(const std::vector<pii>& targets, bool reverse, std::vector<int>& out) const{
+    pii dims = _sokoban->get_dims();
+    int cols = dims.first, rows = dims.second;
+    auto open = [&](int x, int y){
+        return _sokoban->get_floor_index(pii(x, y)) >= 0;
+    };
+    out.assign(rows*cols, -1);
+    std::queue<pii> q;
+    for (const pii& t: targets){
+        if (out[t.second*cols + t.first] >= 0) continue;
+        out[t.second*cols + t.first] = 0;
+        q.push(t);
+    }
+    while (!q.empty()){
+        pii cur = q.front(); q.pop();
+        int d0 = out[cur.second*cols + cur.first];
+        for (int d=0;d<4;++d){
+            int dx = DIR[d][0], dy = DIR[d][1];
+            // Towards the targets: which cell could a box be pushed into cur from?
+            // Away from them: where can a box at cur be pushed to? (player behind it either way)
+            int nx = reverse ? cur.first + dx : cur.first - dx;
+            int ny = reverse ? cur.second + dy : cur.second - dy;
+            int px = reverse ? cur.first - dx : nx - dx;
+            int py = reverse ? cur.second - dy : ny - dy;
+            if (!open(nx, ny) || !open(px, py) || out[ny*cols + nx] >= 0) continue;
+            out[ny*cols + nx] = d0 + 1;
+            q.push(pii(nx, ny));
+        }
+    }
+}
+
+int BidirectionalAgent::estimate(int side, const State* s) const{
+    const BoardState* bs = static_cast<const BoardState*>(s);
+    const std::vector<int>& dist = _sides[side]._box_dist;
+    int h = 0;
+    for (const std::pair<pii, int>& box_pii: bs->get_boxes()){
+        int d = dist[box_pii.first.second*_cols + box_pii.first.first];
+        if (d < 0) return -1;
+        h += d;
+    }
+    return h;
+}
+
+void BidirectionalAgent::add(int side, const std::shared_ptr<State>& s, const std::shared_ptr<Action>& a, int g, int parent){
+    size_t n = _sokoban->pack_key(s.get(), _key_buf.data());
+    if (!n) return;
+    Side& sd = _sides[side];
+    std::string key(reinterpret_cast<const char*>(_key_buf.data()), n);
+    meeting_table::iterator it = _table.find(key);
+    int id = it == _table.end() ? -1 : it->second._id[side];
+    int h;
+    if (id >= 0){
+        // Reopen (or re-sort) on a strictly cheaper path
+        Node& nd = sd._nodes[id];
+        if (g >= nd._g) return;
+        nd._state = s;
+        nd._action = a;
+        nd._g = g;
+        nd._parent = parent;
+        nd._closed = false;
+        h = nd._h;
+    }
+    else{
+        h = estimate(side, s.get());
+        if (h < 0) return;
+        if (it == _table.end()){
+            it = _table.insert(std::make_pair(key, Meeting{{-1, -1}})).first;
+            _bytes += key.size();
+        }
+        id = sd._nodes.size();
+        it->second._id[side] = id;
+        sd._nodes.push_back(Node{s, a, g, h, parent, false});
+        _bytes += s->footprint() + NODE_OVERHEAD;
+    }
+    sd._by_pr.push(Entry{std::max(g + h, 2*g), g, id});
+    sd._by_f.push(Entry{g + h, g, id});
+    sd._by_g.push(Entry{g, g, id});
+    int other = it->second._id[1 - side];
+    if (other >= 0 && g + _sides[1 - side]._nodes[other]._g < _best){
+        _best = g + _sides[1 - side]._nodes[other]._g;
+        _meet[side] = id;
+        _meet[1 - side] = other;
+    }
+}
+
+int BidirectionalAgent::top_key(Side& sd, std::priority_queue<Entry>& q) const{
+    while (!q.empty()){
+        const Entry& e = q.top();
+        const Node& nd = sd._nodes[e._id];
+        if (!nd._closed && nd._g == e._g) return e._key;
+        q.pop();
+    }
+    return -1;
+}
+
+int BidirectionalAgent::expand(int side, int id){
+    Side& sd = _sides[side];
+    sd._nodes[id]._closed = true;
+    sd._expanded++;
+    // Copied out, _nodes grows while the children are added
+    std::shared_ptr<State> s = sd._nodes[id]._state;
+    int g = sd._nodes[id]._g;
+    if (side == FORWARD){
+        std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+        int expand_code = _sokoban->get_successors(s.get(), vsa);
+        if (expand_code){
+            std::cerr << "(BidirectionalAgent::expand) get_successors failed with " << expand_code << std::endl;
+            return expand_code;
+        }
+        _stats.generated += vsa.size();
+        for (auto& sa: vsa) add(FORWARD, sa.first, sa.second, g + 1, id);
+        return Agent::SOLVE_STATUS::SOLVED;
+    }
+    const BoardState* bs = static_cast<const BoardState*>(s.get());
+    std::vector<std::shared_ptr<PositionAction>> vpa;
+    int expand_code = _sokoban->get_rev_actions(bs, vpa);
+    if (expand_code){
+        std::cerr << "(BidirectionalAgent::expand) get_rev_actions failed with " << expand_code << std::endl;
+        return expand_code;
+    }
+    for (std::shared_ptr<PositionAction>& pa: vpa){
+        std::shared_ptr<BoardState> prev = std::make_shared<BoardState>(*bs);
+        if (!_sokoban->play_rev_action(prev.get(), pa.get())) continue;
+        _stats.generated++;
+        add(BACKWARD, prev, pa, g + 1, id);
+    }
+    return Agent::SOLVE_STATUS::SOLVED;
+}
+
+int BidirectionalAgent::build_path(std::vector<std::shared_ptr<Action>>& va){
+    const Side& fwd = _sides[FORWARD];
+    const Side& bwd = _sides[BACKWARD];
+    std::vector<std::shared_ptr<Action>> path;
+    for (int id=_meet[FORWARD];fwd._nodes[id]._parent >= 0;id = fwd._nodes[id]._parent) path.push_back(fwd._nodes[id]._action);
+    std::reverse(path.begin(), path.end());
+    // Each pull undone as the push it reverses, from wherever the player really is
+    std::shared_ptr<State> cur = std::make_shared<BoardState>(*static_cast<const BoardState*>(fwd._nodes[_meet[FORWARD]]._state.get()));
+    for (int id=_meet[BACKWARD];bwd._nodes[id]._parent >= 0;id = bwd._nodes[id]._parent){
+        const PositionAction* pull = static_cast<const PositionAction*>(bwd._nodes[id]._action.get());
+        std::vector<std::shared_ptr<Action>> acts;
+        _sokoban->get_actions(cur.get(), acts);
+        std::shared_ptr<Action> push;
+        for (std::shared_ptr<Action>& a: acts){
+            const PositionAction* pa = static_cast<const PositionAction*>(a.get());
+            if (pa->_move_loc == pull->_move_loc && pa->_dir == pull->_dir){
+                push = a;
+                break;
+            }
+        }
+        if (!push || !_sokoban->play_action(cur.get(), push.get())){
+            std::cerr << "(BidirectionalAgent::build_path) Error: backward path does not replay forwards" << std::endl;
+            return Agent::SOLVE_STATUS::NO_SOLUTION;
+        }
+        path.push_back(push);
+    }
+    if (!_sokoban->is_goal_state(cur.get())){
+        std::cerr << "(BidirectionalAgent::build_path) Error: joined path does not reach a goal state" << std::endl;
+        return Agent::SOLVE_STATUS::NO_SOLUTION;
+    }
+    va.insert(va.end(), path.begin(), path.end());
+    return Agent::SOLVE_STATUS::SOLVED;
+}
+
+int BidirectionalAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    begin_solve();
+    for (Side& sd: _sides){
+        std::vector<Node>().swap(sd._nodes);
+        sd._by_pr = std::priority_queue<Entry>();
+        sd._by_f = std::priority_queue<Entry>();
+        sd._by_g = std::priority_queue<Entry>();
+        sd._expanded = 0;
+    }
+    _table.clear();
+    _best = INT_MAX;
+    _meet[0] = _meet[1] = -1;
+    _bytes = 0;
+    _cols = _sokoban->get_dims().first;
+    _key_buf.assign(_sokoban->max_packed_size(), 0);
+
+    std::shared_ptr<State> start = _sokoban->get_state();
+    std::vector<std::shared_ptr<State>> goals;
+    int goal_code = _sokoban->get_goal_states(goals);
+    if (goal_code){
+        std::cerr << "(BidirectionalAgent::solve) get_goal_states failed with " << goal_code << std::endl;
+        end_solve();
+        return goal_code;
+    }
+    std::vector<pii> goal_cells, start_cells;
+    for (const pii& p: static_cast<const BoardState*>(start.get())->get_goals()) goal_cells.push_back(p);
+    for (const std::pair<pii, int>& box_pii: static_cast<const BoardState*>(start.get())->get_boxes()) start_cells.push_back(box_pii.first);
+    push_distances(goal_cells, false, _sides[FORWARD]._box_dist);
+    push_distances(start_cells, true, _sides[BACKWARD]._box_dist);
+    add(FORWARD, start, nullptr, 0, -1);
+    for (std::shared_ptr<State>& gs: goals) add(BACKWARD, gs, nullptr, 0, -1);
+
+    auto finish = [&](int code){
+        check_budget(_sides[FORWARD]._expanded + _sides[BACKWARD]._expanded, _bytes, true);
+        end_solve();
+        if (_options.verbose){
+            std::cout << "Bidirectional expanded: " << _sides[FORWARD]._expanded << " forward, "
+                      << _sides[BACKWARD]._expanded << " backward (" << goals.size() << " goal regions)" << std::endl;
+            std::cout << "Bidirectional meeting table: " << _table.size() << " states" << std::endl;
+            if (code == Agent::SOLVE_STATUS::SOLVED) std::cout << "Bidirectional solution: " << _best << " pushes" << std::endl;
+        }
+        return code;
+    };
+
+    for (;;){
+        int budget_code = check_budget(_sides[FORWARD]._expanded + _sides[BACKWARD]._expanded, _bytes);
+        if (budget_code) return finish(budget_code);
+        int pr[2], f[2], g[2];
+        for (int i=0;i<2;++i){
+            pr[i] = top_key(_sides[i], _sides[i]._by_pr);
+            f[i] = top_key(_sides[i], _sides[i]._by_f);
+            g[i] = top_key(_sides[i], _sides[i]._by_g);
+        }
+        // A side with nothing left open has every state it can reach at its best g,
+        // so any meeting already happened
+        if (pr[FORWARD] < 0 || pr[BACKWARD] < 0){
+            if (_best == INT_MAX){
+                if (_options.verbose) std::cerr << "(BidirectionalAgent::solve) No solution path found..." << std::endl;
+                return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+            }
+            return finish(build_path(va));
+        }
+        int bound = std::max(std::max(std::min(pr[FORWARD], pr[BACKWARD]), std::max(f[FORWARD], f[BACKWARD])), g[FORWARD] + g[BACKWARD] + 1);
+        if (_best <= bound) return finish(build_path(va));
+        // Lower priority first, the smaller open list on ties
+        int side = FORWARD;
+        if (pr[BACKWARD] < pr[FORWARD] || (pr[BACKWARD] == pr[FORWARD] && _sides[BACKWARD]._by_pr.size() < _sides[FORWARD]._by_pr.size())) side = BACKWARD;
+        int id = _sides[side]._by_pr.top()._id;
+        _sides[side]._by_pr.pop();
+        int expand_code = expand(side, id);
+        if (expand_code) return finish(expand_code);
+    }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "Agent.h"
+#include "../game/Sokoban.h"
+#include <vector>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+
+// Push-optimal bidirectional search for Sokoban (MM, meet in the middle)
+// The forward side pushes boxes from the start. The backward side pulls them
+// (get_rev_actions / play_rev_action) from every goal state get_goal_states gives,
+// one per player region around the packed boxes, since the solution may end with
+// the player in any of them. Both sides share one meeting table keyed by
+// Sokoban::pack_key (boxes and player region), so a state one side generates is
+// matched against the other in the same lookup that deduplicates it.
+// Each push costs 1. h sums, over boxes, the pushes to the nearest goal (forward)
+// or the pulls back to the nearest start box cell (backward), ignoring other
+// boxes. A box that can reach none is dead, and its state is dropped; this is
+// what prunes forward branches that push boxes into corners. Each side expands
+// its lowest priority max(g + h, 2g), and the search stops as soon as the best
+// meeting cost U satisfies U <= max(C, fmin_F, fmin_B, gmin_F + gmin_B + 1), C being
+// the smaller of the two sides' lowest priorities. U is then the fewest pushes.
+// The returned actions are forward pushes, costed by the player's actual walk.
+class BidirectionalAgent: public Agent{
+    public:
+        enum SIDE{
+            FORWARD     = 0,
+            BACKWARD    = 1
+        };
+    private:
+        struct Node{
+            std::shared_ptr<State> _state;
+            std::shared_ptr<Action> _action;    // From _parent (backward: the pull)
+            int _g, _h, _parent;
+            bool _closed;
+        };
+        // Lazy open-list entry, stale once its node closes or its g improves
+        struct Entry{
+            int _key, _g, _id;
+            // Lowest key first, then deepest (std::priority_queue pops the largest)
+            bool operator<(const Entry& o) const{
+                if (_key != o._key) return _key > o._key;
+                if (_g != o._g) return _g < o._g;
+                return _id < o._id;
+            }
+        };
+        struct Side{
+            std::vector<Node> _nodes;
+            std::priority_queue<Entry> _by_pr, _by_f, _by_g;
+            std::vector<int> _box_dist;     // Per grid cell, -1 if no target is reachable
+            long long _expanded;
+        };
+        // Node ids of a packed state on each side (-1: not generated)
+        struct Meeting{
+            int _id[2];
+        };
+        struct KeyHash{
+            size_t operator()(const std::string& k) const;
+        };
+        typedef std::unordered_map<std::string, Meeting, KeyHash> meeting_table;
+        // Bytes charged per node on top of its state's footprint (node, heap and table entries)
+        static const size_t NODE_OVERHEAD = 160;
+
+        Sokoban* _sokoban;
+        Side _sides[2];
+        meeting_table _table;
+        std::vector<uint8_t> _key_buf;
+        int _cols;
+        int _best;                  // U, cheapest meeting so far
+        int _meet[2];
+        size_t _bytes;
+
+        // Pushes from every cell to the nearest of targets, or from the nearest of them (reverse)
+        void push_distances(const std::vector<pii>& targets, bool reverse, std::vector<int>& out) const;
+        // Sum of _box_dist over boxes, -1 if a box is dead
+        int estimate(int side, const State* s) const;
+        // Add or improve a node, then check the meeting table for the other side
+        void add(int side, const std::shared_ptr<State>& s, const std::shared_ptr<Action>& a, int g, int parent);
+        // Lowest live key of heap (drops stale tops), -1 if empty
+        int top_key(Side& sd, std::priority_queue<Entry>& q) const;
+        int expand(int side, int id);
+        // Forward actions start -> meeting -> goal, replayed on the real states
+        int build_path(std::vector<std::shared_ptr<Action>>& va);
+    public:
+        BidirectionalAgent(Sokoban* sok);
+        virtual ~BidirectionalAgent();
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+        // States expanded by one side in the last solve
+        long long get_expanded(int side) const;
+};
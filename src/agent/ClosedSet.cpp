@@ -0,0 +1,106 @@
+#include "ClosedSet.h"
+#include "../util/Hash.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Hash set node and bucket overhead charged on top of each state
+static const size_t EXACT_ENTRY_OVERHEAD = 48;
+
+bool ExactClosedSet::insert(const std::shared_ptr<State>& s){
+    if (!_states.insert(s).second) return false;
+    _bytes += s->footprint() + EXACT_ENTRY_OVERHEAD;
+    return true;
+}
+
+bool ExactClosedSet::contains(const std::shared_ptr<State>& s) const{
+    return _states.find(s) != _states.end();
+}
+
+void ExactClosedSet::clear(){
+    _states.clear();
+    _bytes = 0;
+}
+
+void ExactClosedSet::report(std::ostream& os) const{
+    os << "exact closed set: " << size() << " states, " << memory_bytes()/1024 << " KB ("
+       << (size() ? (double)memory_bytes()/size() : 0.0) << " B/state)";
+}
+
+BitstateClosedSet::BitstateClosedSet(const Game* g, size_t bytes, int k)
+    :_game(g), _k(k < 1 ? 1 : k), _count(0), _bits_set(0), _omissions(0), _buf(g->max_packed_size()){
+    size_t words = 1;
+    while (words*2*sizeof(uint64_t) <= bytes) words *= 2;
+    _bits.assign(words, 0);
+    _mask = words*64 - 1;
+}
+
+void BitstateClosedSet::hash_pair(const State* s, uint64_t& h1, uint64_t& h2) const{
+    if (!_buf.empty() && _game->pack_key(s, _buf.data())){
+        h1 = hash_bytes(_buf.data(), _buf.size(), 0x243f6a8885a308d3ULL);
+        h2 = hash_bytes(_buf.data(), _buf.size(), 0x13198a2e03707344ULL);
+    }
+    else{
+        uint64_t h = s->hash();
+        h1 = mix64(h ^ 0x243f6a8885a308d3ULL);
+        h2 = mix64(h ^ 0x13198a2e03707344ULL);
+    }
+    // Odd stride visits every bit of a power-of-2 array before repeating
+    h2 |= 1;
+}
+
+bool BitstateClosedSet::insert(const std::shared_ptr<State>& s){
+    uint64_t h1, h2;
+    hash_pair(s.get(), h1, h2);
+    double p = omission_probability();
+    bool fresh = false;
+    for (int i=0;i<_k;++i){
+        uint64_t bit = (h1 + i*h2) & _mask;
+        uint64_t& word = _bits[bit >> 6];
+        uint64_t m = 1ULL << (bit & 63);
+        if (!(word & m)){
+            word |= m;
+            _bits_set++;
+            fresh = true;
+        }
+    }
+    if (!fresh){
+        // Either seen before or an omission, the two cannot be told apart
+        return false;
+    }
+    _count++;
+    _omissions += p;
+    return true;
+}
+
+bool BitstateClosedSet::contains(const std::shared_ptr<State>& s) const{
+    uint64_t h1, h2;
+    hash_pair(s.get(), h1, h2);
+    for (int i=0;i<_k;++i){
+        uint64_t bit = (h1 + i*h2) & _mask;
+        if (!(_bits[bit >> 6] & (1ULL << (bit & 63)))) return false;
+    }
+    return true;
+}
+
+void BitstateClosedSet::clear(){
+    std::fill(_bits.begin(), _bits.end(), 0);
+    _count = 0;
+    _bits_set = 0;
+    _omissions = 0;
+}
+
+double BitstateClosedSet::fill() const{
+    return (double)_bits_set/(double)(_mask + 1);
+}
+
+double BitstateClosedSet::omission_probability() const{
+    return std::pow(fill(), _k);
+}
+
+void BitstateClosedSet::report(std::ostream& os) const{
+    os << "bitstate closed set: " << size() << " states, " << memory_bytes()/1024 << " KB ("
+       << (size() ? (double)memory_bytes()/size() : 0.0) << " B/state), k=" << _k
+       << ", fill " << 100.0*fill() << "%, omission p=" << omission_probability()
+       << ", expected omissions " << expected_omissions();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "../game/Game.h"
+#include <vector>
+#include <memory>
+#include <unordered_set>
+#include <cstdint>
+#include <iostream>
+
+// States a search has already seen
+// Agents that only need some solution (GreedyAgent, BeamAgent, DepthFirstAgent)
+// take any ClosedSet, so the exact set can be swapped for a bitstate one when the
+// state space is too big to store.
+class ClosedSet{
+    public:
+        virtual ~ClosedSet(){};
+        // Add s
+        // @return false if s was already present (or, for approximate sets, looks it)
+        virtual bool insert(const std::shared_ptr<State>& s) = 0;
+        virtual bool contains(const std::shared_ptr<State>& s) const = 0;
+        virtual void clear() = 0;
+        // States inserted
+        virtual size_t size() const = 0;
+        // Estimated bytes held
+        virtual size_t memory_bytes() const = 0;
+        // Whether present is only ever reported for states really inserted
+        virtual bool is_exact() const{return true;}
+        // Chance that the next new state is wrongly reported as present (0 when exact)
+        virtual double omission_probability() const{return 0;}
+        // Expected number of new states so far wrongly reported as present (0 when exact)
+        virtual double expected_omissions() const{return 0;}
+        // One line summary for search logs
+        virtual void report(std::ostream& os) const = 0;
+};
+
+// Full states in a hash set
+class ExactClosedSet: public ClosedSet{
+    private:
+        std::unordered_set<std::shared_ptr<State>, StatePointerHash, DerefCompare> _states;
+        size_t _bytes;
+    public:
+        ExactClosedSet():_bytes(0){}
+        virtual bool insert(const std::shared_ptr<State>& s) override;
+        virtual bool contains(const std::shared_ptr<State>& s) const override;
+        virtual void clear() override;
+        virtual size_t size() const override{return _states.size();}
+        virtual size_t memory_bytes() const override{return _bytes;}
+        virtual void report(std::ostream& os) const override;
+};
+
+// Bitstate hashing (Holzmann's supertrace)
+// Each state sets k bits of one preallocated bit array, chosen by double hashing
+// of its Game::pack_key bytes (State::hash when the game cannot pack). A state counts
+// as present when all k bits are set, so distinct states can collide and part of
+// the space is silently skipped. The cost is a fixed m bits, however many states
+// are inserted. The chance of an omission grows with the fraction of bits set
+// (p = fill^k), and the sum of p over insertions estimates how many states were
+// lost. With m around 8 bits per state and k = 3, the array costs about one byte
+// per state and p stays near 3%.
+class BitstateClosedSet: public ClosedSet{
+    private:
+        const Game* _game;
+        std::vector<uint64_t> _bits;
+        uint64_t _mask;         // Bit count - 1 (a power of 2)
+        int _k;
+        size_t _count, _bits_set;
+        double _omissions;
+        mutable std::vector<uint8_t> _buf;
+        // Two independent 64-bit hashes of s
+        void hash_pair(const State* s, uint64_t& h1, uint64_t& h2) const;
+    public:
+        // bytes is rounded down to a power of 2 (at least 8), k hashes per state
+        BitstateClosedSet(const Game* g, size_t bytes, int k=3);
+        virtual bool insert(const std::shared_ptr<State>& s) override;
+        virtual bool contains(const std::shared_ptr<State>& s) const override;
+        virtual void clear() override;
+        virtual size_t size() const override{return _count;}
+        virtual size_t memory_bytes() const override{return _bits.size()*sizeof(uint64_t);}
+        virtual bool is_exact() const override{return false;}
+        virtual double omission_probability() const override;
+        virtual double expected_omissions() const override{return _omissions;}
+        virtual void report(std::ostream& os) const override;
+        // Fraction of bits set
+        double fill() const;
+        int get_k() const{return _k;}
+};
@@ -0,0 +1,182 @@
+#include "DepthFirstAgent.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// Stack bytes charged per held state on top of its footprint
+static const size_t STACK_ENTRY_OVERHEAD = 48;
+
+DepthFirstAgent::DepthFirstAgent(Game* g, Heuristic* h)
+    :Agent(g), search_heuristic(h), _incremental(true), _tree(false), _depth_limit(0), _closed(nullptr), _automaton(nullptr), _pruned(0){}
+
+DepthFirstAgent::~DepthFirstAgent(){
+    search_problem = nullptr;
+    search_heuristic = nullptr;
+    _closed = nullptr;
+    _automaton = nullptr;
+}
+
+void DepthFirstAgent::set_incremental(bool b){
+    _incremental = b;
+}
+
+void DepthFirstAgent::set_depth_limit(int d){
+    _depth_limit = d;
+}
+
+void DepthFirstAgent::set_tree_search(bool b){
+    _tree = b;
+}
+
+void DepthFirstAgent::set_closed_set(ClosedSet* c){
+    _closed = c;
+}
+
+void DepthFirstAgent::set_move_automaton(const MoveAutomaton* m){
+    _automaton = m;
+}
+
+int DepthFirstAgent::expand(Frame& f, const State* grandparent, ClosedSet* closed, bool incremental, const MoveAutomaton* fsm){
+    perf_phase(PerfCounters::SUCCESSORS);
+    std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+    int expand_code = search_problem->get_successors(f._state.get(), vsa);
+    if (expand_code) return expand_code;
+    _stats.generated += vsa.size();
+    std::vector<double> vh;
+    std::vector<size_t> keep;
+    std::vector<int> vq;
+    for (size_t i=0;i<vsa.size();++i){
+        perf_phase(PerfCounters::LOOKUP);
+        int q = 0;
+        if (fsm){
+            q = fsm->next(f._fsm, search_problem->action_code(f._state.get(), vsa[i].second.get()));
+            if (q == MoveAutomaton::REJECT){
+                _pruned++;
+                continue;
+            }
+        }
+        // Marked when generated, so a sibling's subtree does not enter it first
+        if (closed ? !closed->insert(vsa[i].first) : grandparent && *vsa[i].first == *grandparent) continue;
+        perf_phase(PerfCounters::HEURISTIC);
+        double h = incremental ? search_heuristic->score_child(f._h, f._state.get(), vsa[i].second.get(), vsa[i].first.get(), search_problem)
+                               : search_heuristic->score(vsa[i].first.get(), search_problem);
+        if (std::isinf(h)) continue;
+        vh.push_back(h);
+        keep.push_back(i);
+        vq.push_back(q);
+    }
+    // Best h at the back, ties keep generation order
+    perf_phase(PerfCounters::OPEN_LIST);
+    std::vector<size_t> order(keep.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&vh](size_t a, size_t b){return vh[a] > vh[b];});
+    for (size_t j: order){
+        f._children.push_back(vsa[keep[j]]);
+        f._child_h.push_back(vh[j]);
+        f._child_fsm.push_back(vq[j]);
+    }
+    return Agent::SOLVE_STATUS::SOLVED;
+}
+
+int DepthFirstAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    begin_solve();
+    ClosedSet* closed = _tree ? nullptr : _closed ? _closed : &_exact;
+    if (closed) closed->clear();
+    _pruned = 0;
+    const MoveAutomaton* fsm = _automaton;
+    if (fsm && fsm->codes() != search_problem->action_codes()){
+        std::cerr << "(DepthFirstAgent::solve) Error: move automaton has " << fsm->codes() << " action codes, game has "
+                  << search_problem->action_codes() << " (searching without it)" << std::endl;
+        fsm = nullptr;
+    }
+    if (fsm && closed && closed->is_exact()){
+        std::cerr << "(DepthFirstAgent::solve) Error: move automaton needs tree search or a bitstate closed set, "
+                  << "the exact closed set already drops its duplicates (searching without it)" << std::endl;
+        fsm = nullptr;
+    }
+    bool incremental = _incremental && search_heuristic->is_incremental();
+    long long num_states = 0;
+    size_t max_depth = 0, stack_bytes = 0;
+    auto held = [&](){return (closed ? closed->memory_bytes() : 0) + stack_bytes;};
+
+    std::shared_ptr<State> root = search_problem->get_state();
+    double root_h = search_heuristic->score(root.get(), search_problem);
+    std::vector<Frame> stack;
+    int limit = _tree ? 1 : _depth_limit;
+
+    auto finish = [&](int code){
+        check_budget(num_states, held(), true);
+        end_solve();
+        if (_options.verbose){
+            std::cout << "DFS visited: " << num_states << " States, deepest path " << max_depth << " moves";
+            if (_tree) std::cout << ", last depth limit " << limit;
+            std::cout << std::endl;
+            if (fsm) std::cout << "DFS move automaton: " << _pruned << " moves pruned (" << fsm->states() << " states)" << std::endl;
+            if (closed){
+                std::cout << "DFS ";
+                closed->report(std::cout);
+                std::cout << std::endl;
+            }
+        }
+        return code;
+    };
+
+    while (true){
+        stack.assign(1, Frame());
+        stack[0]._state = root;
+        stack[0]._h = root_h;
+        stack[0]._fsm = 0;
+        if (closed) closed->insert(root);
+        stack_bytes = 0;
+        bool fresh = true;  // Top frame just entered
+        bool cut = false;   // Some path stopped at the depth limit
+        while (!stack.empty()){
+            Frame& top = stack.back();
+            if (fresh){
+                perf_phase(PerfCounters::OTHER);
+                fresh = false;
+                int budget_code = check_budget(num_states, held());
+                if (budget_code) return finish(budget_code);
+                if (search_problem->is_goal_state(top._state.get())){
+                    for (size_t i=1;i<stack.size();++i) va.push_back(stack[i]._action);
+                    return finish(Agent::SOLVE_STATUS::SOLVED);
+                }
+                max_depth = std::max(max_depth, stack.size() - 1);
+                if (limit <= 0 || (int)stack.size() - 1 < limit){
+                    num_states++;
+                    const State* grandparent = stack.size() > 1 ? stack[stack.size() - 2]._state.get() : nullptr;
+                    int expand_code = expand(top, grandparent, closed, incremental, fsm);
+                    if (expand_code){
+                        std::cerr << "(DepthFirstAgent::solve) get_successors failed with " << expand_code << std::endl;
+                        return finish(expand_code);
+                    }
+                    for (size_t i=0;i<top._children.size();++i) stack_bytes += top._children[i].first->footprint() + STACK_ENTRY_OVERHEAD;
+                }
+                else cut = true;
+            }
+            perf_phase(PerfCounters::OPEN_LIST);
+            if (top._children.empty()){
+                // Exhausted, back up
+                stack.pop_back();
+                continue;
+            }
+            Frame child;
+            child._state = top._children.back().first;
+            child._action = top._children.back().second;
+            child._h = top._child_h.back();
+            child._fsm = top._child_fsm.back();
+            top._children.pop_back();
+            top._child_h.pop_back();
+            top._child_fsm.pop_back();
+            // Charged while it waited as a sibling (frames themselves are not counted)
+            stack_bytes -= std::min(stack_bytes, child._state->footprint() + STACK_ENTRY_OVERHEAD);
+            stack.push_back(std::move(child));
+            fresh = true;
+        }
+        // Tree search: one move deeper, unless nothing reached the limit
+        if (!_tree || !cut || (_depth_limit > 0 && limit >= _depth_limit)) break;
+        limit++;
+    }
+    if (_options.verbose) std::cerr << "(DepthFirstAgent::solve) No solution path found..." << std::endl;
+    return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+}
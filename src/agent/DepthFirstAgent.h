@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Agent.h"
+#include "ClosedSet.h"
+#include "MoveAutomaton.h"
+#include "../game/Game.h"
+#include "../heuristic/Heuristic.h"
+#include <vector>
+#include <memory>
+
+// Depth-first search with an explicit stack, trying children in order of h
+// Only the current path and its untried siblings are held, so with a
+// BitstateClosedSet this is supertrace search: about a byte per visited state.
+// States seen anywhere before are never entered again, even if reached by a
+// shorter path, so solutions can be long. set_depth_limit caps the path length.
+// Tree search (set_tree_search) keeps no closed set: iterative deepening to the
+// depth limit, skipping only moves straight back to the grandparent.
+// With a MoveAutomaton, each frame carries its automaton state and moves the
+// automaton rejects are dropped before their states are hashed or scored. An
+// exact closed set already catches every duplicate the automaton would, and the
+// pruning only reorders the search, so the automaton is used in tree search or
+// with a BitstateClosedSet and ignored otherwise.
+class DepthFirstAgent: public Agent{
+    private:
+        struct Frame{
+            std::shared_ptr<State> _state;
+            std::shared_ptr<Action> _action;    // Move into _state (null at the root)
+            double _h;
+            int _fsm;                           // Move automaton state after _action
+            // Children not yet entered, best h last
+            std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> _children;
+            std::vector<double> _child_h;
+            std::vector<int> _child_fsm;
+        };
+        Heuristic* search_heuristic;
+        bool _incremental;
+        bool _tree;
+        int _depth_limit;
+        ClosedSet* _closed;
+        ExactClosedSet _exact;
+        const MoveAutomaton* _automaton;
+        long long _pruned;
+        // Fill f's children (not in closed, or without one not grandparent; not dead;
+        // allowed by fsm if any) sorted for popping from the back
+        int expand(Frame& f, const State* grandparent, ClosedSet* closed, bool incremental, const MoveAutomaton* fsm);
+    public:
+        DepthFirstAgent(Game* g, Heuristic* h);
+        // Destructor (don't destroy heuristic or closed set)
+        virtual ~DepthFirstAgent();
+        // Toggle per-move heuristic deltas (on by default)
+        void set_incremental(bool b);
+        // Longest path explored in moves (0: unlimited)
+        void set_depth_limit(int d);
+        // Iterative deepening without a closed set (off by default)
+        void set_tree_search(bool b);
+        // Closed set used by solve (not owned, null: an exact set)
+        void set_closed_set(ClosedSet* c);
+        // Duplicate move sequences to skip (not owned, null: none), built for this game's action codes
+        // Only used in tree search or with an inexact closed set
+        void set_move_automaton(const MoveAutomaton* m);
+        // Moves the automaton rejected in the last solve
+        long long get_pruned() const{return _pruned;}
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+};
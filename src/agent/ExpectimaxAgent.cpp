@@ -0,0 +1,71 @@
+#include "ExpectimaxAgent.h"
+#include <cmath>
+
+ExpectimaxAgent::ExpectimaxAgent(AdversarialGame* g):AdversarialAgent(g), _root_player(AdversarialGame::MAX_PLAYER){}
+
+void ExpectimaxAgent::prepare(const State* root){
+    _root_player = _game->to_move(root);
+    _tt.clear();
+}
+
+int ExpectimaxAgent::expectimax(Worker& w, int depth, int ply){
+    if (visit(w)) return 0;
+    State* s = w._state.get();
+    if (depth == 0 || _game->is_terminal(s)) return leaf_value(s, _root_player, ply);
+    uint64_t key = _game->key(s);
+    TranspositionTable::Entry e;
+    int tt_move = -1;
+    if (_tt.probe(key, e)){
+        tt_move = e.move;
+        if (ply > 0 && e.depth >= depth) return from_tt(e.value, ply);
+    }
+    int side = _game->to_move(s);
+    int n = order_moves(w, ply, side, tt_move);
+    if (n == 0) return leaf_value(s, _root_player, ply);
+    const int* moves = &w._moves[ply*_game->max_moves()];
+    int value, best_move = -1;
+    if (side == _root_player){
+        value = -INF;
+        for (int i=0;i<n;++i){
+            _game->make_move(s, moves[i]);
+            int v = expectimax(w, depth - 1, ply + 1);
+            _game->undo_move(s, moves[i]);
+            if (w._aborted) return 0;
+            if (v > value){
+                value = v;
+                best_move = moves[i];
+            }
+        }
+    }
+    else if (side == AdversarialGame::CHANCE){
+        double sum = 0;
+        for (int i=0;i<n;++i){
+            double p = _game->move_probability(s, moves[i]);
+            _game->make_move(s, moves[i]);
+            int v = expectimax(w, depth - 1, ply + 1);
+            _game->undo_move(s, moves[i]);
+            if (w._aborted) return 0;
+            sum += p*v;
+        }
+        value = (int)std::lround(sum);
+    }
+    else{
+        // Uniform opponent, summed exactly so the value does not depend on move order
+        long long sum = 0;
+        for (int i=0;i<n;++i){
+            _game->make_move(s, moves[i]);
+            int v = expectimax(w, depth - 1, ply + 1);
+            _game->undo_move(s, moves[i]);
+            if (w._aborted) return 0;
+            sum += v;
+        }
+        value = (int)std::lround((double)sum/n);
+    }
+    _tt.store(key, to_tt(value, ply), depth, TranspositionTable::EXACT, best_move);
+    if (ply == 0) w._root_move = best_move;
+    return value;
+}
+
+int ExpectimaxAgent::search_root(Worker& w, int depth){
+    return expectimax(w, depth, 0);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "AdversarialAgent.h"
+
+// Expectimax: the side to move at the root maximizes, CHANCE nodes average their
+// outcomes by move_probability, and the other player is modelled as moving
+// uniformly at random (it averages too). Values are from the root player's view.
+// Averages cannot be pruned, so every node is searched to the full depth; the
+// transposition table (exact values, cleared every solve since they depend on
+// the root player) merges transpositions and carries best moves between iterations.
+class ExpectimaxAgent: public AdversarialAgent{
+    private:
+        int _root_player;
+        int expectimax(Worker& w, int depth, int ply);
+    protected:
+        virtual int search_root(Worker& w, int depth) override;
+        virtual void prepare(const State* root) override;
+        virtual const char* name() const override{return "Expectimax";}
+    public:
+        ExpectimaxAgent(AdversarialGame* g);
+        virtual ~ExpectimaxAgent(){};
+};
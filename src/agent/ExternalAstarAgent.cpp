@@ -0,0 +1,443 @@
+#include "ExternalAstarAgent.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Records move between memory and disk through buffers of about this size
+static const size_t IO_BUFFER_BYTES = 1 << 20;
+
+// Appends fixed-size records to a file through one large buffer
+class RecordWriter{
+    private:
+        FILE* _f;
+        std::vector<uint8_t> _buf;
+        size_t _used;
+        long long* _written;
+        bool _ok;
+    public:
+        RecordWriter(const std::string& path, size_t record_bytes, long long* written, const char* mode="wb")
+            :_f(fopen(path.c_str(), mode)), _buf(std::max<size_t>(1, IO_BUFFER_BYTES/record_bytes)*record_bytes),
+             _used(0), _written(written), _ok(_f != nullptr){
+            if (!_f) std::cerr << "(RecordWriter) Error: cannot open " << path << std::endl;
+        }
+        ~RecordWriter(){close();}
+        void put(const uint8_t* data, size_t n){
+            if (_used + n > _buf.size()) flush();
+            memcpy(_buf.data() + _used, data, n);
+            _used += n;
+        }
+        void flush(){
+            if (_f && _used){
+                _ok = fwrite(_buf.data(), 1, _used, _f) == _used && _ok;
+                *_written += _used;
+            }
+            _used = 0;
+        }
+        // @return false if any write failed
+        bool close(){
+            if (!_f) return false;
+            flush();
+            _ok = (fclose(_f) == 0) && _ok;
+            _f = nullptr;
+            return _ok;
+        }
+};
+
+// Streams fixed-size records out of a file through one large buffer
+class RecordReader{
+    private:
+        FILE* _f;
+        std::vector<uint8_t> _buf;
+        size_t _record, _pos, _len;
+        long long* _read;
+    public:
+        RecordReader(const std::string& path, size_t record_bytes, long long* read)
+            :_f(fopen(path.c_str(), "rb")), _buf(std::max<size_t>(1, IO_BUFFER_BYTES/record_bytes)*record_bytes),
+             _record(record_bytes), _pos(0), _len(0), _read(read){
+            if (!_f) std::cerr << "(RecordReader) Error: cannot open " << path << std::endl;
+        }
+        ~RecordReader(){if (_f) fclose(_f);}
+        bool ok() const{return _f != nullptr;}
+        // @return the next record (valid until the following call), nullptr at the end
+        const uint8_t* next(){
+            if (_pos + _record > _len){
+                if (!_f) return nullptr;
+                _len = fread(_buf.data(), 1, _buf.size(), _f);
+                _len -= _len % _record;
+                _pos = 0;
+                *_read += _len;
+                if (!_len) return nullptr;
+            }
+            const uint8_t* r = _buf.data() + _pos;
+            _pos += _record;
+            return r;
+        }
+};
+
+ExternalAstarAgent::ExternalAstarAgent(Game* g, Heuristic* h, double weight)
+    :Agent(g), search_heuristic(h), _w(weight), _incremental(true), _temp_root("/tmp"),
+     _sort_memory(64 << 20), _keep_files(false), _state_bytes(0), _record_bytes(0), _next_file(0){}
+
+ExternalAstarAgent::~ExternalAstarAgent(){
+    remove_files();
+    search_problem = nullptr;
+    search_heuristic = nullptr;
+}
+
+void ExternalAstarAgent::set_weight(double d){
+    _w = d;
+}
+
+void ExternalAstarAgent::set_incremental(bool b){
+    _incremental = b;
+}
+
+void ExternalAstarAgent::set_temp_dir(const std::string& dir){
+    _temp_root = dir;
+}
+
+void ExternalAstarAgent::set_sort_memory(size_t bytes){
+    _sort_memory = bytes;
+}
+
+void ExternalAstarAgent::set_keep_files(bool b){
+    _keep_files = b;
+}
+
+std::string ExternalAstarAgent::new_file(){
+    return _dir + "/" + std::to_string(_next_file++) + ".rec";
+}
+
+bool ExternalAstarAgent::append(const BucketKey& key, const uint8_t* record){
+    Bucket& b = _open[key];
+    if (b.path.empty()) b.path = new_file();
+    b.pending.insert(b.pending.end(), record, record + _record_bytes);
+    b.records++;
+    if (b.pending.size() >= BUCKET_FLUSH_BYTES) return flush(b);
+    return true;
+}
+
+bool ExternalAstarAgent::flush(Bucket& b){
+    if (b.pending.empty()) return true;
+    RecordWriter w(b.path, _record_bytes, &_stats.bytes_written, "ab");
+    w.put(b.pending.data(), b.pending.size());
+    b.pending.clear();
+    b.pending.shrink_to_fit();
+    return w.close();
+}
+
+bool ExternalAstarAgent::sort_file(const std::string& in_path, std::string& out_path){
+    const size_t R = _record_bytes;
+    const size_t S = _state_bytes;
+    size_t capacity = std::max<size_t>(1, _sort_memory/R);
+    RecordReader in(in_path, R, &_stats.bytes_read);
+    if (!in.ok()) return false;
+    std::vector<std::string> runs;
+    std::vector<uint8_t> chunk;
+    std::vector<uint32_t> order;
+    bool done = false;
+    while (!done){
+        // Fill one sort buffer
+        chunk.clear();
+        const uint8_t* r;
+        while (chunk.size() < capacity*R && (r = in.next())) chunk.insert(chunk.end(), r, r + R);
+        done = chunk.size() < capacity*R;
+        if (chunk.empty()) break;
+        size_t n = chunk.size()/R;
+        order.resize(n);
+        for (size_t i=0;i<n;++i) order[i] = i;
+        const uint8_t* base = chunk.data();
+        std::sort(order.begin(), order.end(), [base, R](uint32_t a, uint32_t b){
+            return memcmp(base + a*R, base + b*R, R) < 0;
+        });
+        // Write the sorted run, keeping the first record of each state
+        runs.push_back(new_file());
+        RecordWriter w(runs.back(), R, &_stats.bytes_written);
+        const uint8_t* last = nullptr;
+        for (size_t i=0;i<n;++i){
+            const uint8_t* rec = base + order[i]*R;
+            if (last && !memcmp(last, rec, S)) continue;
+            w.put(rec, R);
+            last = rec;
+        }
+        if (!w.close()) return false;
+    }
+    remove(in_path.c_str());
+    if (runs.size() == 1){
+        out_path = runs[0];
+        return true;
+    }
+    out_path = new_file();
+    bool ok = merge_files(runs, out_path);
+    for (const std::string& run: runs) remove(run.c_str());
+    return ok;
+}
+
+bool ExternalAstarAgent::merge_files(const std::vector<std::string>& runs, const std::string& out_path){
+    const size_t R = _record_bytes;
+    const size_t S = _state_bytes;
+    std::vector<std::unique_ptr<RecordReader>> readers;
+    std::vector<const uint8_t*> heads;
+    for (const std::string& run: runs){
+        readers.emplace_back(new RecordReader(run, R, &_stats.bytes_read));
+        if (!readers.back()->ok()) return false;
+        heads.push_back(readers.back()->next());
+    }
+    // Min-heap of reader indices on their current record
+    auto greater = [&heads, R](int a, int b){
+        return memcmp(heads[a], heads[b], R) > 0;
+    };
+    std::priority_queue<int, std::vector<int>, decltype(greater)> heap(greater);
+    for (size_t i=0;i<heads.size();++i){
+        if (heads[i]) heap.push(i);
+    }
+    RecordWriter w(out_path, R, &_stats.bytes_written);
+    std::vector<uint8_t> last;
+    while (!heap.empty()){
+        int i = heap.top();
+        heap.pop();
+        if (last.empty() || memcmp(last.data(), heads[i], S)){
+            w.put(heads[i], R);
+            last.assign(heads[i], heads[i] + R);
+        }
+        heads[i] = readers[i]->next();
+        if (heads[i]) heap.push(i);
+    }
+    return w.close();
+}
+
+bool ExternalAstarAgent::subtract_closed(const std::string& sorted_path, const std::string& out_path, uint64_t& kept){
+    const size_t R = _record_bytes;
+    const size_t S = _state_bytes;
+    RecordReader in(sorted_path, R, &_stats.bytes_read);
+    std::vector<std::unique_ptr<RecordReader>> closed;
+    std::vector<const uint8_t*> heads;
+    for (const std::string& run: _closed){
+        closed.emplace_back(new RecordReader(run, R, &_stats.bytes_read));
+        heads.push_back(closed.back()->next());
+    }
+    RecordWriter w(out_path, R, &_stats.bytes_written);
+    kept = 0;
+    // One sequential pass over the bucket and every closed run
+    while (const uint8_t* rec = in.next()){
+        bool duplicate = false;
+        for (size_t j=0;j<closed.size();++j){
+            while (heads[j] && memcmp(heads[j], rec, S) < 0) heads[j] = closed[j]->next();
+            if (heads[j] && !memcmp(heads[j], rec, S)) duplicate = true;
+        }
+        if (duplicate) continue;
+        w.put(rec, R);
+        kept++;
+    }
+    return w.close() && in.ok();
+}
+
+bool ExternalAstarAgent::compact_closed(){
+    if ((int)_closed.size() <= MAX_CLOSED_RUNS) return true;
+    std::string merged = new_file();
+    if (!merge_files(_closed, merged)) return false;
+    for (const std::string& run: _closed) remove(run.c_str());
+    _closed.assign(1, merged);
+    return true;
+}
+
+bool ExternalAstarAgent::find_closed(const uint8_t* state, std::vector<uint8_t>& record){
+    const size_t R = _record_bytes;
+    const size_t S = _state_bytes;
+    for (const std::string& run: _closed){
+        int fd = open(run.c_str(), O_RDONLY);
+        if (fd < 0) continue;
+        struct stat st;
+        if (fstat(fd, &st) || st.st_size < (off_t)R){
+            close(fd);
+            continue;
+        }
+        void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED) continue;
+        const uint8_t* base = static_cast<const uint8_t*>(map);
+        size_t lo = 0, hi = st.st_size/R;
+        bool found = false;
+        while (lo < hi){
+            size_t mid = (lo + hi)/2;
+            int c = memcmp(base + mid*R, state, S);
+            _stats.bytes_read += R;
+            if (!c){
+                record.assign(base + mid*R, base + (mid+1)*R);
+                found = true;
+                break;
+            }
+            if (c < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        munmap(map, st.st_size);
+        if (found) return true;
+    }
+    return false;
+}
+
+int ExternalAstarAgent::trace_back(const uint8_t* goal_record, std::vector<std::shared_ptr<Action>>& va){
+    const size_t S = _state_bytes;
+    std::vector<uint8_t> rec(goal_record, goal_record + _record_bytes), parent_rec, packed(S);
+    // The start state is its own parent
+    while (memcmp(rec.data(), rec.data() + S, S)){
+        double g, parent_g;
+        memcpy(&g, rec.data() + 2*S, sizeof(double));
+        std::shared_ptr<State> parent;
+        if (!find_closed(rec.data() + S, parent_rec) || !(parent = search_problem->unpack(parent_rec.data(), S))){
+            std::cerr << "(ExternalAstarAgent::trace_back) Error: parent record missing from the closed runs" << std::endl;
+            return Agent::SOLVE_STATUS::NO_SOLUTION;
+        }
+        memcpy(&parent_g, parent_rec.data() + 2*S, sizeof(double));
+        // Regenerate the parent's moves and take the cheapest one reaching this state at this g
+        std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+        search_problem->get_successors(parent.get(), vsa);
+        std::shared_ptr<Action> best = nullptr;
+        for (size_t i=0;i<vsa.size();++i){
+            if (!search_problem->pack(vsa[i].first.get(), packed.data()) || memcmp(packed.data(), rec.data(), S)) continue;
+            if (std::fabs(parent_g + vsa[i].second->_cost - g) > 1e-9) continue;
+            if (!best || vsa[i].second->_cost < best->_cost) best = vsa[i].second;
+        }
+        if (!best){
+            std::cerr << "(ExternalAstarAgent::trace_back) Error: no move leads from a parent record to its child" << std::endl;
+            return Agent::SOLVE_STATUS::NO_SOLUTION;
+        }
+        va.push_back(best);
+        rec.swap(parent_rec);
+    }
+    std::reverse(va.begin(), va.end());
+    return Agent::SOLVE_STATUS::SOLVED;
+}
+
+void ExternalAstarAgent::remove_files(){
+    if (_dir.empty() || _keep_files) return;
+    for (std::map<BucketKey, Bucket>::iterator it=_open.begin();it!=_open.end();++it) remove(it->second.path.c_str());
+    for (const std::string& run: _closed) remove(run.c_str());
+    rmdir(_dir.c_str());
+    _open.clear();
+    _closed.clear();
+    _dir.clear();
+}
+
+int ExternalAstarAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    begin_solve();
+    remove_files();
+    _open.clear();
+    _closed.clear();
+    _next_file = 0;
+    _state_bytes = search_problem->max_packed_size();
+    if (!_state_bytes){
+        std::cerr << "(ExternalAstarAgent::solve) Error: states of this game cannot be packed" << std::endl;
+        end_solve();
+        return Agent::SOLVE_STATUS::NO_SOLUTION;
+    }
+    // Record: packed state, packed parent, g
+    const size_t S = _state_bytes;
+    _record_bytes = 2*S + sizeof(double);
+    std::string dir_template = _temp_root + "/external_astar_XXXXXX";
+    std::vector<char> dir_buf(dir_template.begin(), dir_template.end());
+    dir_buf.push_back('\0');
+    if (!mkdtemp(dir_buf.data())){
+        std::cerr << "(ExternalAstarAgent::solve) Error: cannot create a directory in " << _temp_root << std::endl;
+        end_solve();
+        return Agent::SOLVE_STATUS::NO_SOLUTION;
+    }
+    _dir = dir_buf.data();
+    bool incremental = _incremental && search_heuristic->is_incremental();
+
+    long long num_states = 0;
+    long long buckets = 0;
+    std::vector<uint8_t> rec(_record_bytes), child_rec(_record_bytes);
+    std::shared_ptr<State> init_state = search_problem->get_state();
+    double init_h = search_heuristic->score(init_state.get(), search_problem);
+    double zero = 0.0;
+    search_problem->pack(init_state.get(), rec.data());
+    memcpy(rec.data() + S, rec.data(), S);
+    memcpy(rec.data() + 2*S, &zero, sizeof(double));
+    append(BucketKey{_w*init_h, 0.0, init_h}, rec.data());
+
+    // Memory held: write buffers of every open bucket plus one sort buffer
+    auto memory_bytes = [&](){
+        size_t pending = 0;
+        for (std::map<BucketKey, Bucket>::iterator it=_open.begin();it!=_open.end();++it) pending += it->second.pending.capacity();
+        return pending + _sort_memory;
+    };
+    auto finish = [&](int code){
+        check_budget(num_states, memory_bytes(), true);
+        end_solve();
+        if (_options.verbose){
+            double per = num_states ? 1.0/num_states : 0.0;
+            std::cout << "External A* expanded: " << num_states << " States in " << buckets << " buckets" << std::endl;
+            std::cout << "External A* I/O: " << _stats.bytes_read/1048576.0 << " MB read, " << _stats.bytes_written/1048576.0
+                      << " MB written (" << _stats.bytes_read*per << " / " << _stats.bytes_written*per
+                      << " bytes per expansion, " << _record_bytes << " byte records)" << std::endl;
+        }
+        remove_files();
+        return code;
+    };
+
+    while (!_open.empty()){
+        // Lowest (f, g) bucket is expanded next
+        BucketKey key = _open.begin()->first;
+        Bucket bucket = _open.begin()->second;
+        _open.erase(_open.begin());
+        buckets++;
+        std::string sorted_path, run_path = new_file();
+        uint64_t kept = 0;
+        if (!flush(bucket) || !sort_file(bucket.path, sorted_path) || !subtract_closed(sorted_path, run_path, kept)){
+            std::cerr << "(ExternalAstarAgent::solve) Error: bucket I/O failed in " << _dir << std::endl;
+            return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+        }
+        remove(sorted_path.c_str());
+        _closed.push_back(run_path);
+
+        // Stream the new closed run through expansion
+        RecordReader reader(run_path, _record_bytes, &_stats.bytes_read);
+        while (const uint8_t* cur = reader.next()){
+            int budget_code = check_budget(num_states, memory_bytes());
+            if (budget_code) return finish(budget_code);
+            std::shared_ptr<State> state = search_problem->unpack(cur, S);
+            if (!state){
+                std::cerr << "(ExternalAstarAgent::solve) Error: corrupt record in " << run_path << std::endl;
+                return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+            }
+            if (search_problem->is_goal_state(state.get())){
+                return finish(trace_back(cur, va));
+            }
+            num_states++;
+            std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+            int expand_code = search_problem->get_successors(state.get(), vsa);
+            if (expand_code){
+                std::cerr << "(ExternalAstarAgent::solve) get_successors failed with " << expand_code << std::endl;
+                return finish(expand_code);
+            }
+            _stats.generated += vsa.size();
+            for (size_t i=0;i<vsa.size();++i){
+                double h = incremental ? search_heuristic->score_child(key.h, state.get(), vsa[i].second.get(), vsa[i].first.get(), search_problem)
+                                       : search_heuristic->score(vsa[i].first.get(), search_problem);
+                // Dead ends (e.g. Sokoban deadlocks) never reach the disk
+                if (std::isinf(h)) continue;
+                double g = key.g + vsa[i].second->_cost;
+                search_problem->pack(vsa[i].first.get(), child_rec.data());
+                memcpy(child_rec.data() + S, cur, S);
+                memcpy(child_rec.data() + 2*S, &g, sizeof(double));
+                if (!append(BucketKey{g + _w*h, g, h}, child_rec.data())){
+                    return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+                }
+            }
+        }
+        if (!compact_closed()){
+            std::cerr << "(ExternalAstarAgent::solve) Error: merging closed runs failed in " << _dir << std::endl;
+            return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+        }
+    }
+    if (_options.verbose) std::cerr << "(ExternalAstarAgent::solve) No solution path found..." << std::endl;
+    return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Agent.h"
+#include "../game/Game.h"
+#include "../heuristic/Heuristic.h"
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// A* with its open and closed lists on disk (External A*)
+// Nodes are fixed-size records (packed state, packed parent, g) appended to one
+// bucket file per (g, h), expanded in order of f = g + w*h and then g. Nothing is
+// looked up when a node is generated. Instead a bucket is sorted when its turn
+// comes (external merge sort past the sort memory), deduplicated, and merged
+// against the sorted closed runs to drop states that were already expanded
+// (delayed duplicate detection). What is left becomes a new closed run and is
+// streamed through for expansion; closed runs are merged together once there are
+// MAX_CLOSED_RUNS of them. RAM only holds the sort buffer and per-bucket write
+// buffers, so the search is bounded by disk space rather than memory.
+// Needs Game::pack / Game::unpack and positive action costs. States are never
+// reopened, so an inconsistent heuristic (or w > 1) can cost optimality.
+class ExternalAstarAgent: public Agent{
+    private:
+        struct BucketKey{
+            double f, g, h;
+            bool operator<(const BucketKey& other) const{
+                if (f != other.f) return f < other.f;
+                if (g != other.g) return g < other.g;
+                return h < other.h;
+            }
+        };
+        struct Bucket{
+            std::string path;
+            std::vector<uint8_t> pending;   // Records not yet appended to path
+            uint64_t records;
+            Bucket():records(0){}
+        };
+        // Bytes buffered per bucket before an append to its file
+        static const size_t BUCKET_FLUSH_BYTES = 256*1024;
+        static const int MAX_CLOSED_RUNS = 8;
+
+        Heuristic* search_heuristic;
+        double _w;
+        bool _incremental;
+        std::string _temp_root;         // Each solve makes its own directory in here
+        size_t _sort_memory;
+        bool _keep_files;
+
+        // Per solve
+        std::string _dir;
+        size_t _state_bytes, _record_bytes;
+        std::map<BucketKey, Bucket> _open;
+        std::vector<std::string> _closed;   // Sorted closed runs
+        int _next_file;
+
+        std::string new_file();
+        bool append(const BucketKey& key, const uint8_t* record);
+        bool flush(Bucket& b);
+        // Sort and deduplicate a bucket's file in place of path (runs + k-way merge if large)
+        bool sort_file(const std::string& in_path, std::string& out_path);
+        bool merge_files(const std::vector<std::string>& runs, const std::string& out_path);
+        // Write the records of sorted_path whose state is in no closed run to out_path
+        bool subtract_closed(const std::string& sorted_path, const std::string& out_path, uint64_t& kept);
+        bool compact_closed();
+        // Closed record holding state (binary search over the mapped runs)
+        bool find_closed(const uint8_t* state, std::vector<uint8_t>& record);
+        int trace_back(const uint8_t* goal_record, std::vector<std::shared_ptr<Action>>& va);
+        void remove_files();
+    public:
+        ExternalAstarAgent(Game* g, Heuristic* h, double weight=1.0);
+        // Removes anything left on disk (don't destroy heuristic)
+        virtual ~ExternalAstarAgent();
+        void set_weight(double d);
+        // Toggle per-move heuristic deltas (on by default)
+        void set_incremental(bool b);
+        // Directory for bucket and run files (default /tmp)
+        void set_temp_dir(const std::string& dir);
+        // Bytes of records sorted in memory at once (default 64 MB)
+        void set_sort_memory(size_t bytes);
+        // Leave the files behind after solve (for inspection)
+        void set_keep_files(bool b);
+        // Stats also count bytes_read / bytes_written of bucket and run files
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+};
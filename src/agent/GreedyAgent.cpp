@@ -0,0 +1,108 @@
+#include "GreedyAgent.h"
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+// Open list bytes charged per node on top of its state's footprint
+static const size_t OPEN_NODE_OVERHEAD = sizeof(GreedyAgent::Node) + 32;
+
+GreedyAgent::GreedyAgent(Game* g, Heuristic* h)
+    :Agent(g), search_heuristic(h), _incremental(true), _closed(nullptr){}
+
+GreedyAgent::~GreedyAgent(){
+    search_problem = nullptr;
+    search_heuristic = nullptr;
+    _closed = nullptr;
+}
+
+void GreedyAgent::set_incremental(bool b){
+    _incremental = b;
+}
+
+void GreedyAgent::set_closed_set(ClosedSet* c){
+    _closed = c;
+}
+
+void GreedyAgent::trace_back(std::shared_ptr<Node> n, std::vector<std::shared_ptr<Action>>& va){
+    std::vector<std::shared_ptr<Action>> path;
+    for (;n->_parent;n = n->_parent) path.push_back(n->_action);
+    va.insert(va.end(), path.rbegin(), path.rend());
+}
+
+int GreedyAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    begin_solve();
+    ClosedSet* closed = _closed ? _closed : &_exact;
+    closed->clear();
+    bool incremental = _incremental && search_heuristic->is_incremental();
+    // Lowest h first, newest first among equals (dives like DFS on plateaus)
+    auto worse = [](const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b){
+        if (a->_h != b->_h) return a->_h > b->_h;
+        return a->_seq < b->_seq;
+    };
+    std::priority_queue<std::shared_ptr<Node>, std::vector<std::shared_ptr<Node>>, decltype(worse)> open(worse);
+    long long num_states = 0, seq = 0;
+    size_t open_bytes = 0;
+
+    std::shared_ptr<Node> root = std::make_shared<Node>();
+    root->_state = search_problem->get_state();
+    root->_h = search_heuristic->score(root->_state.get(), search_problem);
+    root->_seq = seq++;
+    closed->insert(root->_state);
+    open.push(root);
+    open_bytes += root->_state->footprint() + OPEN_NODE_OVERHEAD;
+
+    auto finish = [&](int code){
+        check_budget(num_states, closed->memory_bytes() + open_bytes, true);
+        end_solve();
+        if (_options.verbose){
+            std::cout << "Greedy visited: " << num_states << " States" << std::endl;
+            std::cout << "Greedy ";
+            closed->report(std::cout);
+            std::cout << std::endl;
+        }
+        return code;
+    };
+
+    while (!open.empty()){
+        perf_phase(PerfCounters::OTHER);
+        int budget_code = check_budget(num_states, closed->memory_bytes() + open_bytes);
+        if (budget_code) return finish(budget_code);
+        perf_phase(PerfCounters::OPEN_LIST);
+        std::shared_ptr<Node> node = open.top();
+        open.pop();
+        open_bytes -= node->_state->footprint() + OPEN_NODE_OVERHEAD;
+        perf_phase(PerfCounters::OTHER);
+        if (search_problem->is_goal_state(node->_state.get())){
+            trace_back(node, va);
+            return finish(Agent::SOLVE_STATUS::SOLVED);
+        }
+        num_states++;
+        perf_phase(PerfCounters::SUCCESSORS);
+        std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+        int expand_code = search_problem->get_successors(node->_state.get(), vsa);
+        if (expand_code){
+            std::cerr << "(GreedyAgent::solve) get_successors failed with " << expand_code << std::endl;
+            return finish(expand_code);
+        }
+        _stats.generated += vsa.size();
+        for (size_t i=0;i<vsa.size();++i){
+            perf_phase(PerfCounters::LOOKUP);
+            if (!closed->insert(vsa[i].first)) continue;
+            perf_phase(PerfCounters::HEURISTIC);
+            double h = incremental ? search_heuristic->score_child(node->_h, node->_state.get(), vsa[i].second.get(), vsa[i].first.get(), search_problem)
+                                   : search_heuristic->score(vsa[i].first.get(), search_problem);
+            if (std::isinf(h)) continue;
+            perf_phase(PerfCounters::OPEN_LIST);
+            std::shared_ptr<Node> child = std::make_shared<Node>();
+            child->_state = vsa[i].first;
+            child->_parent = node;
+            child->_action = vsa[i].second;
+            child->_h = h;
+            child->_seq = seq++;
+            open.push(child);
+            open_bytes += child->_state->footprint() + OPEN_NODE_OVERHEAD;
+        }
+    }
+    if (_options.verbose) std::cerr << "(GreedyAgent::solve) No solution path found..." << std::endl;
+    return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+}
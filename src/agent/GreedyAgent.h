@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Agent.h"
+#include "ClosedSet.h"
+#include "../game/Game.h"
+#include "../heuristic/Heuristic.h"
+#include <vector>
+#include <memory>
+
+// Greedy best-first search: always expands the open state with the lowest h
+// Finds some solution, usually fast, with no bound on its cost. States are
+// dropped at generation if the closed set has seen them, so any ClosedSet works
+// (see BitstateClosedSet for huge levels).
+class GreedyAgent: public Agent{
+    public:
+        // Open node, parents stay alive only while some descendant is open
+        struct Node{
+            std::shared_ptr<State> _state;
+            std::shared_ptr<Node> _parent;
+            std::shared_ptr<Action> _action;
+            double _h;
+            long long _seq;
+        };
+        // Actions along the parent chain ending at n
+        static void trace_back(std::shared_ptr<Node> n, std::vector<std::shared_ptr<Action>>& va);
+    private:
+        Heuristic* search_heuristic;
+        bool _incremental;
+        ClosedSet* _closed;
+        ExactClosedSet _exact;
+    public:
+        GreedyAgent(Game* g, Heuristic* h);
+        // Destructor (don't destroy heuristic or closed set)
+        virtual ~GreedyAgent();
+        // Toggle per-move heuristic deltas (on by default)
+        void set_incremental(bool b);
+        // Closed set used by solve (not owned, null: an exact set)
+        void set_closed_set(ClosedSet* c);
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+};
@@ -0,0 +1,289 @@
+#include "MCTSAgent.h"
+#include "../util/Hash.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+MCTSAgent::MCTSAgent(Game* g, Heuristic* h)
+    :Agent(g), search_heuristic(h), _threads(1), _parallel(TREE), _c(1.0), _rollout_depth(200), _epsilon(0.3),
+     _virtual_loss(3), _seed(1), _stop(false), _rollouts(0), _expanded(0), _generated(0), _bytes(0), _solved(false), _error(0){}
+
+MCTSAgent::~MCTSAgent(){
+    search_problem = nullptr;
+    search_heuristic = nullptr;
+}
+
+void MCTSAgent::set_threads(int n, parallel_type p){
+    _threads = n > 0 ? n : std::max(1u, std::thread::hardware_concurrency());
+    _parallel = p;
+}
+
+void MCTSAgent::set_exploration(double c){
+    _c = c;
+}
+
+void MCTSAgent::set_rollout(int depth, double epsilon){
+    _rollout_depth = depth;
+    _epsilon = epsilon;
+}
+
+void MCTSAgent::set_virtual_loss(int n){
+    _virtual_loss = std::max(0, n);
+}
+
+void MCTSAgent::set_seed(unsigned seed){
+    _seed = seed;
+}
+
+long long MCTSAgent::get_rollouts() const{
+    return _rollouts.load();
+}
+
+MCTSAgent::Node* MCTSAgent::intern(Tree& t, const std::shared_ptr<State>& s, double h){
+    Tree::Shard& shard = t._shards[mix64(s->hash()) % Tree::SHARDS];
+    std::lock_guard<std::mutex> guard(shard._lock);
+    std::unique_ptr<Node>& slot = shard._nodes[s];
+    if (!slot){
+        slot.reset(new Node());
+        slot->_state = s;
+        slot->_h = h;
+        slot->_goal = search_problem->is_goal_state(s.get());
+        slot->_expanded = false;
+        slot->_dead = false;
+        slot->_visits = 0;
+        slot->_value = 0;
+        _bytes += s->footprint() + NODE_OVERHEAD;
+    }
+    return slot.get();
+}
+
+bool MCTSAgent::expand(Tree& t, Node* n){
+    std::lock_guard<std::mutex> guard(n->_lock);
+    if (n->_expanded) return true;
+    std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+    int expand_code = search_problem->get_successors(n->_state.get(), vsa);
+    if (expand_code){
+        report_error(expand_code);
+        return false;
+    }
+    _generated += vsa.size();
+    bool incremental = search_heuristic->is_incremental();
+    for (auto& sa: vsa){
+        double h = incremental ? search_heuristic->score_child(n->_h, n->_state.get(), sa.second.get(), sa.first.get(), search_problem)
+                               : search_heuristic->score(sa.first.get(), search_problem);
+        if (std::isinf(h)) continue;
+        n->_edges.push_back(Edge{sa.second, intern(t, sa.first, h)});
+    }
+    // Unvisited children are tried in order, most promising first
+    std::stable_sort(n->_edges.begin(), n->_edges.end(), [](const Edge& a, const Edge& b){
+        return a._child->_h < b._child->_h;
+    });
+    if (n->_edges.empty() && !n->_goal) n->_dead = true;
+    _expanded++;
+    n->_expanded = true;
+    return true;
+}
+
+int MCTSAgent::select(const Node* n, const std::vector<Node*>& path) const{
+    double log_n = std::log((double)std::max(1, n->_visits.load()));
+    int best = -1;
+    double best_score = -std::numeric_limits<double>::infinity();
+    bool all_dead = true;
+    for (size_t i=0;i<n->_edges.size();++i){
+        const Node* c = n->_edges[i]._child;
+        if (c->_dead) continue;
+        all_dead = false;
+        if (std::find(path.begin(), path.end(), c) != path.end()) continue;
+        int v = c->_visits;
+        if (v == 0) return i;
+        double score = (double)c->_value/(REWARD_SCALE*(double)v) + _c*std::sqrt(log_n/v);
+        if (score > best_score){
+            best_score = score;
+            best = i;
+        }
+    }
+    if (all_dead) const_cast<Node*>(n)->_dead = true;
+    return best;
+}
+
+double MCTSAgent::rollout(const Node* n, double root_h, std::mt19937_64& rng, std::vector<std::shared_ptr<Action>>& moves, bool& goal){
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    double h_best = n->_h;
+    double h_cur = n->_h;
+    // Tree states are shared, so the first move always goes through get_successors
+    // and the rollout owns every state after it
+    std::shared_ptr<State> cur;
+    for (int step=0;step<_rollout_depth;++step){
+        std::shared_ptr<Action> played;
+        if (cur && coin(rng) < _epsilon){
+            // Random move, in place
+            std::vector<std::shared_ptr<Action>> va;
+            if (search_problem->get_actions(cur.get(), va)) break;
+            while (!va.empty()){
+                size_t i = rng() % va.size();
+                if (search_problem->play_action(cur.get(), va[i].get())){
+                    played = va[i];
+                    break;
+                }
+                va[i] = va.back();
+                va.pop_back();
+            }
+            if (!played) break;
+            h_cur = search_heuristic->score(cur.get(), search_problem);
+        }
+        else{
+            // Greedy move, ties broken at random
+            const State* from = cur ? cur.get() : n->_state.get();
+            std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+            if (search_problem->get_successors(from, vsa)) break;
+            bool incremental = search_heuristic->is_incremental();
+            double best = std::numeric_limits<double>::infinity();
+            size_t pick = vsa.size(), ties = 0;
+            for (size_t i=0;i<vsa.size();++i){
+                double h = incremental ? search_heuristic->score_child(h_cur, from, vsa[i].second.get(), vsa[i].first.get(), search_problem)
+                                       : search_heuristic->score(vsa[i].first.get(), search_problem);
+                if (h < best){
+                    best = h;
+                    pick = i;
+                    ties = 1;
+                }
+                else if (h == best && rng() % ++ties == 0) pick = i;
+            }
+            if (pick == vsa.size()) break;
+            cur = vsa[pick].first;
+            played = vsa[pick].second;
+            h_cur = best;
+        }
+        moves.push_back(played);
+        if (std::isinf(h_cur)) break;
+        if (search_problem->is_goal_state(cur.get())){
+            goal = true;
+            return 1.0;
+        }
+        h_best = std::min(h_best, h_cur);
+    }
+    if (root_h <= 0) return 0.0;
+    return 0.9*std::max(0.0, 1.0 - h_best/root_h);
+}
+
+void MCTSAgent::report_solution(const std::vector<std::shared_ptr<Action>>& moves){
+    std::lock_guard<std::mutex> guard(_solution_lock);
+    if (!_solved){
+        _solution = moves;
+        _solved = true;
+    }
+    _stop = true;
+}
+
+void MCTSAgent::report_error(int code){
+    std::lock_guard<std::mutex> guard(_solution_lock);
+    if (!_error) _error = code;
+    _stop = true;
+}
+
+void MCTSAgent::iterate(Worker& w){
+    Tree& t = *w._tree;
+    Node* n = t._root;
+    std::vector<Node*> path(1, n);
+    std::vector<std::shared_ptr<Action>> moves;
+    n->_visits += _virtual_loss;
+    double reward = 0.0;
+    for (;;){
+        if (n->_goal){
+            report_solution(moves);
+            reward = 1.0;
+            break;
+        }
+        if (!n->_expanded){
+            // Leaves are rolled out once before they are expanded
+            if (n != t._root && n->_visits <= _virtual_loss){
+                bool goal = false;
+                reward = rollout(n, t._root->_h, w._rng, moves, goal);
+                if (goal) report_solution(moves);
+                break;
+            }
+            if (!expand(t, n)) break;
+        }
+        int i = select(n, path);
+        if (i < 0) break;
+        moves.push_back(n->_edges[i]._action);
+        n = n->_edges[i]._child;
+        n->_visits += _virtual_loss;
+        path.push_back(n);
+    }
+    long long value = (long long)(reward*REWARD_SCALE);
+    for (Node* p: path){
+        p->_visits += 1 - _virtual_loss;
+        p->_value += value;
+    }
+    _rollouts++;
+}
+
+int MCTSAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    begin_solve();
+    _stop = false;
+    _rollouts = _expanded = _generated = 0;
+    _bytes = 0;
+    _solution.clear();
+    _solved = false;
+    _error = 0;
+
+    std::shared_ptr<State> start = search_problem->get_state();
+    double root_h = search_heuristic->score(start.get(), search_problem);
+    if (std::isinf(root_h)){
+        end_solve();
+        if (_options.verbose) std::cerr << "(MCTSAgent::solve) No solution path found..." << std::endl;
+        return Agent::SOLVE_STATUS::NO_SOLUTION;
+    }
+    std::vector<std::unique_ptr<Tree>> trees(_parallel == ROOT ? _threads : 1);
+    for (std::unique_ptr<Tree>& t: trees){
+        t.reset(new Tree());
+        t->_root = intern(*t, start, root_h);
+    }
+    std::vector<Worker> workers(_threads);
+    std::vector<std::thread> threads;
+    for (int i=0;i<_threads;++i){
+        workers[i]._tree = trees[_parallel == ROOT ? i : 0].get();
+        workers[i]._rng.seed(hash_combine(_seed, i));
+        threads.push_back(std::thread([this, &workers, i](){
+            while (!_stop) iterate(workers[i]);
+        }));
+    }
+
+    // Budgets are checked here, workers only watch _stop
+    int code = Agent::SOLVE_STATUS::SOLVED;
+    while (!_stop){
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        code = check_budget(_expanded, _bytes, true);
+        if (code) break;
+        bool exhausted = false;
+        for (std::unique_ptr<Tree>& t: trees) exhausted = exhausted || t->_root->_dead;
+        if (exhausted){
+            code = Agent::SOLVE_STATUS::NO_SOLUTION;
+            break;
+        }
+    }
+    _stop = true;
+    for (std::thread& th: threads) th.join();
+    check_budget(_expanded, _bytes, true);
+    end_solve();
+    _stats.generated = _generated;
+    if (_solved) code = Agent::SOLVE_STATUS::SOLVED;
+    else if (_error) code = _error;
+    else if (code == Agent::SOLVE_STATUS::SOLVED) code = Agent::SOLVE_STATUS::NO_SOLUTION;
+
+    if (_options.verbose){
+        size_t nodes = 0;
+        for (std::unique_ptr<Tree>& t: trees){
+            for (Tree::Shard& s: t->_shards) nodes += s._nodes.size();
+        }
+        std::cout << "MCTS rollouts: " << _rollouts << " (" << (_stats.time_ms > 0 ? 1000.0*_rollouts/_stats.time_ms : 0.0)
+                  << "/s) on " << _threads << " threads, " << (_parallel == ROOT ? "root" : "tree") << " parallel" << std::endl;
+        std::cout << "MCTS tree: " << nodes << " nodes in " << trees.size() << " tree(s), " << _expanded << " expanded" << std::endl;
+    }
+    if (code == Agent::SOLVE_STATUS::SOLVED) va.insert(va.end(), _solution.begin(), _solution.end());
+    else if (_error) std::cerr << "(MCTSAgent::solve) get_successors failed with " << _error << std::endl;
+    return code;
+}
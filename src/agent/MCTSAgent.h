@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Agent.h"
+#include "../game/Game.h"
+#include "../heuristic/Heuristic.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// Monte-Carlo tree search for single-player games (UCT)
+// Each iteration descends the tree by UCB1 on mean reward to a leaf. A leaf is
+// rolled out the first time it is reached and expanded the next. Rollouts are epsilon-greedy:
+// usually the successor with the lowest h, otherwise a random action played in
+// place on the rollout's own state. A rollout that reaches a goal ends the
+// search with the tree path plus the rollout's moves. Any other rollout earns
+// 0.9 * (1 - h_best / h_root), h_best being the lowest h it passed through.
+// Nodes are shared between all paths that reach the same state (a transposition
+// table keyed by State::hash and operator==). Statistics live on nodes, and a
+// descent never revisits a node already on its own path.
+// Threads either share one tree (TREE), with virtual losses steering concurrent
+// descents apart, or grow a tree each (ROOT); the first solution wins either way.
+// Solutions are satisficing, not optimal. Game and heuristic are only read, so
+// they are shared across threads as in PortfolioAgent.
+class MCTSAgent: public Agent{
+    public:
+        enum parallel_type{
+            TREE    = 0,
+            ROOT    = 1
+        };
+    private:
+        struct Node;
+        struct Edge{
+            std::shared_ptr<Action> _action;
+            Node* _child;
+        };
+        struct Node{
+            std::shared_ptr<State> _state;
+            double _h;
+            bool _goal;
+            std::mutex _lock;                   // Held while expanding
+            std::atomic<bool> _expanded;
+            std::atomic<bool> _dead;            // No goal below (every child dead)
+            std::vector<Edge> _edges;           // Written once, before _expanded is set
+            std::atomic<int> _visits;           // Including virtual losses in flight
+            std::atomic<long long> _value;      // Reward sum, in REWARD_SCALE units
+        };
+        typedef std::unordered_map<std::shared_ptr<State>, std::unique_ptr<Node>, StatePointerHash, DerefCompare> node_map;
+        // Node table split in independently locked shards
+        struct Tree{
+            static const int SHARDS = 64;
+            struct Shard{
+                std::mutex _lock;
+                node_map _nodes;
+            };
+            Shard _shards[SHARDS];
+            Node* _root;
+        };
+        struct Worker{
+            Tree* _tree;
+            std::mt19937_64 _rng;
+        };
+        static const long long REWARD_SCALE = 1LL << 20;
+        // Bytes charged per node on top of its state's footprint (node and table entry)
+        static const size_t NODE_OVERHEAD = sizeof(Node) + 64;
+
+        Heuristic* search_heuristic;
+        int _threads;
+        parallel_type _parallel;
+        double _c;
+        int _rollout_depth;
+        double _epsilon;
+        int _virtual_loss;
+        unsigned _seed;
+        // Shared by the workers of one solve
+        std::atomic<bool> _stop;
+        std::atomic<long long> _rollouts, _expanded, _generated;
+        std::atomic<size_t> _bytes;
+        std::mutex _solution_lock;
+        std::vector<std::shared_ptr<Action>> _solution;
+        bool _solved;
+        int _error;
+
+        // Node for s in t, created with h if new
+        Node* intern(Tree& t, const std::shared_ptr<State>& s, double h);
+        // Children of n (once, under n's lock), false on a game error
+        bool expand(Tree& t, Node* n);
+        // Child edge by UCB1, skipping dead children and nodes on the path (-1: none)
+        int select(const Node* n, const std::vector<Node*>& path) const;
+        // Rollout from n's state, its moves are appended to moves (goal: reached one)
+        // @return reward in [0, 1]
+        double rollout(const Node* n, double root_h, std::mt19937_64& rng, std::vector<std::shared_ptr<Action>>& moves, bool& goal);
+        void iterate(Worker& w);
+        void report_solution(const std::vector<std::shared_ptr<Action>>& moves);
+        void report_error(int code);
+    public:
+        MCTSAgent(Game* g, Heuristic* h);
+        // Destructor (don't destroy heuristic)
+        virtual ~MCTSAgent();
+        // Worker threads (<= 0: hardware threads) and how they share trees
+        void set_threads(int n, parallel_type p=TREE);
+        // UCB1 exploration constant (rewards are in [0, 1])
+        void set_exploration(double c);
+        // Moves per rollout and the chance each move is random rather than greedy
+        void set_rollout(int depth, double epsilon);
+        // Visits added to each node on a descent's path until it backs up
+        void set_virtual_loss(int n);
+        void set_seed(unsigned seed);
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+        // Rollouts played in the last solve
+        long long get_rollouts() const;
+};
@@ -0,0 +1,432 @@
+#include "MemoryBoundedAgent.h"
+#include "../util/Hash.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+// Slack for comparing path costs rebuilt from different searches
+static const double COST_EPS = 1e-6;
+
+MemoryBoundedAgent::MemoryBoundedAgent(Game* g, Heuristic* h, double weight)
+    :Agent(g), search_heuristic(h), _w(weight), _incremental(true), _memory_bound(0),
+     _filter_bytes(0), _bytes(0), _closed_bytes(0), _peak_bytes(0), _expanded(0), _next_seq(0), _num_forgotten(0), _pruned(0), _segments(0), _filtered(0){}
+
+MemoryBoundedAgent::~MemoryBoundedAgent(){
+    search_problem = nullptr;
+    search_heuristic = nullptr;
+}
+
+void MemoryBoundedAgent::set_weight(double d){
+    _w = d;
+}
+
+void MemoryBoundedAgent::set_incremental(bool b){
+    _incremental = b;
+}
+
+void MemoryBoundedAgent::set_memory_bound(size_t bytes){
+    _memory_bound = bytes;
+}
+
+MemoryBoundedAgent::StateRef MemoryBoundedAgent::make_ref(const std::shared_ptr<State>& s){
+    StateRef r;
+    size_t n = _buf.empty() ? 0 : search_problem->pack(s.get(), _buf.data());
+    if (n) r._bytes.assign((const char*)_buf.data(), n);
+    else r._state = s;
+    return r;
+}
+
+std::shared_ptr<State> MemoryBoundedAgent::get_ref(const StateRef& r) const{
+    if (r._state || r._bytes.empty()) return r._state;
+    return search_problem->unpack((const uint8_t*)r._bytes.data(), r._bytes.size());
+}
+
+uint64_t MemoryBoundedAgent::key_hash(const State* s){
+    size_t n = _buf.empty() ? 0 : search_problem->pack_key(s, _buf.data());
+    if (n) return hash_bytes(_buf.data(), n);
+    return mix64(s->hash());
+}
+
+size_t MemoryBoundedAgent::ref_bytes(const StateRef& r) const{
+    // Packed references past the short-string buffer live on the heap
+    if (r._state) return r._state->footprint();
+    return r._bytes.size() >= sizeof(std::string) ? r._bytes.capacity() : 0;
+}
+
+size_t MemoryBoundedAgent::node_bytes(const Node& n) const{
+    return sizeof(Node) + NODE_OVERHEAD + n._state->footprint() + ref_bytes(n._parent) + ref_bytes(n._relay);
+}
+
+void MemoryBoundedAgent::forget(const Node& n, bool filter, size_t bound){
+    uint64_t key = key_hash(n._state.get());
+    forgotten_map::iterator f = _forgotten.find(key);
+    if (f == _forgotten.end()){
+        if (_filter_bytes >= bound/2) return;
+        Forgotten entry = {n._g, n._parent, n._action, filter};
+        size_t bytes = FORGOTTEN_ENTRY_BYTES + ref_bytes(n._parent);
+        _filter_bytes += bytes;
+        _bytes += bytes;
+        _forgotten.insert(std::make_pair(key, entry));
+        return;
+    }
+    // Keep the cheapest path
+    if (n._g < f->second._g){
+        size_t old_bytes = ref_bytes(f->second._parent), new_bytes = ref_bytes(n._parent);
+        _filter_bytes += new_bytes - old_bytes;
+        _bytes += new_bytes - old_bytes;
+        f->second._g = n._g;
+        f->second._parent = n._parent;
+        f->second._action = n._action;
+    }
+    f->second._filter = filter;
+}
+
+void MemoryBoundedAgent::add_node(const std::shared_ptr<Node>& n){
+    n->_held = true;
+    _nodes[n->_state] = n;
+    if (n->_open) _pq.insert(n);
+    _bytes += node_bytes(*n);
+    _peak_bytes = std::max(_peak_bytes, _bytes);
+}
+
+void MemoryBoundedAgent::remove_node(const std::shared_ptr<Node>& n){
+    // n may be the map's own entry, hold on to the node until we are done
+    std::shared_ptr<Node> node = n;
+    size_t bytes = node_bytes(*node);
+    _bytes -= bytes;
+    if (node->_open) _pq.erase(node);
+    else _closed_bytes -= bytes;
+    node->_held = false;
+    _nodes.erase(node->_state);
+}
+
+std::shared_ptr<MemoryBoundedAgent::Node> MemoryBoundedAgent::release(const Node& n){
+    std::shared_ptr<Node> parent = n._parent_node.lock();
+    if (parent && parent->_held){
+        parent->_live--;
+        return parent;
+    }
+    // Generated before the parent was forgotten or replaced, another node may hold its state
+    if (n._parent.empty()) return nullptr;
+    node_map::iterator it = _nodes.find(get_ref(n._parent));
+    return it != _nodes.end() ? it->second : nullptr;
+}
+
+void MemoryBoundedAgent::reopen(const std::shared_ptr<Node>& n){
+    _closed_bytes -= node_bytes(*n);
+    n->_open = true;
+    n->_f = std::max(n->_f, n->_backed_f);
+    n->_backed_f = std::numeric_limits<double>::infinity();
+    _pq.insert(n);
+}
+
+bool MemoryBoundedAgent::reopen_pending(){
+    // Parents whose other children died out without being pruned still owe the pruned ones
+    bool reopened = false;
+    for (node_map::iterator it=_nodes.begin();it!=_nodes.end();++it){
+        if (it->second->_open || std::isinf(it->second->_backed_f)) continue;
+        reopen(it->second);
+        reopened = true;
+    }
+    return reopened;
+}
+
+bool MemoryBoundedAgent::shrink(size_t bound){
+    bool dropped = false;
+    size_t target = bound/4*3;
+    // Frontier search: forget the interior, remembering it in the duplicate filter
+    auto forget_closed = [&](){
+        for (node_map::iterator it=_nodes.begin();it!=_nodes.end();){
+            std::shared_ptr<Node> node = it->second;
+            if (node->_open){
+                ++it;
+                continue;
+            }
+            // Pruned children still to regenerate, it stays as a leaf
+            if (!std::isinf(node->_backed_f)){
+                reopen(node);
+                ++it;
+                continue;
+            }
+            std::shared_ptr<Node> parent = release(*node);
+            if (parent && !parent->_open && !parent->_live && !std::isinf(parent->_backed_f)) reopen(parent);
+            forget(*node, true, bound);
+            _bytes -= node_bytes(*node);
+            node->_held = false;
+            it = _nodes.erase(it);
+            ++_num_forgotten;
+            dropped = true;
+        }
+        _closed_bytes = 0;
+    };
+    // Once it is worth a pass over the table
+    if (_closed_bytes >= bound - target) forget_closed();
+    if (_bytes <= target || _pq.empty()) return dropped;
+
+    // SMA*: prune the worst leaves down to 3/4 of the bound, backing their f up to the parents.
+    // Leaves at the best f stay, so the layer being expanded always finishes
+    double best_f = (*_pq.begin())->_f;
+    size_t excess = _bytes - target;
+    size_t freed = 0;
+    std::vector<std::shared_ptr<Node>> leaves;
+    for (node_pq::reverse_iterator it=_pq.rbegin();it!=_pq.rend() && (*it)->_f > best_f + COST_EPS && freed < excess;++it){
+        // The segment's root (or a parent recreated once the filter was full) has nowhere further to go
+        if ((*it)->_parent.empty()) continue;
+        leaves.push_back(*it);
+        freed += node_bytes(**it);
+    }
+    for (const std::shared_ptr<Node>& leaf: leaves){
+        remove_node(leaf);
+        ++_pruned;
+        dropped = true;
+        std::shared_ptr<Node> parent = release(*leaf);
+        if (parent){
+            parent->_backed_f = std::min(parent->_backed_f, leaf->_f);
+            if (parent->_open){
+                // Regenerates what it is missing when expanded, at its best pruned child's f
+                if (leaf->_f < parent->_f){
+                    _pq.erase(parent);
+                    parent->_f = leaf->_f;
+                    _pq.insert(parent);
+                }
+            }
+            // Back on the open list once all its children are gone
+            else if (parent->_live <= 0) reopen(parent);
+            continue;
+        }
+        // Recreate the parent with its own parent from the filter, so it can be pruned too.
+        // g stays the leaf path's: equal states can differ in cost (Sokoban's player), and
+        // a cheaper entry only makes g too high further up, which the relay segments allow
+        std::shared_ptr<State> leaf_parent = get_ref(leaf->_parent);
+        parent = std::make_shared<Node>();
+        parent->_state = leaf_parent;
+        parent->_g = leaf->_g - leaf->_action->_cost;
+        parent->_relay_g = 0;
+        forgotten_map::iterator f = _forgotten.find(key_hash(leaf_parent.get()));
+        if (f != _forgotten.end() && f->second._g <= parent->_g + COST_EPS){
+            // The filter's parent may be on another path than the leaf's relay, so the
+            // relay is left out and the children past the threshold start their own
+            parent->_parent = f->second._parent;
+            parent->_action = f->second._action;
+            // Held again, and regenerated from its own parent if pruned later
+            f->second._filter = false;
+        }
+        // A leaf that is its own relay (relay g is its g, costs are positive) was the
+        // first past the threshold, so its parent has none
+        else if (!leaf->_relay.empty() && leaf->_relay_g < leaf->_g){
+            parent->_relay = leaf->_relay;
+            parent->_relay_g = leaf->_relay_g;
+        }
+        parent->_h = search_heuristic->score(parent->_state.get(), search_problem);
+        parent->_f = leaf->_f;
+        parent->_backed_f = std::numeric_limits<double>::infinity();
+        parent->_live = 0;
+        parent->_seq = _next_seq++;
+        parent->_open = true;
+        add_node(parent);
+    }
+    // Still over: the rest of the interior goes too
+    if (_bytes > bound && _closed_bytes) forget_closed();
+    return dropped;
+}
+
+int MemoryBoundedAgent::search(const Segment& seg, std::shared_ptr<Node>& goal, double& max_f, bool& dropped){
+    _nodes.clear();
+    _pq.clear();
+    _forgotten.clear();
+    _filter_bytes = 0;
+    _bytes = 0;
+    _closed_bytes = 0;
+    max_f = 0;
+    dropped = false;
+    bool to_goal = !seg.target;
+    bool incremental = _incremental && search_heuristic->is_incremental();
+    size_t bound = _memory_bound ? _memory_bound : _options.memory_limit_bytes/2;
+
+    std::shared_ptr<Node> root = std::make_shared<Node>();
+    root->_state = seg.start;
+    root->_g = 0;
+    root->_h = search_heuristic->score(seg.start.get(), search_problem);
+    if (std::isinf(root->_h)) return Agent::SOLVE_STATUS::NO_SOLUTION;
+    root->_f = to_goal ? _w*root->_h : 0;
+    root->_relay_g = 0;
+    root->_backed_f = std::numeric_limits<double>::infinity();
+    root->_live = 0;
+    root->_seq = _next_seq++;
+    root->_open = true;
+    add_node(root);
+    // Relays sit halfway along the segment's expected cost
+    double threshold = (seg.g_limit > 0 ? seg.g_limit : _w*root->_h)/2;
+
+    while (!_pq.empty() || reopen_pending()){
+        int budget_code = check_budget(_expanded, _bytes);
+        if (budget_code) return budget_code;
+        std::shared_ptr<Node> node = *_pq.begin();
+        _pq.erase(_pq.begin());
+        node->_open = false;
+        _closed_bytes += node_bytes(*node);
+        // Its children are counted again, and pruned ones regenerated
+        node->_live = 0;
+        node->_backed_f = std::numeric_limits<double>::infinity();
+        max_f = std::max(max_f, seg.g_offset + node->_g + _w*node->_h);
+
+        if (to_goal ? search_problem->is_goal_state(node->_state.get()) : *node->_state == *seg.target){
+            goal = node;
+            return Agent::SOLVE_STATUS::SOLVED;
+        }
+        _expanded++;
+        std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+        int expand_code = search_problem->get_successors(node->_state.get(), vsa);
+        if (expand_code){
+            std::cerr << "(MemoryBoundedAgent::search) get_successors failed with " << expand_code << std::endl;
+            return expand_code;
+        }
+        _stats.generated += vsa.size();
+        for (size_t i=0;i<vsa.size();++i){
+            double g = node->_g + vsa[i].second->_cost;
+            if (seg.g_limit > 0 && g > seg.g_limit + COST_EPS) continue;
+            double h = incremental ? search_heuristic->score_child(node->_h, node->_state.get(), vsa[i].second.get(), vsa[i].first.get(), search_problem)
+                                   : search_heuristic->score(vsa[i].first.get(), search_problem);
+            if (std::isinf(h)) continue;
+            if (seg.f_limit > 0 && seg.g_offset + g + _w*h > seg.f_limit + COST_EPS) continue;
+            node_map::iterator it = _nodes.find(vsa[i].first);
+            if (it != _nodes.end()){
+                std::shared_ptr<Node> held = it->second;
+                if (held->_g <= g){
+                    // Still held from an earlier expansion of this state
+                    std::shared_ptr<Node> parent = held->_parent_node.lock();
+                    if (parent == node || ((!parent || !parent->_held) && held->_g >= g - COST_EPS)){
+                        held->_parent_node = node;
+                        node->_live++;
+                    }
+                    continue;
+                }
+                // Cheaper path, reopen
+                remove_node(held);
+                std::shared_ptr<Node> parent = release(*held);
+                if (parent && !parent->_open && parent->_live <= 0 && !std::isinf(parent->_backed_f)) reopen(parent);
+            }
+            else if (!_forgotten.empty()){
+                // Forgotten interior, regenerated no cheaper
+                forgotten_map::const_iterator f = _forgotten.find(key_hash(vsa[i].first.get()));
+                if (f != _forgotten.end() && f->second._filter && f->second._g <= g + COST_EPS){
+                    ++_filtered;
+                    continue;
+                }
+            }
+            std::shared_ptr<Node> child = std::make_shared<Node>();
+            child->_state = vsa[i].first;
+            child->_parent = make_ref(node->_state);
+            child->_parent_node = node;
+            node->_live++;
+            child->_action = vsa[i].second;
+            child->_g = g;
+            child->_h = h;
+            // Never below the parent's (pathmax), so a subtree pruned at f keeps f when regenerated
+            child->_f = std::max(to_goal ? g + _w*h : g, node->_f);
+            if (!node->_relay.empty()){
+                child->_relay = node->_relay;
+                child->_relay_g = node->_relay_g;
+            }
+            else if (g >= threshold){
+                child->_relay = make_ref(child->_state);
+                child->_relay_g = g;
+            }
+            else child->_relay_g = 0;
+            child->_backed_f = std::numeric_limits<double>::infinity();
+            child->_live = 0;
+            child->_seq = _next_seq++;
+            child->_open = true;
+            add_node(child);
+        }
+        if (bound && _bytes > bound){
+            if (shrink(bound)) dropped = true;
+            if (_bytes > bound){
+                if (_options.verbose) std::cerr << "(MemoryBoundedAgent::search) Error: " << _bytes/1024 << " KB left after pruning, the frontier does not fit in "
+                                                << bound/1024 << " KB" << std::endl;
+                return Agent::SOLVE_STATUS::MEMORY_LIMIT;
+            }
+        }
+    }
+    return Agent::SOLVE_STATUS::NO_SOLUTION;
+}
+
+int MemoryBoundedAgent::solve_segment(const Segment& seg, std::vector<std::shared_ptr<Action>>& va){
+    if (seg.target && *seg.start == *seg.target) return Agent::SOLVE_STATUS::SOLVED;
+    _segments++;
+    std::shared_ptr<Node> goal;
+    double max_f;
+    bool dropped;
+    int code = search(seg, goal, max_f, dropped);
+    if (code == Agent::SOLVE_STATUS::NO_SOLUTION && seg.target && (seg.g_limit > 0 || seg.f_limit > 0)){
+        // Equal states can differ in cost (Sokoban's player), so the search may have kept a
+        // copy of a state on the recorded path that cannot reach the target within its limits.
+        // Lift the g limit, then the f limit
+        Segment open_seg = {seg.start, seg.target, seg.g_offset, 0, seg.g_limit > 0 ? seg.f_limit : 0};
+        return solve_segment(open_seg, va);
+    }
+    if (code) return code;
+    if (!dropped){
+        // Nothing was forgotten, follow the parents
+        std::vector<std::shared_ptr<Action>> path;
+        for (std::shared_ptr<Node> node = goal;!node->_parent.empty();node = _nodes[get_ref(node->_parent)]) path.push_back(node->_action);
+        va.insert(va.end(), path.rbegin(), path.rend());
+        return Agent::SOLVE_STATUS::SOLVED;
+    }
+    // Divide and conquer, the sub-searches stay inside what this one expanded
+    double f_limit = seg.f_limit > 0 ? seg.f_limit : max_f;
+    std::shared_ptr<State> relay = get_ref(goal->_relay);
+    std::shared_ptr<State> parent = get_ref(goal->_parent);
+    std::shared_ptr<Action> action = goal->_action;
+    double g = goal->_g, relay_g = goal->_relay_g;
+    goal = nullptr;
+    _nodes.clear();
+    _pq.clear();
+    _forgotten.clear();
+    // A goal that is its own relay has its relay g (costs are positive)
+    if (relay && relay_g < g){
+        Segment head = {seg.start, relay, seg.g_offset, relay_g, f_limit};
+        Segment tail = {relay, seg.target, seg.g_offset + relay_g, g - relay_g, f_limit};
+        code = solve_segment(head, va);
+        if (code) return code;
+        return solve_segment(tail, va);
+    }
+    // No relay strictly inside the path, peel off the last move instead
+    if (!parent){
+        std::cerr << "(MemoryBoundedAgent::solve_segment) Error: goal node has neither relay nor parent" << std::endl;
+        return Agent::SOLVE_STATUS::NO_SOLUTION;
+    }
+    Segment head = {seg.start, parent, seg.g_offset, g - action->_cost, f_limit};
+    code = solve_segment(head, va);
+    if (code) return code;
+    va.push_back(action);
+    return Agent::SOLVE_STATUS::SOLVED;
+}
+
+int MemoryBoundedAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    begin_solve();
+    _expanded = 0;
+    _next_seq = 0;
+    _num_forgotten = 0;
+    _pruned = 0;
+    _segments = 0;
+    _peak_bytes = 0;
+    _filtered = 0;
+    _buf.assign(search_problem->max_packed_size(), 0);
+    Segment top = {search_problem->get_state(), nullptr, 0, 0, 0};
+    int code = solve_segment(top, va);
+    if (code) va.clear();
+    _nodes.clear();
+    _pq.clear();
+    _forgotten.clear();
+    check_budget(_expanded, _peak_bytes, true);
+    end_solve();
+    if (_options.verbose){
+        std::cout << "Memory-bounded A* expanded: " << _expanded << " States over " << _segments << " searches" << std::endl;
+        std::cout << "Memory-bounded A* peak: " << _peak_bytes/1024 << " KB, forgot " << _num_forgotten
+                  << " closed nodes, pruned " << _pruned << " leaves, filtered "
+                  << _filtered << " forgotten duplicates" << std::endl;
+    }
+    return code;
+}
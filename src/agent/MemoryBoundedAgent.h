@@ -0,0 +1,141 @@
+#pragma once
+
+#include "Agent.h"
+#include "../game/Game.h"
+#include "../heuristic/Heuristic.h"
+#include <vector>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <string>
+#include <cstdint>
+
+// A* that stays under a memory bound instead of running out of it
+// While the estimated node memory fits, this is plain A*. Past the bound it
+// first forgets every expanded (closed) node, keeping only the frontier as in
+// frontier search. A forgotten node leaves its 64-bit key hash (of Game::pack_key,
+// State::hash when the game cannot pack) and its g in a duplicate filter, and a
+// regenerated state whose g is no better is dropped, so the search does not leak
+// back into the forgotten interior. The filter is charged against the bound and
+// stops growing at half of it. If the open list alone is still too big, the
+// worst leaves are pruned SMA*-style: a pruned leaf backs its f up into its parent,
+// which goes back on the open list once none of its children are held or the
+// open list runs empty (or is recreated, if it was forgotten), so that subtree
+// is regenerated later if it is still needed. Children never fall below their
+// parent's f (pathmax). Filter entries also keep their node's parent, so a
+// recreated parent can be pruned in turn. Only leaves worse than the best f are
+// pruned, so every f layer is finished before the next one starts; when a layer's
+// frontier does not fit under the bound even without the interior, the search
+// fails with MEMORY_LIMIT.
+// Parents and relays are held as pack() bytes, so forgetting a node frees its
+// state (games that cannot pack hold them as states, charged to every holder).
+// Forgotten nodes break the parent chain, so every node carries a relay: the
+// first state on its path whose g passed half the segment's expected cost. When
+// the goal is reached, the path is rebuilt by divide and conquer. start -> relay
+// and relay -> goal are solved as smaller bounded searches, pruned by the costs
+// and f values of the first search, and their paths are joined. Equal states
+// may differ in cost (Sokoban's player), so a sub-search that misses its target
+// within those limits is run again without them.
+// Works on any Game and Heuristic; action costs must be positive.
+class MemoryBoundedAgent: public Agent{
+    private:
+        // A state a node refers to but does not own
+        struct StateRef{
+            std::string _bytes;                 // Game::pack of the state
+            std::shared_ptr<State> _state;      // Games that cannot pack
+            bool empty() const{return _bytes.empty() && !_state;}
+        };
+        struct Node{
+            std::shared_ptr<State> _state;
+            StateRef _parent;                   // Empty at the root (and on parents recreated once the filter was full)
+            std::weak_ptr<Node> _parent_node;   // Parent's node while held, from when this one was generated
+            std::shared_ptr<Action> _action;    // Action taken from _parent
+            StateRef _relay;                    // Empty while g is under the relay threshold
+            double _g, _h, _f, _relay_g;
+            double _backed_f;                   // Lowest f of pruned children not regenerated yet (inf: none)
+            int _live;                          // Children held that point back to this node
+            long long _seq;
+            bool _open, _held;
+        };
+        struct OpenOrder{
+            // Same tie-breaks as AstarSearchAgent: f, then h, then newest first
+            bool operator()(const std::shared_ptr<Node>& a, const std::shared_ptr<Node>& b) const{
+                if (a->_f != b->_f) return a->_f < b->_f;
+                if (a->_h != b->_h) return a->_h < b->_h;
+                return a->_seq > b->_seq;
+            }
+        };
+        typedef std::unordered_map<std::shared_ptr<State>, std::shared_ptr<Node>, StatePointerHash, DerefCompare> node_map;
+        typedef std::set<std::shared_ptr<Node>, OpenOrder> node_pq;
+        // A node no longer held: where it came from, and whether regenerating it no cheaper is a duplicate
+        struct Forgotten{
+            double _g;
+            StateRef _parent;                   // Empty at the root
+            std::shared_ptr<Action> _action;
+            bool _filter;                       // Forgotten interior (not a pruned or recreated node)
+        };
+        // Key hash -> forgotten node
+        typedef std::unordered_map<uint64_t, Forgotten> forgotten_map;
+        // One bounded search: start to target (or to a goal state when target is null)
+        struct Segment{
+            std::shared_ptr<State> start, target;
+            double g_offset;    // Cost from the real start to start
+            double g_limit;     // Prune nodes costing more than this (target cost, <= 0: none)
+            double f_limit;     // Prune nodes with g_offset + g + w*h above this (<= 0: none)
+        };
+        // Bytes charged per node on top of its state's footprint (hash and set entries)
+        static const size_t NODE_OVERHEAD = 96;
+        // Bytes charged per duplicate filter entry (hash node and bucket)
+        static const size_t FORGOTTEN_ENTRY_BYTES = 48;
+
+        Heuristic* search_heuristic;
+        double _w;
+        bool _incremental;
+        size_t _memory_bound;
+
+        // Per solve
+        node_map _nodes;
+        node_pq _pq;
+        forgotten_map _forgotten;
+        size_t _filter_bytes;
+        size_t _bytes, _closed_bytes, _peak_bytes;
+        long long _expanded, _next_seq;
+        long long _num_forgotten, _pruned, _segments, _filtered;
+        std::vector<uint8_t> _buf;
+
+        StateRef make_ref(const std::shared_ptr<State>& s);
+        std::shared_ptr<State> get_ref(const StateRef& r) const;
+        // Duplicate filter key of s
+        uint64_t key_hash(const State* s);
+        size_t ref_bytes(const StateRef& r) const;
+        size_t node_bytes(const Node& n) const;
+        // Record n in _forgotten (while that stays under half the bound), filter: as forgotten interior
+        void forget(const Node& n, bool filter, size_t bound);
+        void add_node(const std::shared_ptr<Node>& n);
+        void remove_node(const std::shared_ptr<Node>& n);
+        // n's parent if it is held (null otherwise), and n no longer counts among its live children
+        std::shared_ptr<Node> release(const Node& n);
+        // Put closed n back on the open list at its backed-up f
+        void reopen(const std::shared_ptr<Node>& n);
+        // Reopen every closed node with pruned children pending, false if there were none
+        bool reopen_pending();
+        // Shed memory once _bytes passes the bound (frontier search, then SMA* leaf pruning)
+        // Nodes at the best f are never pruned, so _bytes can stay above the bound
+        // @return true if any node was dropped
+        bool shrink(size_t bound);
+        // Bounded A* over one segment, goal is the node reaching the segment's target
+        // @return solve status, max_f is the highest f expanded and dropped tells if the parent chain is broken
+        int search(const Segment& seg, std::shared_ptr<Node>& goal, double& max_f, bool& dropped);
+        // Actions from seg.start to seg.target (or a goal), appended to va
+        int solve_segment(const Segment& seg, std::vector<std::shared_ptr<Action>>& va);
+    public:
+        MemoryBoundedAgent(Game* g, Heuristic* h, double weight=1.0);
+        // Destructor (don't destroy heuristic)
+        virtual ~MemoryBoundedAgent();
+        void set_weight(double d);
+        // Toggle per-move heuristic deltas (on by default)
+        void set_incremental(bool b);
+        // Bytes of nodes kept before shedding (0: half of SolveOptions::memory_limit_bytes, or unbounded)
+        void set_memory_bound(size_t bytes);
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+};
@@ -0,0 +1,281 @@
+#include "MoveAutomaton.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <set>
+#include <unordered_map>
+
+// On-disk header, followed by states*codes int32 transitions and the patterns
+// (each a uint32 length and its int32 codes)
+struct AutomatonHeader{
+    char magic[4];
+    uint32_t codes;
+    uint32_t states;
+    uint32_t patterns;
+};
+
+static const char AUTOMATON_MAGIC[4] = {'M','F','S','M'};
+
+MoveAutomaton::MoveAutomaton():_codes(0), _states(1){}
+
+void MoveAutomaton::build(int codes, const std::vector<std::vector<int>>& patterns){
+    _codes = std::max(codes, 0);
+    _patterns = patterns;
+    _delta.clear();
+    _states = 1;
+    if (!_codes) return;
+    // Trie of the patterns
+    std::vector<int> trie(_codes, -1);
+    std::vector<char> terminal(1, 0);
+    for (const std::vector<int>& p: patterns){
+        int u = 0;
+        for (int c: p){
+            if (c < 0 || c >= _codes){
+                u = -1;
+                break;
+            }
+            if (trie[u*_codes + c] < 0){
+                trie[u*_codes + c] = terminal.size();
+                terminal.push_back(0);
+                trie.resize(trie.size() + _codes, -1);
+            }
+            u = trie[u*_codes + c];
+        }
+        if (u > 0) terminal[u] = 1;
+    }
+    // Failure links by BFS, missing edges follow the failure state's edge
+    _states = terminal.size();
+    std::vector<int> fail(_states, 0), delta(_states*_codes, 0), queue;
+    for (int c=0;c<_codes;++c){
+        if (trie[c] >= 0){
+            delta[c] = trie[c];
+            queue.push_back(trie[c]);
+        }
+    }
+    for (size_t i=0;i<queue.size();++i){
+        int u = queue[i];
+        // A state whose longest proper suffix ends a pattern ends it too
+        terminal[u] |= terminal[fail[u]];
+        for (int c=0;c<_codes;++c){
+            int v = trie[u*_codes + c];
+            if (v >= 0){
+                fail[v] = delta[fail[u]*_codes + c];
+                delta[u*_codes + c] = v;
+                queue.push_back(v);
+            }
+            else delta[u*_codes + c] = delta[fail[u]*_codes + c];
+        }
+    }
+    _delta.resize(delta.size());
+    for (size_t i=0;i<delta.size();++i) _delta[i] = terminal[delta[i]] ? REJECT : delta[i];
+}
+
+int MoveAutomaton::save(const std::string& path) const{
+    FILE* fout = fopen(path.c_str(), "wb");
+    if (!fout){
+        std::cerr << "(MoveAutomaton::save) Error: cannot write <" << path << ">" << std::endl;
+        return ERR_CODE::FILE_ERROR;
+    }
+    AutomatonHeader hdr;
+    memcpy(hdr.magic, AUTOMATON_MAGIC, 4);
+    hdr.codes = _codes;
+    hdr.states = _states;
+    hdr.patterns = _patterns.size();
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, fout) == 1 &&
+              fwrite(_delta.data(), sizeof(int), _delta.size(), fout) == _delta.size();
+    for (const std::vector<int>& p: _patterns){
+        uint32_t len = p.size();
+        ok = ok && fwrite(&len, sizeof(len), 1, fout) == 1 && fwrite(p.data(), sizeof(int), len, fout) == len;
+    }
+    ok = (fclose(fout) == 0) && ok;
+    if (!ok){
+        std::cerr << "(MoveAutomaton::save) Error: short write to <" << path << ">" << std::endl;
+        return ERR_CODE::FILE_ERROR;
+    }
+    return ERR_CODE::SUCCESS;
+}
+
+int MoveAutomaton::load(const std::string& path){
+    FILE* fin = fopen(path.c_str(), "rb");
+    if (!fin){
+        std::cerr << "(MoveAutomaton::load) Error: cannot read <" << path << ">" << std::endl;
+        return ERR_CODE::FILE_ERROR;
+    }
+    AutomatonHeader hdr;
+    bool ok = fread(&hdr, sizeof(hdr), 1, fin) == 1 && !memcmp(hdr.magic, AUTOMATON_MAGIC, 4) && hdr.states >= 1
+              && (uint64_t)hdr.states*hdr.codes <= (1ULL << 28);
+    std::vector<int> delta;
+    std::vector<std::vector<int>> patterns;
+    if (ok){
+        delta.resize((size_t)hdr.states*hdr.codes);
+        ok = fread(delta.data(), sizeof(int), delta.size(), fin) == delta.size();
+        for (size_t i=0;ok && i<delta.size();++i) ok = delta[i] >= REJECT && delta[i] < (int)hdr.states;
+    }
+    for (uint32_t i=0;ok && i<hdr.patterns;++i){
+        uint32_t len = 0;
+        ok = fread(&len, sizeof(len), 1, fin) == 1 && len <= (1u << 16);
+        if (!ok) break;
+        std::vector<int> p(len);
+        ok = fread(p.data(), sizeof(int), len, fin) == len;
+        patterns.push_back(p);
+    }
+    fclose(fin);
+    if (!ok){
+        std::cerr << "(MoveAutomaton::load) Error: <" << path << "> is not a move automaton" << std::endl;
+        return ERR_CODE::FILE_ERROR;
+    }
+    _codes = hdr.codes;
+    _states = hdr.states;
+    _delta.swap(delta);
+    _patterns.swap(patterns);
+    return ERR_CODE::SUCCESS;
+}
+
+// State reached from s by the moves with these codes (s itself for none)
+// @return nullptr if some code cannot be played
+static std::shared_ptr<State> replay(Game* g, const std::shared_ptr<State>& s, const std::vector<int>& seq){
+    std::shared_ptr<State> cur = s;
+    for (int code: seq){
+        std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+        if (g->get_successors(cur.get(), vsa)) return nullptr;
+        std::shared_ptr<State> next;
+        for (std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>& sa: vsa){
+            if (g->action_code(cur.get(), sa.second.get()) == code){
+                next = sa.first;
+                break;
+            }
+        }
+        if (!next) return nullptr;
+        cur = next;
+    }
+    return cur;
+}
+
+int MoveAutomaton::learn(Game* g, const std::vector<std::shared_ptr<State>>& roots, const std::vector<std::shared_ptr<State>>& samples,
+                         int max_len, size_t max_nodes, MoveAutomaton& out, LearnStats& stats){
+    stats = LearnStats();
+    int codes = g->action_codes();
+    if (codes <= 0){
+        std::cerr << "(MoveAutomaton::learn) Error: game has no action codes" << std::endl;
+        return ERR_CODE::NO_CODES;
+    }
+    std::vector<std::shared_ptr<State>> checks(roots);
+    checks.insert(checks.end(), samples.begin(), samples.end());
+    std::vector<std::vector<int>> patterns;
+    std::set<std::vector<int>> judged;
+    for (const std::shared_ptr<State>& root: roots){
+        // Sequences are kept as parent links, states only in the table
+        struct Node{
+            int parent;
+            int code;
+        };
+        std::vector<Node> nodes(1, Node{-1, -1});
+        std::unordered_map<std::shared_ptr<State>, int, StatePointerHash, DerefCompare> seen;
+        seen[root] = 0;
+        auto sequence = [&nodes](int id){
+            std::vector<int> seq;
+            for (;nodes[id].parent >= 0;id=nodes[id].parent) seq.push_back(nodes[id].code);
+            std::reverse(seq.begin(), seq.end());
+            return seq;
+        };
+        std::vector<std::pair<int, std::shared_ptr<State>>> frontier(1, std::make_pair(0, root)), next_frontier;
+        for (int depth=0;depth<max_len && !frontier.empty();++depth){
+            // Patterns learned so far prune this level
+            MoveAutomaton fsm;
+            fsm.build(codes, patterns);
+            // Duplicate and the earlier sequence reaching its state
+            std::vector<std::pair<std::vector<int>, std::vector<int>>> found;
+            next_frontier.clear();
+            for (std::pair<int, std::shared_ptr<State>>& f: frontier){
+                std::vector<int> seq = sequence(f.first);
+                int q = fsm.start();
+                for (size_t i=0;i<seq.size() && q != REJECT;++i) q = fsm.next(q, seq[i]);
+                if (q == REJECT) continue;
+                std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+                int expand_code = g->get_successors(f.second.get(), vsa);
+                if (expand_code){
+                    std::cerr << "(MoveAutomaton::learn) Error: get_successors failed with " << expand_code << std::endl;
+                    return ERR_CODE::GAME_ERROR;
+                }
+                // Children in code order, so every level is sorted by sequence and
+                // the first sequence to reach a state is the smallest
+                std::vector<std::pair<int, size_t>> order;
+                for (size_t i=0;i<vsa.size();++i){
+                    int code = g->action_code(f.second.get(), vsa[i].second.get());
+                    if (code >= 0 && code < codes) order.push_back(std::make_pair(code, i));
+                }
+                std::sort(order.begin(), order.end());
+                for (std::pair<int, size_t>& ci: order){
+                    if (fsm.next(q, ci.first) == REJECT) continue;
+                    std::shared_ptr<State>& child = vsa[ci.second].first;
+                    std::unordered_map<std::shared_ptr<State>, int, StatePointerHash, DerefCompare>::iterator it = seen.find(child);
+                    if (it != seen.end()){
+                        stats.duplicates++;
+                        std::vector<int> a(seq);
+                        a.push_back(ci.first);
+                        if (judged.insert(a).second) found.push_back(std::make_pair(a, sequence(it->second)));
+                        continue;
+                    }
+                    if (seen.size() >= max_nodes){
+                        stats.truncated = true;
+                        continue;
+                    }
+                    nodes.push_back(Node{f.first, ci.first});
+                    seen[child] = nodes.size() - 1;
+                    next_frontier.push_back(std::make_pair((int)nodes.size() - 1, child));
+                }
+            }
+            // Keep a duplicate only if its partner does the same from every check state
+            for (std::pair<std::vector<int>, std::vector<int>>& ab: found){
+                bool holds = true;
+                for (const std::shared_ptr<State>& t: checks){
+                    std::shared_ptr<State> end_a = replay(g, t, ab.first);
+                    if (!end_a) continue;
+                    std::shared_ptr<State> end_b = replay(g, t, ab.second);
+                    if (!end_b || *end_a != *end_b){
+                        holds = false;
+                        break;
+                    }
+                }
+                if (holds) patterns.push_back(ab.first);
+                else stats.rejected++;
+            }
+            frontier.swap(next_frontier);
+            stats.depth = std::max(stats.depth, depth + 1);
+        }
+        stats.sequences += seen.size();
+    }
+    // A pattern learned from one root can contain a shorter one learned from a
+    // later root, drop those (shortest first, so every check sees its substrings)
+    std::stable_sort(patterns.begin(), patterns.end(), [](const std::vector<int>& a, const std::vector<int>& b){
+        return a.size() < b.size();
+    });
+    std::vector<std::vector<int>> kept;
+    MoveAutomaton shorter;
+    for (size_t i=0;i<patterns.size();++i){
+        if (i == 0 || patterns[i].size() != patterns[i-1].size()) shorter.build(codes, kept);
+        int q = shorter.start();
+        for (size_t k=0;k<patterns[i].size() && q != REJECT;++k) q = shorter.next(q, patterns[i][k]);
+        if (q != REJECT) kept.push_back(patterns[i]);
+    }
+    out.build(codes, kept);
+    stats.patterns = kept.size();
+    return ERR_CODE::SUCCESS;
+}
+
+void MoveAutomaton::random_states(Game* g, const std::shared_ptr<State>& start, int count, int max_steps, unsigned seed,
+                                  std::vector<std::shared_ptr<State>>& out){
+    std::mt19937 rng(seed);
+    for (int i=0;i<count;++i){
+        std::shared_ptr<State> cur = start;
+        int steps = max_steps > 0 ? rng() % (max_steps + 1) : 0;
+        for (int k=0;k<steps;++k){
+            std::vector<std::pair<std::shared_ptr<State>, std::shared_ptr<Action>>> vsa;
+            if (g->get_successors(cur.get(), vsa) || vsa.empty()) break;
+            cur = vsa[rng() % vsa.size()].first;
+        }
+        out.push_back(cur);
+    }
+}
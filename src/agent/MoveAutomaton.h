@@ -0,0 +1,72 @@
+#pragma once
+
+#include "../game/Game.h"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Finite-state machine over action codes that rejects non-canonical move sequences
+// (FSM pruning, Taylor & Korf). learn() explores code sequences breadth-first
+// from some root states. When a sequence A reaches a state already reached by an
+// earlier sequence B (shorter, or as long and smaller by codes), A is a
+// duplicate: wherever A can be played, B gets to the same state. The duplicates
+// become the forbidden patterns of an Aho-Corasick automaton with a full
+// transition table, so a search follows one transition per move and drops moves
+// that complete a pattern. Only the codes matter, so the pruning is exact only
+// for games whose moves act the same everywhere (NPuzzle); each candidate is
+// therefore replayed from sample states and dropped if A is playable and B is
+// not, or they end in different states (Sokoban push orders, for instance).
+class MoveAutomaton{
+    public:
+        // Transition into a forbidden pattern
+        static const int REJECT = -1;
+        enum ERR_CODE{
+            SUCCESS         = 0x0,
+            NO_CODES        = 0x1,  // Game has no action codes
+            GAME_ERROR      = 0x2,
+            FILE_ERROR      = 0x4
+        };
+        struct LearnStats{
+            size_t sequences;       // Distinct states reached (over all roots)
+            size_t duplicates;      // Sequences reaching a state already reached
+            size_t rejected;        // Duplicates a sample state disproved
+            size_t patterns;        // Forbidden patterns kept
+            int depth;              // Longest sequence explored
+            bool truncated;         // A root hit the node limit before max_len
+            LearnStats():sequences(0), duplicates(0), rejected(0), patterns(0), depth(0), truncated(false){}
+        };
+    private:
+        int _codes;
+        size_t _states;
+        std::vector<int> _delta;    // [state*_codes + code], REJECT or the next state
+        std::vector<std::vector<int>> _patterns;
+    public:
+        // Accepts everything
+        MoveAutomaton();
+        // Automaton forbidding every sequence containing one of patterns (codes < codes)
+        void build(int codes, const std::vector<std::vector<int>>& patterns);
+        int start() const{return 0;}
+        // State after code, REJECT if the sequence must be pruned. Codes outside
+        // [0, codes()) (moves without a code) go back to the start
+        inline int next(int state, int code) const{
+            if ((unsigned)code >= (unsigned)_codes) return 0;
+            return _delta[state*_codes + code];
+        }
+        int codes() const{return _codes;}
+        size_t states() const{return _states;}
+        const std::vector<std::vector<int>>& get_patterns() const{return _patterns;}
+        size_t memory_bytes() const{return _delta.size()*sizeof(int);}
+        // Header, transition table and patterns
+        // @return ERR_CODE
+        int save(const std::string& path) const;
+        int load(const std::string& path);
+        // Learn duplicate patterns up to max_len codes by BFS from each root (at most
+        // max_nodes states per root), verified from every sample state, into out
+        // @return ERR_CODE
+        static int learn(Game* g, const std::vector<std::shared_ptr<State>>& roots, const std::vector<std::shared_ptr<State>>& samples,
+                         int max_len, size_t max_nodes, MoveAutomaton& out, LearnStats& stats);
+        // Append count states reached by random walks of up to max_steps moves from start (roots and samples for learn)
+        static void random_states(Game* g, const std::shared_ptr<State>& start, int count, int max_steps, unsigned seed,
+                                  std::vector<std::shared_ptr<State>>& out);
+};
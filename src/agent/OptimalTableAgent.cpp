@@ -0,0 +1,62 @@
+#include "OptimalTableAgent.h"
+
+OptimalTableAgent::OptimalTableAgent(NPuzzle* np, const NPuzzleTable* t): Agent(np), puzzle(np), table(t){}
+
+OptimalTableAgent::~OptimalTableAgent(){
+    // !IMPORTANT Release control of pointers
+    puzzle = nullptr;
+    table = nullptr;
+}
+
+int OptimalTableAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    typedef std::pair<std::shared_ptr<State>, std::shared_ptr<Action>> pair_sa;
+    if (!table || !table->is_open() || table->get_dims() != puzzle->get_dims()){
+        std::cerr << "(OptimalTableAgent::solve) Error: table does not match puzzle dimensions" << std::endl;
+        return -1;
+    }
+    begin_solve();
+    auto finish = [&](int code){
+        end_solve();
+        return code;
+    };
+    std::shared_ptr<State> cur_state = puzzle->get_state();
+    const TileState* ts = dynamic_cast<const TileState*>(cur_state.get());
+    if (!ts) return finish(NPuzzle::ERR_CODE::STATE_TYPE_ERROR);
+    uint8_t cur_depth = table->get(ts);
+    if (cur_depth == NPuzzleTable::UNREACHED){
+        std::cerr << "(OptimalTableAgent::solve) No solution path found..." << std::endl;
+        return finish(Agent::SOLVE_STATUS::NO_SOLUTION);  // Wrong parity
+    }
+    // Every step strictly decreases the true depth, so this bounds the loop
+    uint64_t max_steps = table->size();
+    long long steps = 0;
+    while (!puzzle->is_goal_state(cur_state.get())){
+        if (max_steps-- == 0) return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+        int budget_code = check_budget(++steps, 0);
+        if (budget_code) return finish(budget_code);
+        std::vector<pair_sa> vsa;
+        int expand_code = puzzle->get_successors(cur_state.get(), vsa);
+        if (expand_code){
+            std::cerr << "(OptimalTableAgent::solve) get_successors failed with " << expand_code << std::endl;
+            return finish(expand_code);
+        }
+        // Neighbours sit at depth +-1, look for the one a step closer to the goal
+        uint8_t want = (cur_depth + NPuzzleTable::DEPTH_MOD - 1) % NPuzzleTable::DEPTH_MOD;
+        bool stepped = false;
+        for (pair_sa& state_action: vsa){
+            if (table->get(dynamic_cast<const TileState*>(state_action.first.get())) == want){
+                va.push_back(state_action.second);
+                cur_state = state_action.first;
+                cur_depth = want;
+                stepped = true;
+                break;
+            }
+        }
+        if (!stepped){
+            std::cerr << "(OptimalTableAgent::solve) Error: table is inconsistent with puzzle" << std::endl;
+            return finish(Agent::SOLVE_STATUS::NO_SOLUTION);
+        }
+        _stats.generated += vsa.size();
+    }
+    return finish(Agent::SOLVE_STATUS::SOLVED);
+}
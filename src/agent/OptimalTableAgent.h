@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Agent.h"
+#include "../game/NPuzzle.h"
+#include "../game/NPuzzleTable.h"
+#include <vector>
+#include <memory>
+
+// Solves small NPuzzle instances optimally without search by descending
+// a complete distance table (see NPuzzleTable), O(solution length) lookups
+class OptimalTableAgent: public Agent{
+    private:
+        NPuzzle* puzzle;
+        const NPuzzleTable* table;
+    public:
+        // Table must have been generated for the same board dimensions
+        OptimalTableAgent(NPuzzle* np, const NPuzzleTable* t);
+        // Destructor (don't destroy table)
+        virtual ~OptimalTableAgent();
+        // Solution
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+};
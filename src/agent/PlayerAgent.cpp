@@ -33,9 +33,17 @@ bool PlayerAgent::get_action(const State* s, std::string& key){
 // Interactive CLI process
 int PlayerAgent::solve(std::vector<std::shared_ptr<Action>>& va){
 	// Grab current game state
+	begin_solve();
 	std::shared_ptr<State> state = game->get_state();
 	std::string action;
+	long long moves = 0;
 	while (!game->is_goal_state(state.get()) && get_action(state.get(), action)){
+		// Budgets are tested between moves (the player is never interrupted mid-input)
+		int budget_code = check_budget(++moves, 0, true);
+		if (budget_code){
+			end_solve();
+			return budget_code;
+		}
 		// Execute player input action
 		int play_code = game->play(action);
 		if (! play_code){
@@ -50,6 +58,7 @@ int PlayerAgent::solve(std::vector<std::shared_ptr<Action>>& va){
 			continue;
 		}
 	}
+	end_solve();
 	if (action.compare("END") == 0){
 		return 1;
 	}
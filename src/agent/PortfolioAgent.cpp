@@ -0,0 +1,140 @@
+#include "PortfolioAgent.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+PortfolioAgent::PortfolioAgent(Game* g, mode_type mode): Agent(g), _mode(mode){}
+
+PortfolioAgent::~PortfolioAgent(){
+    for (Member& m: _members) delete m.agent;
+    search_problem = nullptr;
+}
+
+void PortfolioAgent::add(Agent* a, const std::string& name){
+    Member m;
+    m.agent = a;
+    m.name = name;
+    m.status = Agent::SOLVE_STATUS::NO_SOLUTION;
+    m.cost = 0.0;
+    _members.push_back(m);
+}
+
+const std::string& PortfolioAgent::get_winner() const{
+    return _winner;
+}
+
+size_t PortfolioAgent::size() const{
+    return _members.size();
+}
+
+const std::string& PortfolioAgent::member_name(size_t i) const{
+    return _members[i].name;
+}
+
+int PortfolioAgent::member_status(size_t i) const{
+    return _members[i].status;
+}
+
+const SearchStats& PortfolioAgent::member_stats(size_t i) const{
+    return _members[i].agent->get_stats();
+}
+
+int PortfolioAgent::solve(std::vector<std::shared_ptr<Action>>& va){
+    typedef SolveOptions::clock clock;
+    begin_solve();
+    clock::time_point start = clock::now();
+    _winner.clear();
+    if (_members.empty()){
+        end_solve();
+        return Agent::SOLVE_STATUS::NO_SOLUTION;
+    }
+
+    // Members share one cancel flag; the caller's flag is forwarded below.
+    // Time budgets become one absolute deadline for everyone, node and memory
+    // limits apply to each member separately
+    std::atomic<bool> cancel(false);
+    SolveOptions member_options = _options;
+    member_options.cancel = &cancel;
+    member_options.verbose = false;
+    member_options.time_limit_ms = 0;
+    if (_options.time_limit_ms > 0){
+        clock::time_point limit = start + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double, std::milli>(_options.time_limit_ms));
+        if (member_options.deadline == clock::time_point() || limit < member_options.deadline) member_options.deadline = limit;
+    }
+
+    std::mutex lock;
+    std::condition_variable done_cv;
+    size_t finished = 0;
+    int first = -1;
+    std::vector<std::thread> threads;
+    for (size_t i=0;i<_members.size();++i){
+        _members[i].solution.clear();
+        _members[i].agent->set_options(member_options);
+        threads.push_back(std::thread([&, i](){
+            Member& m = _members[i];
+            Trace::set_thread_name("portfolio " + m.name);
+            m.status = m.agent->solve(m.solution);
+            m.cost = 0.0;
+            for (std::shared_ptr<Action>& a: m.solution) m.cost += a->_cost;
+            std::lock_guard<std::mutex> guard(lock);
+            if (m.status == Agent::SOLVE_STATUS::SOLVED && first < 0) first = i;
+            ++finished;
+            done_cv.notify_all();
+        }));
+    }
+
+    // Wait for the race to settle, polling the caller's cancel flag
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        while (finished < _members.size()){
+            if (_mode == FIRST_SOLUTION && first >= 0) break;
+            if (_options.cancelled()) break;
+            done_cv.wait_for(guard, std::chrono::milliseconds(10));
+        }
+    }
+    cancel = true;
+    for (std::thread& t: threads) t.join();
+
+    // Pick the result
+    int best = -1;
+    if (_mode == FIRST_SOLUTION){
+        best = first;
+    }
+    else{
+        for (size_t i=0;i<_members.size();++i){
+            if (_members[i].status != Agent::SOLVE_STATUS::SOLVED) continue;
+            if (best < 0 || _members[i].cost < _members[best].cost) best = i;
+        }
+    }
+    for (Member& m: _members){
+        const SearchStats& s = m.agent->get_stats();
+        _stats.expanded += s.expanded;
+        _stats.generated += s.generated;
+        _stats.memory_bytes += s.memory_bytes;
+        _stats.bytes_read += s.bytes_read;
+        _stats.bytes_written += s.bytes_written;
+    }
+    end_solve();
+
+    if (_options.verbose){
+        for (Member& m: _members){
+            std::cout << "Portfolio " << m.name << ": " << Agent::status_name(m.status);
+            if (m.status == Agent::SOLVE_STATUS::SOLVED) std::cout << " (" << m.solution.size() << " moves, cost " << m.cost << ")";
+            std::cout << " after " << m.agent->get_stats().expanded << " expansions" << std::endl;
+        }
+    }
+    if (best < 0){
+        if (_options.cancelled()) return Agent::SOLVE_STATUS::CANCELLED;
+        // Report the most informative failure (a budget before plain no-solution)
+        int status = Agent::SOLVE_STATUS::NO_SOLUTION;
+        for (Member& m: _members){
+            if (m.status != Agent::SOLVE_STATUS::NO_SOLUTION) status = m.status;
+        }
+        return status;
+    }
+    _winner = _members[best].name;
+    if (_options.verbose) std::cout << "Portfolio winner: " << _winner << std::endl;
+    va.insert(va.end(), _members[best].solution.begin(), _members[best].solution.end());
+    return Agent::SOLVE_STATUS::SOLVED;
+}
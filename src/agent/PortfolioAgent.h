@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Agent.h"
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+
+// Races several agent configurations (weights, heuristics, agent types) on the
+// same Game, one thread each. Members only read the Game, so they share it.
+// FIRST_SOLUTION returns as soon as any member solves and cancels the rest.
+// BEST_BY_DEADLINE lets members run until the time limit (or until all finish)
+// and returns the cheapest solution, cancelling whoever is still running.
+class PortfolioAgent: public Agent{
+    public:
+        enum mode_type{
+            FIRST_SOLUTION      = 0,
+            BEST_BY_DEADLINE    = 1
+        };
+    private:
+        struct Member{
+            Agent* agent;
+            std::string name;
+            int status;
+            double cost;
+            std::vector<std::shared_ptr<Action>> solution;
+        };
+        std::vector<Member> _members;
+        mode_type _mode;
+        std::string _winner;
+    public:
+        PortfolioAgent(Game* g, mode_type mode=FIRST_SOLUTION);
+        // Destroys member agents
+        virtual ~PortfolioAgent();
+        // Add a configuration (portfolio takes ownership of a)
+        void add(Agent* a, const std::string& name);
+        // Stats are summed over members, time is wall time of the race
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override;
+        // Name of the member whose solution was returned (empty if none)
+        const std::string& get_winner() const;
+        // Per-member outcome of the last solve
+        size_t size() const;
+        const std::string& member_name(size_t i) const;
+        int member_status(size_t i) const;
+        const SearchStats& member_stats(size_t i) const;
+};
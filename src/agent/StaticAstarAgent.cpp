@@ -0,0 +1,31 @@
+#include "StaticAstarAgent.h"
+#include "../game/FixedNPuzzle.h"
+#include "../game/SokobanKernel.h"
+#include "../heuristic/FixedNPuzzleHeuristic.h"
+#include "../heuristic/SokobanKernelHeuristic.h"
+
+template<int R, int C>
+static Agent* make_fixed(Game* g, double weight){
+    FixedNPuzzle<R, C>* fixed = dynamic_cast<FixedNPuzzle<R, C>*>(g);
+    if (!fixed) return nullptr;
+    return new StaticAstarAgent<FixedNPuzzle<R, C>, FixedNPuzzleHeuristic<R, C>>(g, *fixed, weight);
+}
+
+template<int W>
+static Agent* make_sokoban(Sokoban* sok, double weight){
+    if (sok->get_num_floor() > SokobanKernel<W>::capacity()) return nullptr;
+    return new StaticAstarAgent<SokobanKernel<W>, SokobanKernelHeuristic<W>>(sok, SokobanKernel<W>(*sok), weight);
+}
+
+Agent* make_static_astar(Game* g, double weight){
+    if (Agent* a = make_fixed<3, 3>(g, weight)) return a;
+    if (Agent* a = make_fixed<4, 4>(g, weight)) return a;
+    if (Agent* a = make_fixed<5, 5>(g, weight)) return a;
+    Sokoban* sok = dynamic_cast<Sokoban*>(g);
+    if (!sok) return nullptr;
+    // Smallest state that holds the level's floor
+    if (Agent* a = make_sokoban<1>(sok, weight)) return a;
+    if (Agent* a = make_sokoban<2>(sok, weight)) return a;
+    if (Agent* a = make_sokoban<4>(sok, weight)) return a;
+    return make_sokoban<8>(sok, weight);
+}
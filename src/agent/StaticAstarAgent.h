@@ -0,0 +1,64 @@
+#pragma once
+
+#include "Agent.h"
+#include "AStar.h"
+#include <vector>
+#include <memory>
+#include <iostream>
+
+// Agent adapter over AStar<GameT, HeuristicT>
+// solve() converts the game's current state to the kernel's value state, runs the
+// statically dispatched search and turns its moves back into the game's Actions.
+// GameT additionally provides
+//   bool from_state(const State*, state_type&) const
+//   std::shared_ptr<Action> to_action(const move_type&) const
+// and HeuristicT is default constructible. Budgets and stats work as for any Agent.
+template<class GameT, class HeuristicT>
+class StaticAstarAgent: public Agent{
+    private:
+        GameT _kernel;
+        HeuristicT _heuristic;
+        AStar<GameT, HeuristicT> _astar;
+    public:
+        // g is the game solved (its current state is the start), kernel the same level as value states
+        StaticAstarAgent(Game* g, const GameT& kernel, double weight=1.0)
+            :Agent(g), _kernel(kernel), _heuristic(), _astar(_kernel, _heuristic, weight){}
+        virtual ~StaticAstarAgent(){
+            search_problem = nullptr;
+        }
+        void set_weight(double w){
+            _astar.set_weight(w);
+        }
+        virtual int solve(std::vector<std::shared_ptr<Action>>& va) override{
+            begin_solve();
+            typename GameT::state_type start;
+            if (!_kernel.from_state(search_problem->get_state().get(), start)){
+                std::cerr << "(StaticAstarAgent::solve) Error: the game's state does not fit the kernel" << std::endl;
+                end_solve();
+                return Agent::SOLVE_STATUS::NO_SOLUTION;
+            }
+            std::vector<typename GameT::move_type> moves;
+            int code = _astar.solve(start, moves, [this](long long expanded, size_t bytes){
+                return check_budget(expanded, bytes);
+            });
+            check_budget(_astar.expanded(), _astar.memory_bytes(), true);
+            _stats.generated = _astar.generated();
+            end_solve();
+            if (_options.verbose){
+                std::cout << "Static astar visited: " << _astar.expanded() << " States (" << _astar.size() << " distinct)" << std::endl;
+            }
+            _astar.clear();
+            if (code == AStar<GameT, HeuristicT>::SOLVED){
+                for (const typename GameT::move_type& m: moves) va.push_back(_kernel.to_action(m));
+            }
+            else if (code == AStar<GameT, HeuristicT>::NO_SOLUTION && _options.verbose){
+                std::cerr << "(StaticAstarAgent::solve) No solution path found..." << std::endl;
+            }
+            return code;
+        }
+};
+
+// StaticAstarAgent for g when it has a kernel: FixedNPuzzle 3x3, 4x4, 5x5 or a
+// Sokoban level of up to 512 floor cells (searched by pushes, as in prune mode)
+// @return nullptr otherwise (caller owns the result)
+Agent* make_static_astar(Game* g, double weight=1.0);
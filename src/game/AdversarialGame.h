@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Game.h"
+#include <cstdint>
+#include <memory>
+
+// Game between two players, optionally with chance nodes, for game-tree search
+// (AlphaBetaAgent, ExpectimaxAgent). Moves are small integers below max_moves(),
+// so agents can index history tables by them, and they are made and unmade on
+// one state in place. A state's side to move is MAX_PLAYER, MIN_PLAYER or
+// CHANCE; at chance nodes the moves are the outcomes, weighted by
+// move_probability. The Game interface (actions, successors, play) still works,
+// so the same games can be played from the console or driven by other agents.
+class AdversarialGame: public Game{
+    public:
+        enum PLAYER{
+            MAX_PLAYER  = 0,    // Moves first
+            MIN_PLAYER  = 1,
+            CHANCE      = 2
+        };
+        // Scores at or beyond +-WIN_BOUND are won/lost positions
+        static const int WIN_SCORE = 1000000;
+        static const int WIN_BOUND = WIN_SCORE - 1000;
+        // Side to move in s
+        virtual int to_move(const State* s) const = 0;
+        virtual bool is_terminal(const State* s) const = 0;
+        // Value of s for player: +-WIN_SCORE (or 0 for a draw) at terminals, a heuristic estimate elsewhere
+        virtual int evaluate(const State* s, int player) const = 0;
+        // Legal moves in s, in a good default search order
+        // @return number of moves written (at most max_moves())
+        virtual int get_moves(const State* s, int* moves) const = 0;
+        virtual void make_move(State* s, int move) const = 0;
+        // Reverses make_move(s, move), the last move made on s
+        virtual void undo_move(State* s, int move) const = 0;
+        // Upper bound on move values (moves are 0 .. max_moves()-1)
+        virtual int max_moves() const = 0;
+        // Probability of outcome move at a CHANCE node
+        virtual double move_probability(const State* s, int move) const{return 0.0;}
+        // 64-bit transposition key, equal states must give equal keys
+        virtual uint64_t key(const State* s) const{return s->hash();}
+        // Game action for a move (to return from Agent::solve)
+        virtual std::shared_ptr<Action> to_action(const State* s, int move) const = 0;
+        virtual ~AdversarialGame(){};
+};
@@ -0,0 +1,216 @@
+#include "ConnectFour.h"
+#include <string>
+
+// One bit at the bottom of every column, and every playable cell
+static const uint64_t BOTTOM_MASK = 0x0040810204081ULL;
+static const uint64_t BOARD_MASK = BOTTOM_MASK*((1ULL << ConnectFour::ROWS) - 1);
+static const uint64_t CENTER_MASK = ((1ULL << ConnectFour::ROWS) - 1) << (3*(ConnectFour::ROWS + 1));
+// Search order, centre first
+static const int MOVE_ORDER[ConnectFour::COLS] = {3, 2, 4, 1, 5, 0, 6};
+
+//////////////////////
+// ConnectFourState //
+//////////////////////
+ConnectFourState::ConnectFourState():_moves(0){
+    _bb[0] = _bb[1] = 0;
+    for (int c=0;c<ConnectFour::COLS;++c) _height[c] = c*(ConnectFour::ROWS + 1);
+}
+
+bool ConnectFourState::operator==(const State& other) const{
+    const ConnectFourState* cs = dynamic_cast<const ConnectFourState*>(&other);
+    return cs && _bb[0] == cs->_bb[0] && _bb[1] == cs->_bb[1];
+}
+
+bool ConnectFourState::operator!=(const State& other) const{
+    return !(*this == other);
+}
+
+void ConnectFourState::display(std::ostream& os) const{
+    for (int r=ConnectFour::ROWS-1;r>=0;--r){
+        for (int c=0;c<ConnectFour::COLS;++c){
+            uint64_t bit = 1ULL << (c*(ConnectFour::ROWS + 1) + r);
+            os << ((_bb[0] & bit) ? 'X' : (_bb[1] & bit) ? 'O' : '.');
+        }
+        os << std::endl;
+    }
+    for (int c=0;c<ConnectFour::COLS;++c) os << c + 1;
+    os << std::endl;
+}
+
+size_t ConnectFourState::hash() const{
+    // Side to move's stones plus the occupancy (with a bit above each column) name the position
+    return mix64(_bb[_moves & 1] + (_bb[0] | _bb[1]) + BOTTOM_MASK);
+}
+
+size_t ConnectFourState::footprint() const{
+    return sizeof(ConnectFourState);
+}
+
+uint64_t ConnectFourState::get_stones(int player) const{
+    return _bb[player];
+}
+
+int ConnectFourState::get_moves() const{
+    return _moves;
+}
+
+/////////////////
+// ConnectFour //
+/////////////////
+ConnectFour::ConnectFour(){
+    _state = new ConnectFourState();
+}
+
+ConnectFour::ConnectFour(const ConnectFour& g){
+    _state = new ConnectFourState(*static_cast<ConnectFourState*>(g._state));
+}
+
+bool ConnectFour::load_moves(const std::string& seq){
+    ConnectFourState copy = *static_cast<ConnectFourState*>(_state);
+    for (char ch: seq){
+        int col = ch - '1';
+        if (col < 0 || col >= COLS || is_terminal(&copy) || copy._height[col] >= col*(ROWS + 1) + ROWS) return false;
+        make_move(&copy, col);
+    }
+    *static_cast<ConnectFourState*>(_state) = copy;
+    return true;
+}
+
+bool ConnectFour::has_four(uint64_t bb){
+    // Vertical, horizontal and both diagonals
+    for (int s: {1, ROWS + 1, ROWS, ROWS + 2}){
+        uint64_t m = bb & (bb >> s);
+        if (m & (m >> 2*s)) return true;
+    }
+    return false;
+}
+
+uint64_t ConnectFour::winning_cells(uint64_t own, uint64_t mask){
+    // Vertical: three stones below
+    uint64_t r = (own << 1) & (own << 2) & (own << 3);
+    for (int s: {ROWS + 1, ROWS, ROWS + 2}){
+        // Three of the four cells of a line through the empty cell, either side of it
+        uint64_t p = (own << s) & (own << 2*s);
+        r |= p & (own << 3*s);
+        r |= p & (own >> s);
+        p = (own >> s) & (own >> 2*s);
+        r |= p & (own << s);
+        r |= p & (own >> 3*s);
+    }
+    return r & (BOARD_MASK ^ mask);
+}
+
+std::shared_ptr<State> ConnectFour::get_state(){
+    return std::make_shared<ConnectFourState>(*static_cast<ConnectFourState*>(_state));
+}
+
+std::shared_ptr<State> ConnectFour::get_goal_state(){
+    return nullptr;
+}
+
+bool ConnectFour::is_goal_state(const State* s){
+    const ConnectFourState* cs = dynamic_cast<const ConnectFourState*>(s);
+    return cs && is_terminal(cs);
+}
+
+int ConnectFour::get_successors(const State* s, std::vector<std::pair<std::shared_ptr<State>,std::shared_ptr<Action>>>& v){
+    const ConnectFourState* cs = dynamic_cast<const ConnectFourState*>(s);
+    if (!cs) return ERR_CODE::STATE_TYPE_ERROR;
+    std::vector<std::shared_ptr<Action>> va;
+    get_actions(s, va);
+    for (std::shared_ptr<Action>& a: va){
+        std::shared_ptr<ConnectFourState> next = std::make_shared<ConnectFourState>(*cs);
+        make_move(next.get(), a->_specifier);
+        v.push_back(std::make_pair(next, a));
+    }
+    return ERR_CODE::SUCCESS;
+}
+
+int ConnectFour::get_actions(const State* s, std::vector<std::shared_ptr<Action>>& v){
+    const ConnectFourState* cs = dynamic_cast<const ConnectFourState*>(s);
+    if (!cs) return ERR_CODE::STATE_TYPE_ERROR;
+    if (is_terminal(cs)) return ERR_CODE::SUCCESS;
+    for (int c=0;c<COLS;++c){
+        if (cs->_height[c] < c*(ROWS + 1) + ROWS) v.push_back(to_action(cs, c));
+    }
+    return ERR_CODE::SUCCESS;
+}
+
+void ConnectFour::display(std::ostream& os){
+    _state->display(os);
+}
+
+int ConnectFour::play(Action* a){
+    return play_action(_state, a) ? ERR_CODE::SUCCESS : ERR_CODE::PLAY_FAILED;
+}
+
+bool ConnectFour::play_action(State* s, Action* a){
+    ConnectFourState* cs = dynamic_cast<ConnectFourState*>(s);
+    if (!cs || !a) return false;
+    int col = a->_specifier;
+    if (col < 0 || col >= COLS || is_terminal(cs) || cs->_height[col] >= col*(ROWS + 1) + ROWS) return false;
+    make_move(cs, col);
+    return true;
+}
+
+// The search hooks below take states the game itself produced, so they
+// static_cast (no type check on the hot path)
+int ConnectFour::to_move(const State* s) const{
+    return static_cast<const ConnectFourState*>(s)->_moves & 1;
+}
+
+bool ConnectFour::is_terminal(const State* s) const{
+    const ConnectFourState* cs = static_cast<const ConnectFourState*>(s);
+    // Only the last mover can have just made four
+    return cs->_moves >= ROWS*COLS || (cs->_moves && has_four(cs->_bb[(cs->_moves - 1) & 1]));
+}
+
+int ConnectFour::evaluate(const State* s, int player) const{
+    const ConnectFourState* cs = static_cast<const ConnectFourState*>(s);
+    uint64_t own = cs->_bb[player], opp = cs->_bb[player ^ 1];
+    if (has_four(own)) return WIN_SCORE;
+    if (has_four(opp)) return -WIN_SCORE;
+    if (cs->_moves >= ROWS*COLS) return 0;
+    uint64_t mask = own | opp;
+    int threats = __builtin_popcountll(winning_cells(own, mask)) - __builtin_popcountll(winning_cells(opp, mask));
+    int centre = __builtin_popcountll(own & CENTER_MASK) - __builtin_popcountll(opp & CENTER_MASK);
+    return 16*threats + 4*centre;
+}
+
+int ConnectFour::get_moves(const State* s, int* moves) const{
+    const ConnectFourState* cs = static_cast<const ConnectFourState*>(s);
+    int n = 0;
+    for (int c: MOVE_ORDER){
+        if (cs->_height[c] < c*(ROWS + 1) + ROWS) moves[n++] = c;
+    }
+    return n;
+}
+
+void ConnectFour::make_move(State* s, int move) const{
+    ConnectFourState* cs = static_cast<ConnectFourState*>(s);
+    cs->_bb[cs->_moves & 1] |= 1ULL << cs->_height[move]++;
+    cs->_moves++;
+}
+
+void ConnectFour::undo_move(State* s, int move) const{
+    ConnectFourState* cs = static_cast<ConnectFourState*>(s);
+    cs->_moves--;
+    cs->_bb[cs->_moves & 1] ^= 1ULL << --cs->_height[move];
+}
+
+int ConnectFour::max_moves() const{
+    return COLS;
+}
+
+uint64_t ConnectFour::key(const State* s) const{
+    return s->hash();
+}
+
+std::shared_ptr<Action> ConnectFour::to_action(const State* s, int move) const{
+    return std::make_shared<Action>(move, 1.0, "DROP " + std::to_string(move + 1));
+}
+
+std::ostream& operator<<(std::ostream& os, ConnectFour& g){
+    g.display(os);
+    return os;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "AdversarialGame.h"
+#include "../util/Hash.h"
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+class ConnectFour;
+
+// Connect-Four position on bitboards
+// Column c holds bits c*7 .. c*7+5 (bottom to top). Bit c*7+6 is always empty,
+// so shifting a line of stones never wraps into the next column.
+class ConnectFourState: public State{
+    friend ConnectFour;
+    private:
+        uint64_t _bb[2];        // Stones of the first and second player
+        uint8_t _height[7];     // Next free bit of each column
+        int _moves;             // Stones on the board
+    public:
+        ConnectFourState();
+        virtual ~ConnectFourState(){};
+        bool operator==(const State& other) const override;
+        bool operator!=(const State& other) const override;
+        virtual void display(std::ostream& os) const override;
+        size_t hash() const override;
+        size_t footprint() const override;
+        // Stones of player (0 = first to move)
+        uint64_t get_stones(int player) const;
+        int get_moves() const;
+};
+
+class ConnectFour: public AdversarialGame{
+    friend std::ostream& operator<<(std::ostream& os, ConnectFour& g);
+    public:
+        static const int COLS = 7;
+        static const int ROWS = 6;
+        // Make visible some error codes (to return from get_successors || get_actions || play)
+        enum ERR_CODE{
+            SUCCESS                 = 0x0,
+            STATE_TYPE_ERROR        = 0x1,
+            PLAY_FAILED             = 0x8
+        };
+        ConnectFour();
+        ConnectFour(const ConnectFour& g);
+        // Play a sequence of columns (e.g. "4453", 1-based as usually written)
+        // @return false (state unchanged) if a move is illegal
+        bool load_moves(const std::string& seq);
+        // Bitboard has four in a row
+        static bool has_four(uint64_t bb);
+        // Empty cells where player's next stone would make four
+        static uint64_t winning_cells(uint64_t own, uint64_t mask);
+
+        // Game interface (actions are columns, _specifier = column)
+        virtual std::shared_ptr<State> get_state() override;
+        // No single goal state
+        virtual std::shared_ptr<State> get_goal_state() override;
+        // Someone has won or the board is full
+        virtual bool is_goal_state(const State* s) override;
+        // @return ERR_CODE
+        virtual int get_successors(const State* s, std::vector<std::pair<std::shared_ptr<State>,std::shared_ptr<Action>>>& v) override;
+        // @return ERR_CODE
+        virtual int get_actions(const State* s, std::vector<std::shared_ptr<Action>>& v) override;
+        virtual void display(std::ostream& os) override;
+        // @return ERR_CODE
+        virtual int play(Action* a) override;
+        virtual bool play_action(State* s, Action* a) override;
+
+        // AdversarialGame interface (moves are columns 0-6)
+        virtual int to_move(const State* s) const override;
+        virtual bool is_terminal(const State* s) const override;
+        // Open threats (empty cells completing four) and centre stones, for player
+        virtual int evaluate(const State* s, int player) const override;
+        // Centre columns first
+        virtual int get_moves(const State* s, int* moves) const override;
+        virtual void make_move(State* s, int move) const override;
+        virtual void undo_move(State* s, int move) const override;
+        virtual int max_moves() const override;
+        virtual uint64_t key(const State* s) const override;
+        virtual std::shared_ptr<Action> to_action(const State* s, int move) const override;
+        virtual ~ConnectFour(){};
+};
+
+std::ostream& operator<<(std::ostream& os, ConnectFour& g);
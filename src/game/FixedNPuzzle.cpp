@@ -0,0 +1,12 @@
+#include "FixedNPuzzle.h"
+
+template class FixedNPuzzle<3, 3>;
+template class FixedNPuzzle<4, 4>;
+template class FixedNPuzzle<5, 5>;
+
+Game* make_fixed_npuzzle(int rows, int cols, const TileState& start){
+    if (rows == 3 && cols == 3) return new FixedNPuzzle<3, 3>(start);
+    if (rows == 4 && cols == 4) return new FixedNPuzzle<4, 4>(start);
+    if (rows == 5 && cols == 5) return new FixedNPuzzle<5, 5>(start);
+    return nullptr;
+}
@@ -0,0 +1,289 @@
+#pragma once
+
+#include "Game.h"
+#include "NPuzzle.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// NPuzzle with board dimensions fixed at compile time
+// The board is a packed byte array (cell y*C+x holds the goal index of its tile,
+// 0 is the blank) so neighbour and Manhattan tables are constexpr and every loop
+// over the board has a constant trip count the compiler fully unrolls.
+// Actions are the same NESW Action specifiers as NPuzzle, so solutions found on a
+// FixedNPuzzle replay directly on the NPuzzle it was built from.
+
+// Compile-time loop unrolling: calls f(I), f(I+1), ..., f(N-1)
+template<int I, int N>
+struct Unroll{
+    template<class F>
+    static inline void run(F& f){
+        f(I);
+        Unroll<I+1, N>::run(f);
+    }
+};
+
+template<int N>
+struct Unroll<N, N>{
+    template<class F>
+    static inline void run(F&){}
+};
+
+// Neighbour and Manhattan lookup tables, generated at compile time
+template<int R, int C>
+struct FixedBoardTables{
+    static constexpr int N = R*C;
+    // neighbour[p][d] is the cell reached from p moving in direction d (NESW) or -1
+    int8_t neighbour[N][4];
+    // manhattan[t][p] is the distance from cell p to tile t's home (0 for the blank)
+    uint8_t manhattan[N][N];
+    constexpr FixedBoardTables():neighbour(), manhattan(){
+        // Same NESW offsets as Game::ADJ
+        const int adj[4][2] = {{0,-1},{1,0},{0,1},{-1,0}};
+        for (int p=0;p<N;++p){
+            int x = p % C;
+            int y = p / C;
+            for (int d=0;d<4;++d){
+                int nx = x + adj[d][0];
+                int ny = y + adj[d][1];
+                neighbour[p][d] = (nx >= 0 && ny >= 0 && nx < C && ny < R) ? ny*C + nx : -1;
+            }
+            for (int t=0;t<N;++t){
+                int dx = x - t % C;
+                int dy = y - t / C;
+                manhattan[t][p] = (t == 0) ? 0 : (dx < 0 ? -dx : dx) + (dy < 0 ? -dy : dy);
+            }
+        }
+    }
+};
+
+template<int R, int C> class FixedNPuzzle;
+
+template<int R, int C>
+class FixedTileState: public State{
+    friend class FixedNPuzzle<R, C>;
+    public:
+        static constexpr int N = R*C;
+        // Packed board and cached blank position
+        uint8_t _board[N];
+        uint8_t _blank;
+        // Goal board
+        FixedTileState():_blank(0){
+            auto fill = [this](int p){ _board[p] = p; };
+            Unroll<0, N>::run(fill);
+        }
+        // Convert from a runtime NPuzzle state of matching dimensions
+        explicit FixedTileState(const TileState& ts):_blank(0){
+            for (int y=0;y<R;++y){
+                for (int x=0;x<C;++x){
+                    pii home = ts.get_tile_home_position(x, y);
+                    _board[y*C+x] = home.second*C + home.first;
+                    if (!ts.get_tile_real(x, y)) _blank = y*C+x;
+                }
+            }
+        }
+        FixedTileState(const FixedTileState& fs) = default;
+        virtual ~FixedTileState(){};
+        // Comparators
+        bool operator==(const State& other) const override{
+            const FixedTileState* fs = dynamic_cast<const FixedTileState*>(&other);
+            return fs && equals(*fs);
+        }
+        bool operator!=(const State& other) const override{
+            return !(*this == other);
+        }
+        inline bool equals(const FixedTileState& other) const{
+            return memcmp(_board, other._board, N) == 0;
+        }
+        // Display goal index of each tile, blank as '.'
+        virtual void display(std::ostream& os) const override{
+            for (int y=0;y<R;++y){
+                for (int x=0;x<C;++x){
+                    int t = _board[y*C+x];
+                    if (t) os << (t < 10 ? "  " : " ") << t;
+                    else os << "  .";
+                }
+                os << std::endl;
+            }
+            os << std::endl;
+        }
+        // Hash function for set membership
+        size_t hash() const override{
+            return hash_bytes(_board, N);
+        }
+        size_t footprint() const override{
+            return sizeof(*this);
+        }
+};
+
+template<int R, int C>
+class FixedNPuzzle: public Game{
+    public:
+        typedef FixedTileState<R, C> state_type;
+        typedef int move_type;  // Blank direction (NESW)
+        typedef FixedBoardTables<R, C> tables_type;
+        static constexpr int N = R*C;
+        static constexpr tables_type tables{};
+    private:
+        state_type _goal_state;
+        // Static 'Standard' actions (same specifiers as NPuzzle)
+        std::shared_ptr<Action> actions[4] = {
+            std::make_shared<Action>(NPuzzle::legal_actions::north,1.0,"N"),
+            std::make_shared<Action>(NPuzzle::legal_actions::east,1.0,"E"),
+            std::make_shared<Action>(NPuzzle::legal_actions::south,1.0,"S"),
+            std::make_shared<Action>(NPuzzle::legal_actions::west,1.0,"W")
+        };
+    public:
+        // Start at the goal
+        FixedNPuzzle(){
+            this->_state = new state_type();
+        }
+        // Start from a runtime NPuzzle state of matching dimensions
+        explicit FixedNPuzzle(const TileState& ts){
+            this->_state = new state_type(ts);
+        }
+        FixedNPuzzle(const FixedNPuzzle& fp){
+            this->_state = new state_type(*static_cast<const state_type*>(fp._state));
+        }
+        virtual ~FixedNPuzzle(){};
+
+        ///////////////////////////////////
+        // Statically dispatched kernels //
+        ///////////////////////////////////
+        // Blank moves available from s, writes directions into dirs
+        // @return number of moves
+        static inline int moves(const state_type& s, int dirs[4]){
+            int n = 0;
+            auto test = [&s, &n, dirs](int d){
+                if (tables.neighbour[s._blank][d] >= 0) dirs[n++] = d;
+            };
+            Unroll<0, 4>::run(test);
+            return n;
+        }
+        // Slide the tile in direction d into the blank (d must be legal)
+        static inline void apply(state_type& s, int d){
+            int nb = tables.neighbour[s._blank][d];
+            s._board[s._blank] = s._board[nb];
+            s._board[nb] = 0;
+            s._blank = nb;
+        }
+        // Sum of tile Manhattan distances (blank excluded)
+        static inline int manhattan(const state_type& s){
+            int h = 0;
+            auto add = [&s, &h](int p){ h += tables.manhattan[s._board[p]][p]; };
+            Unroll<0, N>::run(add);
+            return h;
+        }
+        inline bool is_goal(const state_type& s) const{
+            return s.equals(_goal_state);
+        }
+        // Value-state interface for AStar<FixedNPuzzle, ...> (see AStar.h)
+        inline uint64_t key_hash(const state_type& s) const{
+            return hash_bytes(s._board, N);
+        }
+        inline bool key_equal(const state_type& a, const state_type& b) const{
+            return a.equals(b);
+        }
+        template<class F>
+        inline void for_each_successor(const state_type& s, F&& f) const{
+            int dirs[4];
+            int n = moves(s, dirs);
+            for (int i=0;i<n;++i){
+                state_type child(s);
+                apply(child, dirs[i]);
+                f(child, dirs[i], 1.0);
+            }
+        }
+        bool from_state(const State* s, state_type& out) const{
+            const state_type* fs = dynamic_cast<const state_type*>(s);
+            if (fs) out = *fs;
+            return fs != nullptr;
+        }
+        std::shared_ptr<Action> to_action(const move_type& m) const{
+            return actions[m];
+        }
+
+        ////////////////////
+        // Game interface //
+        ////////////////////
+        virtual std::shared_ptr<State> get_state() override{
+            return std::make_shared<state_type>(*static_cast<state_type*>(this->_state));
+        }
+        virtual std::shared_ptr<State> get_goal_state() override{
+            return std::make_shared<state_type>(_goal_state);
+        }
+        virtual bool is_goal_state(const State* s) override{
+            const state_type* fs = dynamic_cast<const state_type*>(s);
+            return fs && is_goal(*fs);
+        }
+        virtual int get_successors(const State* s, std::vector<std::pair<std::shared_ptr<State>,std::shared_ptr<Action>>> &v) override{
+            const state_type* fs = dynamic_cast<const state_type*>(s);
+            if (!fs) return NPuzzle::ERR_CODE::STATE_TYPE_ERROR;
+            int dirs[4];
+            int n = moves(*fs, dirs);
+            for (int i=0;i<n;++i){
+                std::shared_ptr<state_type> new_state = std::make_shared<state_type>(*fs);
+                apply(*new_state, dirs[i]);
+                v.push_back(std::make_pair(std::static_pointer_cast<State>(new_state), actions[dirs[i]]));
+            }
+            return NPuzzle::ERR_CODE::SUCCESS;
+        }
+        virtual int get_actions(const State* s, std::vector<std::shared_ptr<Action>> &v) override{
+            const state_type* fs = dynamic_cast<const state_type*>(s);
+            if (!fs) return NPuzzle::ERR_CODE::STATE_TYPE_ERROR;
+            int dirs[4];
+            int n = moves(*fs, dirs);
+            for (int i=0;i<n;++i) v.push_back(actions[dirs[i]]);
+            return NPuzzle::ERR_CODE::SUCCESS;
+        }
+        virtual void display(std::ostream& os) override{
+            os << this->_state << std::endl;
+        }
+        virtual int play(Action* a) override{
+            if (play_action(this->_state, a)) return NPuzzle::ERR_CODE::SUCCESS;
+            return NPuzzle::ERR_CODE::PLAY_FAILED;
+        }
+        virtual bool play_action(State* s, Action* a) override{
+            state_type* fs = dynamic_cast<state_type*>(s);
+            if (!fs || a->_specifier < 0 || a->_specifier > 3) return false;
+            if (tables.neighbour[fs->_blank][a->_specifier] < 0) return false;
+            apply(*fs, a->_specifier);
+            return true;
+        }
+        // Same encoding as NPuzzle, so packed states move between the two
+        virtual size_t max_packed_size() const override{
+            return NPuzzle::packed_board_size(N);
+        }
+        virtual size_t pack(const State* s, uint8_t* buf) const override{
+            const state_type* fs = dynamic_cast<const state_type*>(s);
+            if (!fs) return 0;
+            NPuzzle::pack_board(fs->_board, N, buf);
+            return max_packed_size();
+        }
+        virtual std::shared_ptr<State> unpack(const uint8_t* buf, size_t len) const override{
+            if (len != max_packed_size()) return nullptr;
+            std::shared_ptr<state_type> fs = std::make_shared<state_type>();
+            NPuzzle::unpack_board(buf, N, fs->_board);
+            if (!NPuzzle::is_solvable(std::vector<uint8_t>(fs->_board, fs->_board + N), R, C)) return nullptr;
+            for (int p=0;p<N;++p){
+                if (!fs->_board[p]) fs->_blank = p;
+            }
+            return fs;
+        }
+        // Getters (for dimensions)
+        pii get_dims() const{
+            return pii(C, R);
+        }
+};
+
+template<int R, int C>
+constexpr FixedBoardTables<R, C> FixedNPuzzle<R, C>::tables;
+
+// Common sizes are instantiated once in FixedNPuzzle.cpp
+extern template class FixedNPuzzle<3, 3>;
+extern template class FixedNPuzzle<4, 4>;
+extern template class FixedNPuzzle<5, 5>;
+
+// Runtime dispatch on (rows, cols) to a compiled instantiation
+// @return nullptr if the dimensions have no instantiation (caller owns the result)
+Game* make_fixed_npuzzle(int rows, int cols, const TileState& start);
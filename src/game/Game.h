@@ -4,6 +4,7 @@
 #include <string>
 #include <iostream>
 #include <memory>
+#include <cstdint>
 
 // Action struct for use in games
 struct Action{
@@ -27,6 +28,8 @@ class State{
         virtual bool operator==(const State &other) const = 0;
         virtual bool operator!=(const State &other) const = 0;
         virtual size_t hash() const = 0;
+        // Approximate bytes held by this state (object plus heap), used for memory limits
+        virtual size_t footprint() const{return sizeof(State);}
 };
 
 // Virtual Game Class
@@ -54,6 +57,25 @@ class Game{
         virtual int play(Action* a) = 0;
         // Play a game action on top of a given state
         virtual bool play_action(State* s, Action* a) = 0;
+        // Fixed-size byte encoding of states (disk search, checkpoints, IPC, hash-only duplicate detection)
+        // Bytes pack() writes for every state of this game instance (0 = no encoding)
+        virtual size_t max_packed_size() const{return 0;}
+        // Write s into buf, which holds at least max_packed_size() bytes
+        // @return bytes written, 0 if s cannot be packed
+        virtual size_t pack(const State* s, uint8_t* buf) const{return 0;}
+        // Rebuild a state from pack() bytes
+        // @return nullptr if the bytes do not describe a state of this game
+        virtual std::shared_ptr<State> unpack(const uint8_t* buf, size_t len) const{return nullptr;}
+        // Like pack, but equal states (State::operator==) always give equal bytes
+        // Games whose equality ignores part of the state override this
+        virtual size_t pack_key(const State* s, uint8_t* buf) const{return pack(s, buf);}
+        // Compact action codes, for pruning duplicate move sequences (MoveAutomaton)
+        // A code names what an action does independently of where it is played, so
+        // equal code sequences from different states are comparable
+        // Number of codes (0 = no codes)
+        virtual int action_codes() const{return 0;}
+        // Code of action a played in s, in [0, action_codes()), or -1
+        virtual int action_code(const State* s, const Action* a) const{return -1;}
         // Constructor | Destructors
         Game():_state(nullptr){};
         virtual ~Game(){delete _state;};
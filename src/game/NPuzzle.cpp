@@ -1,4 +1,6 @@
 #include "NPuzzle.h"
+#include <algorithm>
+#include <cstring>
 
 #define ABS(x) ((x)>0?(x):(-(x)))
 
@@ -6,7 +8,7 @@
 // pii p = pii(r,c); int y = p.first; int x = p.second;
 typedef std::pair<int, int> pii;
 
-NPuzzle::NPuzzle(int r, int c): _rows(r), _cols(c){
+NPuzzle::NPuzzle(int r, int c, unsigned int seed): _rows(r), _cols(c), _rng(seed){
     // Initialize a single Start State (holds onto all Tile pointers for us)
     // In the entire lifetime of NPuzzle, there will only be r*c Tile objects
     this->_state = new TileState(r, c);
@@ -16,7 +18,7 @@ NPuzzle::NPuzzle(int r, int c): _rows(r), _cols(c){
 }
 
 NPuzzle::NPuzzle(const NPuzzle &np):_rows(np._rows), _cols(np._cols),
-    _goal_state(np._goal_state)
+    _goal_state(np._goal_state), _rng(np._rng)
 {
     this->_state = new TileState(*dynamic_cast<TileState*>(np._state));
 }
@@ -84,8 +86,6 @@ bool NPuzzle::play_action(State* s, Action* a){
 //TODO: Finish implementing this with vector<shared_ptr<State>> stuff
 void NPuzzle::scramble(int moves){
     // Run series of random moves
-    //srand(time(NULL));
-    srand(23);
     for (int i=0;i<moves;++i){
         std::vector<std::shared_ptr<Action>> va;
         // Grab next available actions
@@ -95,7 +95,7 @@ void NPuzzle::scramble(int moves){
             return;
         }
         // Randomly pick an action to play
-        int idx = rand() % va.size();
+        int idx = std::uniform_int_distribution<int>(0, va.size()-1)(_rng);
         //std::cerr << "(NPuzzle::scramble) move: " << va[idx]->_specifier << std::endl;
         // Play this action on current state
         play_action(this->_state, va[idx].get());
@@ -107,8 +107,6 @@ void NPuzzle::scramble(int moves){
 // we can get_action and play_action directly on a state.
 TileState* NPuzzle::scramble_copy(int moves){
     // Run series of random moves
-    srand(time(NULL));
-    //srand(23);
     TileState* tmp_state = dynamic_cast<TileState*>(_state);
     if(!tmp_state){
         std::cerr << "(NPuzzle::scramble_copy) Error: _state is not a TileState*" << std::endl;
@@ -125,7 +123,7 @@ TileState* NPuzzle::scramble_copy(int moves){
             return nullptr;
         }
         // Randomly pick an action to play
-        int idx = rand() % va.size();
+        int idx = std::uniform_int_distribution<int>(0, va.size()-1)(_rng);
         // Don't undo the last action if possible
         if(last_action && ABS(va[idx]->_specifier - last_action->_specifier) == 2){
             idx = (idx + 1) % va.size();
@@ -138,6 +136,134 @@ TileState* NPuzzle::scramble_copy(int moves){
     return copy_state;
 }
 
+void NPuzzle::seed(unsigned int s){
+    _rng.seed(s);
+}
+
+bool NPuzzle::is_solvable(const std::vector<uint8_t>& board, int rows, int cols){
+    int n = rows*cols;
+    if ((int)board.size() != n) return false;
+    // Count cycles to get the permutation parity, checking it is a permutation as we go
+    std::vector<bool> seen(n, false);
+    for (int p=0;p<n;++p){
+        if (board[p] >= n || seen[board[p]]) return false;
+        seen[board[p]] = true;
+    }
+    std::fill(seen.begin(), seen.end(), false);
+    int transpositions = 0;
+    int blank = 0;
+    for (int p=0;p<n;++p){
+        if (board[p] == 0) blank = p;
+        if (seen[p]) continue;
+        int len = 0;
+        for (int q=p;!seen[q];q=board[q]){
+            seen[q] = true;
+            ++len;
+        }
+        transpositions += len - 1;
+    }
+    // Blank's home is cell 0
+    int blank_dist = blank % cols + blank / cols;
+    return (transpositions & 1) == (blank_dist & 1);
+}
+
+void NPuzzle::random_board(std::vector<uint8_t>& board){
+    int n = _rows*_cols;
+    board.resize(n);
+    for (int p=0;p<n;++p) board[p] = p;
+    // Fisher-Yates with our own engine (std::shuffle's algorithm is implementation-defined)
+    for (int p=n-1;p>0;--p){
+        int q = std::uniform_int_distribution<int>(0, p)(_rng);
+        std::swap(board[p], board[q]);
+    }
+    // Exactly half the permutations are solvable: swapping two real tiles flips
+    // the parity, pairing each unsolvable board with a unique solvable one
+    if (!is_solvable(board, _rows, _cols)){
+        int a = (board[0] == 0) ? 1 : 0;
+        int b = (board[a+1] == 0) ? a+2 : a+1;
+        std::swap(board[a], board[b]);
+    }
+}
+
+void NPuzzle::randomize(){
+    std::vector<uint8_t> board;
+    random_board(board);
+    set_board(board);
+}
+
+bool NPuzzle::set_board(const std::vector<uint8_t>& board){
+    if (!is_solvable(board, _rows, _cols)){
+        std::cerr << "(NPuzzle::set_board) Error: board is not a solvable " << _cols << "x" << _rows << " permutation" << std::endl;
+        return false;
+    }
+    fill_state(dynamic_cast<TileState*>(this->_state), board.data());
+    return true;
+}
+
+void NPuzzle::fill_state(TileState* ts, const uint8_t* board) const{
+    // Goal state holds tile t at cell t, reuse its Tile objects
+    for (int p=0;p<_rows*_cols;++p){
+        int t = board[p];
+        ts->_tiles[p % _cols][p / _cols] = _goal_state->_tiles[t % _cols][t / _cols];
+        if (t == 0) ts->_empty_space = pii(p % _cols, p / _cols);
+    }
+}
+
+size_t NPuzzle::packed_board_size(int cells){
+    return (cells <= 16) ? (cells+1)/2 : cells;
+}
+
+void NPuzzle::pack_board(const uint8_t* board, int cells, uint8_t* buf){
+    if (cells > 16){
+        memcpy(buf, board, cells);
+        return;
+    }
+    // Even cells in the low nibble, odd cells in the high nibble
+    for (int p=0;p+1<cells;p+=2) buf[p/2] = board[p] | (board[p+1] << 4);
+    if (cells & 1) buf[cells/2] = board[cells-1];
+}
+
+void NPuzzle::unpack_board(const uint8_t* buf, int cells, uint8_t* board){
+    if (cells > 16){
+        memcpy(board, buf, cells);
+        return;
+    }
+    for (int p=0;p<cells;++p) board[p] = (p & 1) ? (buf[p/2] >> 4) : (buf[p/2] & 0x0F);
+}
+
+size_t NPuzzle::max_packed_size() const{
+    return packed_board_size(_rows*_cols);
+}
+
+size_t NPuzzle::pack(const State* s, uint8_t* buf) const{
+    const TileState* ts = dynamic_cast<const TileState*>(s);
+    if (!ts || ts->_rows != _rows || ts->_cols != _cols) return 0;
+    std::vector<uint8_t> board;
+    get_board(ts, board);
+    pack_board(board.data(), board.size(), buf);
+    return max_packed_size();
+}
+
+std::shared_ptr<State> NPuzzle::unpack(const uint8_t* buf, size_t len) const{
+    if (len != max_packed_size()) return nullptr;
+    std::vector<uint8_t> board(_rows*_cols);
+    unpack_board(buf, board.size(), board.data());
+    if (!is_solvable(board, _rows, _cols)) return nullptr;
+    std::shared_ptr<TileState> ts = std::make_shared<TileState>(*_goal_state);
+    fill_state(ts.get(), board.data());
+    return ts;
+}
+
+void NPuzzle::get_board(const TileState* ts, std::vector<uint8_t>& board){
+    board.resize(ts->_rows*ts->_cols);
+    for (int y=0;y<ts->_rows;++y){
+        for (int x=0;x<ts->_cols;++x){
+            pii home = ts->get_tile_home_position(x, y);
+            board[y*ts->_cols+x] = home.second*ts->_cols + home.first;
+        }
+    }
+}
+
 int NPuzzle::get_successors(const State* s, std::vector<std::pair<std::shared_ptr<State>,std::shared_ptr<Action>>> &v){
     // Assert that we have the correct type of state
     const TileState* ts = dynamic_cast<const TileState*>(s);
@@ -338,16 +464,30 @@ bool TileState::get_tile_real(int x, int y) const{
     return this->_tiles[x][y]->_real;
 }
 
+pii TileState::get_empty_space() const{
+    return _empty_space;
+}
+
 size_t TileState::hash() const{
-    const size_t prime = 511;
-    size_t hash = 0;
+    // Home positions in board order, a byte per coordinate, mixed in every 4 cells
+    uint64_t hash = 0, word = 0;
+    int cells = 0;
     for(int i = 0; i < _tiles.size(); i++){
         for(int j = 0; j < _tiles[i].size(); j++){
             pii hp = _tiles[i][j]->_home_position;
-            hash = (hash + (i*hp.first + j*hp.second)) * prime;
+            word = (word << 16) | ((uint64_t)(uint8_t)hp.first << 8) | (uint8_t)hp.second;
+            if (++cells % 4 == 0){
+                hash = hash_combine(hash, word);
+                word = 0;
+            }
         }
     }
-    return hash;
+    return hash_combine(hash, word);
+}
+
+// Tiles themselves are shared with the goal state, we only own the pointer grid
+size_t TileState::footprint() const{
+    return sizeof(TileState) + _cols*(sizeof(std::vector<std::shared_ptr<Tile>>) + _rows*sizeof(std::shared_ptr<Tile>));
 }
 
 /////////////
@@ -364,6 +504,17 @@ std::ostream& operator<<(std::ostream& os, const TileState& s){
     return os;
 }
 
+////////////////////////
+// Move sequence codes //
+////////////////////////
+int NPuzzle::action_codes() const{
+    return 4;
+}
+
+int NPuzzle::action_code(const State* s, const Action* a) const{
+    return a->_specifier >= 0 && a->_specifier < 4 ? a->_specifier : -1;
+}
+
 std::ostream& operator<<(std::ostream& os, NPuzzle& g){
     g.display(os);
     return os;
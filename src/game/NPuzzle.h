@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Game.h"
+#include "../util/Hash.h"
 #include <ctime>
 #include <cstdlib>
+#include <cstdint>
 #include <memory>
+#include <random>
 
 // Typedef a pair<int, int> object for Co-ordinate use
 // pii p = pii(r,c); int y = p.first; int x = p.second;
@@ -64,8 +67,10 @@ class TileState: public State{
         // Getters (don't expose our Tile internals)
         pii get_tile_home_position(int x, int y) const;
         bool get_tile_real(int x, int y) const;
+        pii get_empty_space() const;
         // Hash function for set membership
         size_t hash() const override;
+        size_t footprint() const override;
         void scramble(int moves);
 };
 
@@ -74,6 +79,8 @@ class NPuzzle: public Game{
     private:
         int _rows,_cols;
 	std::shared_ptr<TileState> _goal_state;
+        // Per-puzzle random engine (scramble, scramble_copy, randomize)
+        std::mt19937 _rng;
         // Static 'Standard' actions
         std::shared_ptr<Action> actions[4] = {
             std::make_shared<Action>(legal_actions::north,1.0,"N"),
@@ -81,6 +88,8 @@ class NPuzzle: public Game{
             std::make_shared<Action>(legal_actions::south,1.0,"S"),
             std::make_shared<Action>(legal_actions::west,1.0,"W")
         };
+        // Point ts's cells at the goal Tiles named by a packed board
+        void fill_state(TileState* ts, const uint8_t* board) const;
     public:
         // Legal actions to be taken
         enum legal_actions{
@@ -99,7 +108,8 @@ class NPuzzle: public Game{
         };
 
         // Constructor specifying row and columns in N-Puzzle
-        NPuzzle(int r, int c);
+        // seed initializes this puzzle's own random engine
+        NPuzzle(int r, int c, unsigned int seed=23);
         //NPuzzle(const State &np);
         NPuzzle(const NPuzzle &np);
         // Scramble with random moves of 'fake' tile (default 1000)
@@ -110,6 +120,21 @@ class NPuzzle: public Game{
         // get_actions and play_action so that they can be called directly
         // on a state = a bit more involved than just redefining one function.
         TileState* scramble_copy(int moves);
+        // Reseed the random engine
+        void seed(unsigned int s);
+        // Replace the current state with a uniformly random solvable state
+        void randomize();
+        // Uniformly random solvable board (board[y*cols+x] = goal index of the tile, 0 = blank)
+        void random_board(std::vector<uint8_t>& board);
+        // Set the current state from a packed board
+        // @return false if board is not a permutation of the cells or is unsolvable
+        bool set_board(const std::vector<uint8_t>& board);
+        // Packed board of a state
+        static void get_board(const TileState* ts, std::vector<uint8_t>& board);
+        // Parity check: every move swaps the blank with a neighbour (one transposition)
+        // and moves the blank by one cell, so permutation parity must equal the
+        // parity of the blank's distance from its home
+        static bool is_solvable(const std::vector<uint8_t>& board, int rows, int cols);
         // Grab the current state
         virtual std::shared_ptr<State> get_state() override;
         // Grab the goal state
@@ -137,6 +162,26 @@ class NPuzzle: public Game{
         // Play an action on a single state by MUTATING passed state
         //@return true or false depending on whether action is valid for this state
         virtual bool play_action(State* s, Action* a) override;
+
+        ///////////////////
+        // Packed states //
+        ///////////////////
+        // Packed board, two cells per byte up to 16 cells (4x4) and one byte per cell above
+        virtual size_t max_packed_size() const override;
+        virtual size_t pack(const State* s, uint8_t* buf) const override;
+        // Rejects boards that are not solvable permutations
+        virtual std::shared_ptr<State> unpack(const uint8_t* buf, size_t len) const override;
+        // The encoding itself, shared with FixedNPuzzle and NPuzzleCorpus
+        static size_t packed_board_size(int cells);
+        static void pack_board(const uint8_t* board, int cells, uint8_t* buf);
+        static void unpack_board(const uint8_t* buf, int cells, uint8_t* board);
+
+        ////////////////////////
+        // Move sequence codes //
+        ////////////////////////
+        // The blank's direction (legal_actions)
+        virtual int action_codes() const override;
+        virtual int action_code(const State* s, const Action* a) const override;
 };
 
 // Display functions
@@ -0,0 +1,118 @@
+#include "NPuzzleCorpus.h"
+#include <cstdio>
+#include <cstring>
+
+// On-disk header, followed by count records of record_bytes() each
+struct CorpusHeader{
+    char magic[4];
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t count;
+};
+
+static const char CORPUS_MAGIC[4] = {'N','P','C','O'};
+
+NPuzzleCorpus::NPuzzleCorpus():_rows(0),_cols(0){}
+
+size_t NPuzzleCorpus::record_bytes() const{
+    return NPuzzle::packed_board_size(_rows*_cols);
+}
+
+void NPuzzleCorpus::generate(NPuzzle* np, int count){
+    pii dims = np->get_dims();
+    _cols = dims.first;
+    _rows = dims.second;
+    _boards.clear();
+    std::vector<uint8_t> board;
+    for (int i=0;i<count;++i){
+        np->random_board(board);
+        add(board);
+    }
+}
+
+void NPuzzleCorpus::add(const std::vector<uint8_t>& board){
+    _boards.insert(_boards.end(), board.begin(), board.end());
+}
+
+int NPuzzleCorpus::save(const std::string& path) const{
+    int n = _rows*_cols;
+    if (n <= 0 || n > 255) return NPuzzleCorpus::ERR_CODE::DIMS_ERROR;
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f){
+        std::cerr << "(NPuzzleCorpus::save) Error: cannot open " << path << std::endl;
+        return NPuzzleCorpus::ERR_CODE::FILE_ERROR;
+    }
+    CorpusHeader header;
+    memcpy(header.magic, CORPUS_MAGIC, 4);
+    header.rows = _rows;
+    header.cols = _cols;
+    header.count = size();
+    size_t rb = record_bytes();
+    std::vector<uint8_t> buf(sizeof(header) + rb*size(), 0);
+    memcpy(buf.data(), &header, sizeof(header));
+    uint8_t* out = buf.data() + sizeof(header);
+    for (size_t i=0;i<size();++i){
+        NPuzzle::pack_board(_boards.data() + i*n, n, out + i*rb);
+    }
+    bool ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    fclose(f);
+    if (!ok){
+        std::cerr << "(NPuzzleCorpus::save) Error: short write to " << path << std::endl;
+        return NPuzzleCorpus::ERR_CODE::FILE_ERROR;
+    }
+    return NPuzzleCorpus::ERR_CODE::SUCCESS;
+}
+
+int NPuzzleCorpus::load(const std::string& path){
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f){
+        std::cerr << "(NPuzzleCorpus::load) Error: cannot open " << path << std::endl;
+        return NPuzzleCorpus::ERR_CODE::FILE_ERROR;
+    }
+    // Slurp the whole file in one read
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    std::vector<uint8_t> buf(len > 0 ? len : 0);
+    bool ok = len > 0 && fread(buf.data(), 1, buf.size(), f) == buf.size();
+    fclose(f);
+    CorpusHeader header;
+    if (!ok || buf.size() < sizeof(header)){
+        std::cerr << "(NPuzzleCorpus::load) Error: cannot read " << path << std::endl;
+        return NPuzzleCorpus::ERR_CODE::FILE_ERROR;
+    }
+    memcpy(&header, buf.data(), sizeof(header));
+    if (memcmp(header.magic, CORPUS_MAGIC, 4)){
+        std::cerr << "(NPuzzleCorpus::load) Error: " << path << " is not a corpus file" << std::endl;
+        return NPuzzleCorpus::ERR_CODE::FORMAT_ERROR;
+    }
+    _rows = header.rows;
+    _cols = header.cols;
+    int n = _rows*_cols;
+    if (n <= 0 || n > 255) return NPuzzleCorpus::ERR_CODE::DIMS_ERROR;
+    size_t rb = record_bytes();
+    if (buf.size() != sizeof(header) + rb*header.count){
+        std::cerr << "(NPuzzleCorpus::load) Error: " << path << " has the wrong size for " << header.count << " boards" << std::endl;
+        return NPuzzleCorpus::ERR_CODE::FORMAT_ERROR;
+    }
+    _boards.resize((size_t)header.count*n);
+    const uint8_t* in = buf.data() + sizeof(header);
+    for (size_t i=0;i<header.count;++i){
+        NPuzzle::unpack_board(in + i*rb, n, _boards.data() + i*n);
+    }
+    return NPuzzleCorpus::ERR_CODE::SUCCESS;
+}
+
+pii NPuzzleCorpus::get_dims() const{
+    return pii(_cols, _rows);
+}
+
+size_t NPuzzleCorpus::size() const{
+    int n = _rows*_cols;
+    return n ? _boards.size()/n : 0;
+}
+
+std::vector<uint8_t> NPuzzleCorpus::get(size_t i) const{
+    int n = _rows*_cols;
+    return std::vector<uint8_t>(_boards.begin() + i*n, _boards.begin() + (i+1)*n);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "NPuzzle.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Fixed set of NPuzzle start boards for benchmarking
+// Boards are stored packed (board[y*cols+x] = goal index of the tile, 0 = blank),
+// two cells per byte for boards of up to 16 cells and one per byte otherwise,
+// behind a 16-byte header. load() reads the file with a single read and decodes
+// every board into one flat array.
+class NPuzzleCorpus{
+    public:
+        enum ERR_CODE{
+            SUCCESS         = 0x0,
+            DIMS_ERROR      = 0x1,
+            FORMAT_ERROR    = 0x2,
+            FILE_ERROR      = 0x4
+        };
+        NPuzzleCorpus();
+        // count uniformly random solvable boards drawn from np's random engine
+        void generate(NPuzzle* np, int count);
+        // @return ERR_CODE
+        int load(const std::string& path);
+        int save(const std::string& path) const;
+        // Add a board (must be rows*cols cells)
+        void add(const std::vector<uint8_t>& board);
+        // Getters
+        // return (x,y) to match NPuzzle::get_dims()
+        pii get_dims() const;
+        size_t size() const;
+        std::vector<uint8_t> get(size_t i) const;
+    private:
+        int _rows, _cols;
+        // size() * rows * cols cells
+        std::vector<uint8_t> _boards;
+        size_t record_bytes() const;
+};
@@ -0,0 +1,264 @@
+#include "NPuzzleTable.h"
+#include "../util/Trace.h"
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// On-disk header, followed by ceil(size/2) bytes of nibbles
+struct TableHeader{
+    char magic[4];
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t reserved;
+    uint64_t size;
+};
+
+static const char TABLE_MAGIC[4] = {'N','P','T','B'};
+
+static uint64_t factorial(int n){
+    uint64_t f = 1;
+    for (int i=2;i<=n;++i) f *= i;
+    return f;
+}
+
+NPuzzleTable::NPuzzleTable():_rows(0),_cols(0),_size(0),_map(nullptr),_map_len(0),_nibbles(nullptr){}
+
+NPuzzleTable::~NPuzzleTable(){
+    close();
+}
+
+// Lehmer code rank of a permutation of 0..n-1
+uint64_t NPuzzleTable::rank(const uint8_t* perm, int n){
+    uint64_t r = 0;
+    for (int i=0;i<n;++i){
+        int smaller = 0;
+        for (int j=i+1;j<n;++j){
+            if (perm[j] < perm[i]) ++smaller;
+        }
+        r = r*(n-i) + smaller;
+    }
+    return r;
+}
+
+void NPuzzleTable::unrank(uint64_t r, uint8_t* perm, int n){
+    // Decode factorial-base digits (last digit first)
+    uint8_t digits[MAX_CELLS];
+    for (int i=n-1;i>=0;--i){
+        digits[i] = r % (n-i);
+        r /= (n-i);
+    }
+    // Pick the digit-th smallest unused value
+    bool used[MAX_CELLS] = {false};
+    for (int i=0;i<n;++i){
+        int k = digits[i];
+        for (int v=0;v<n;++v){
+            if (used[v]) continue;
+            if (k-- == 0){
+                perm[i] = v;
+                used[v] = true;
+                break;
+            }
+        }
+    }
+}
+
+uint64_t NPuzzleTable::rank(const TileState* ts) const{
+    uint8_t perm[MAX_CELLS];
+    for (int y=0;y<_rows;++y){
+        for (int x=0;x<_cols;++x){
+            pii home = ts->get_tile_home_position(x, y);
+            perm[y*_cols+x] = home.second*_cols + home.first;
+        }
+    }
+    return rank(perm, _rows*_cols);
+}
+
+uint8_t NPuzzleTable::get(uint64_t r) const{
+    if (r >= _size) return UNREACHED;
+    uint8_t b = _nibbles[r >> 1];
+    return (r & 1) ? (b >> 4) : (b & 0xF);
+}
+
+uint8_t NPuzzleTable::get(const TileState* ts) const{
+    return get(rank(ts));
+}
+
+pii NPuzzleTable::get_dims() const{
+    return pii(_cols, _rows);
+}
+
+uint64_t NPuzzleTable::size() const{
+    return _size;
+}
+
+bool NPuzzleTable::is_open() const{
+    return _nibbles != nullptr;
+}
+
+bool NPuzzleTable::open(const std::string& path){
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        std::cerr << "(NPuzzleTable::open) Error: cannot open <" << path << ">" << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(TableHeader)){
+        std::cerr << "(NPuzzleTable::open) Error: <" << path << "> is too short" << std::endl;
+        ::close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED){
+        std::cerr << "(NPuzzleTable::open) Error: mmap failed" << std::endl;
+        return false;
+    }
+    const TableHeader* hdr = static_cast<const TableHeader*>(map);
+    if (memcmp(hdr->magic, TABLE_MAGIC, 4) || hdr->rows*hdr->cols > (uint32_t)MAX_CELLS ||
+        hdr->size != factorial(hdr->rows*hdr->cols) ||
+        (size_t)st.st_size < sizeof(TableHeader) + (hdr->size+1)/2){
+        std::cerr << "(NPuzzleTable::open) Error: <" << path << "> is not a valid table" << std::endl;
+        munmap(map, st.st_size);
+        return false;
+    }
+    _rows = hdr->rows;
+    _cols = hdr->cols;
+    _size = hdr->size;
+    _map = map;
+    _map_len = st.st_size;
+    _nibbles = static_cast<const uint8_t*>(map) + sizeof(TableHeader);
+    return true;
+}
+
+void NPuzzleTable::close(){
+    if (_map) munmap(_map, _map_len);
+    _map = nullptr;
+    _map_len = 0;
+    _nibbles = nullptr;
+    _size = 0;
+}
+
+// Expand one slice of the frontier, claiming unseen children in the shared bitmap
+static void expand_slice(const std::vector<uint64_t>& frontier, size_t begin, size_t end,
+                         int rows, int cols, std::atomic<uint64_t>* seen, std::vector<uint64_t>& next){
+    // Same NESW offsets as Game::ADJ
+    const int ADJ[4][2] = {{0,-1},{1,0},{0,1},{-1,0}};
+    int n = rows*cols;
+    uint8_t perm[NPuzzleTable::MAX_CELLS];
+    for (size_t i=begin;i<end;++i){
+        NPuzzleTable::unrank(frontier[i], perm, n);
+        int blank = 0;
+        while (perm[blank] != 0) ++blank;
+        int x = blank % cols;
+        int y = blank / cols;
+        for (int d=0;d<4;++d){
+            int nx = x + ADJ[d][0];
+            int ny = y + ADJ[d][1];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+            int nb = ny*cols + nx;
+            std::swap(perm[blank], perm[nb]);
+            uint64_t r = NPuzzleTable::rank(perm, n);
+            std::swap(perm[blank], perm[nb]);
+            uint64_t bit = 1ULL << (r & 63);
+            if (!(seen[r >> 6].fetch_or(bit, std::memory_order_relaxed) & bit)){
+                next.push_back(r);
+            }
+        }
+    }
+}
+
+int NPuzzleTable::generate(NPuzzle* np, const std::string& path, int num_threads, std::vector<uint64_t>& histogram){
+    pii dims = np->get_dims();
+    int cols = dims.first;
+    int rows = dims.second;
+    int n = rows*cols;
+    if (n < 2 || n > MAX_CELLS){
+        std::cerr << "(NPuzzleTable::generate) Error: " << cols << "x" << rows << " board is too large to enumerate" << std::endl;
+        return ERR_CODE::DIMS_ERROR;
+    }
+    if (num_threads < 1) num_threads = 1;
+    uint64_t size = factorial(n);
+    Trace::Scope trace("npuzzle_table", "heuristic", std::to_string(cols) + "x" + std::to_string(rows));
+
+    // Nibble table (all UNREACHED) and visited bitmap
+    std::vector<uint8_t> nibbles((size+1)/2, 0xFF);
+    std::atomic<uint64_t>* seen = new (std::nothrow) std::atomic<uint64_t>[(size+63)/64];
+    if (!seen) return ERR_CODE::ALLOC_ERROR;
+    for (uint64_t i=0;i<(size+63)/64;++i) seen[i].store(0, std::memory_order_relaxed);
+
+    // Seed BFS with the goal state
+    std::shared_ptr<State> goal = np->get_goal_state();
+    uint8_t perm[MAX_CELLS];
+    const TileState* ts = dynamic_cast<const TileState*>(goal.get());
+    if (!ts){
+        delete[] seen;
+        return ERR_CODE::DIMS_ERROR;
+    }
+    for (int y=0;y<rows;++y){
+        for (int x=0;x<cols;++x){
+            pii home = ts->get_tile_home_position(x, y);
+            perm[y*cols+x] = home.second*cols + home.first;
+        }
+    }
+    uint64_t root = rank(perm, n);
+    seen[root >> 6].store(1ULL << (root & 63));
+    std::vector<uint64_t> frontier(1, root);
+
+    histogram.clear();
+    int depth = 0;
+    while (!frontier.empty()){
+        Trace::Scope layer("bfs_layer", "heuristic", depth);
+        // Record current layer
+        histogram.push_back(frontier.size());
+        uint8_t val = depth % DEPTH_MOD;
+        for (uint64_t r: frontier){
+            uint8_t& b = nibbles[r >> 1];
+            b = (r & 1) ? ((b & 0x0F) | (val << 4)) : ((b & 0xF0) | val);
+        }
+        // Expand in parallel, each thread owns a contiguous slice of the frontier
+        std::vector<std::vector<uint64_t>> nexts(num_threads);
+        std::vector<std::thread> workers;
+        size_t chunk = (frontier.size() + num_threads - 1)/num_threads;
+        for (int t=1;t<num_threads;++t){
+            size_t b = std::min(frontier.size(), t*chunk);
+            size_t e = std::min(frontier.size(), b + chunk);
+            workers.push_back(std::thread(expand_slice, std::cref(frontier), b, e, rows, cols, seen, std::ref(nexts[t])));
+        }
+        expand_slice(frontier, 0, std::min(frontier.size(), chunk), rows, cols, seen, nexts[0]);
+        for (std::thread& w: workers) w.join();
+        // Gather next layer
+        frontier.clear();
+        for (std::vector<uint64_t>& v: nexts){
+            frontier.insert(frontier.end(), v.begin(), v.end());
+        }
+        ++depth;
+    }
+    delete[] seen;
+
+    // Write table
+    FILE* fout = fopen(path.c_str(), "wb");
+    if (!fout){
+        std::cerr << "(NPuzzleTable::generate) Error: cannot write <" << path << ">" << std::endl;
+        return ERR_CODE::FILE_ERROR;
+    }
+    TableHeader hdr;
+    memcpy(hdr.magic, TABLE_MAGIC, 4);
+    hdr.rows = rows;
+    hdr.cols = cols;
+    hdr.reserved = 0;
+    hdr.size = size;
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, fout) == 1 &&
+              fwrite(nibbles.data(), 1, nibbles.size(), fout) == nibbles.size();
+    ok = (fclose(fout) == 0) && ok;
+    if (!ok){
+        std::cerr << "(NPuzzleTable::generate) Error: short write to <" << path << ">" << std::endl;
+        return ERR_CODE::FILE_ERROR;
+    }
+    return ERR_CODE::SUCCESS;
+}
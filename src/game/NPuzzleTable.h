@@ -0,0 +1,59 @@
+#pragma once
+
+#include "NPuzzle.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Complete distance-to-goal table for small NPuzzle boards
+// Every permutation of the r*c cells is ranked (Lehmer code) and we store
+// its BFS depth from the goal modulo DEPTH_MOD in a single nibble.
+// Neighbouring states always differ in depth by exactly 1 so depth mod 15 is
+// enough to recover a shortest path by greedy descent.
+// The table is written once by generate() and memory-mapped read-only by open()
+class NPuzzleTable{
+    public:
+        // Nibble marking a permutation never reached from the goal (other parity)
+        static const uint8_t UNREACHED = 0xF;
+        static const int DEPTH_MOD = 15;
+        // Largest board we can rank into a uint64_t (12! ~ 479M states)
+        static const int MAX_CELLS = 12;
+        enum ERR_CODE{
+            SUCCESS         = 0x0,
+            DIMS_ERROR      = 0x1,
+            ALLOC_ERROR     = 0x2,
+            FILE_ERROR      = 0x4
+        };
+        NPuzzleTable();
+        ~NPuzzleTable();
+        // Enumerate every state reachable from np->get_goal_state() with a level-synchronous
+        // BFS split across num_threads, writes the nibble table to path
+        // histogram[d] holds the number of states at (exact) depth d
+        // @return ERR_CODE
+        static int generate(NPuzzle* np, const std::string& path, int num_threads, std::vector<uint64_t>& histogram);
+        // Memory-map a table previously written by generate()
+        bool open(const std::string& path);
+        void close();
+        bool is_open() const;
+        // Getters
+        // return (x,y) to match NPuzzle::get_dims()
+        pii get_dims() const;
+        uint64_t size() const;
+        // Stored depth (mod DEPTH_MOD) or UNREACHED
+        uint8_t get(uint64_t rank) const;
+        uint8_t get(const TileState* ts) const;
+        // Ranking helpers, perm[y*cols+x] holds the goal index of the tile at (x,y)
+        uint64_t rank(const TileState* ts) const;
+        static uint64_t rank(const uint8_t* perm, int n);
+        static void unrank(uint64_t r, uint8_t* perm, int n);
+    private:
+        int _rows, _cols;
+        uint64_t _size;
+        // mmap-ed file and pointer to the nibbles past the header
+        void* _map;
+        size_t _map_len;
+        const uint8_t* _nibbles;
+        // Non-copyable (owns the mapping)
+        NPuzzleTable(const NPuzzleTable&);
+        NPuzzleTable& operator=(const NPuzzleTable&);
+};
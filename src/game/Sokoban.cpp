@@ -1,4 +1,7 @@
 #include "Sokoban.h"
+#include "../util/Trace.h"
+#include <cstring>
+#include <algorithm>
 
 // (x, y) coordinate pair
 typedef std::pair<int, int> pii;
@@ -37,7 +40,8 @@ Sokoban::Sokoban(int r, int c, char** raw, bool p):Sokoban(r, c, raw){
     _prune = p;
 }
 
-Sokoban::Sokoban(const Sokoban& sok):_rows(sok._rows),_cols(sok._cols),_goal_state(nullptr),_prune(sok._prune){
+Sokoban::Sokoban(const Sokoban& sok):_rows(sok._rows),_cols(sok._cols),_goal_state(nullptr),_prune(sok._prune),
+    _floor_index(sok._floor_index),_floor_cells(sok._floor_cells){
     // Initialize our distance map
     for (loc_dist_map::const_iterator fit = sok.distance.begin();fit != sok.distance.end();++fit){
         // Copy contents of each map
@@ -127,16 +131,31 @@ bool Sokoban::load_board(int r, int c, char** raw){
     // since that is never checked for in is_goal_state
 
     // Finally, [expensive!] populate distance hashmap via BFS on every cell passable
-    for (int x=0;x<c;++x){
-        for (int y=0;y<r;++y){
-            pii cur = pii(x, y);
-            // Run bfs from this location if viable (not a wall)
-            if (!_goal_state->is_wall(cur)){
-                bfs(*_goal_state, cur, distance[cur]);
+    {
+        Trace::Scope trace("distance_table", "level", r*c);
+        for (int x=0;x<c;++x){
+            for (int y=0;y<r;++y){
+                pii cur = pii(x, y);
+                // Run bfs from this location if viable (not a wall)
+                if (!_goal_state->is_wall(cur)){
+                    bfs(*_goal_state, cur, distance[cur]);
+                }
             }
         }
     }
 
+    // Floor cells are those the player reaches ignoring boxes (boxes never leave them either)
+    const dist_map& reach = distance[new_state->_player_loc];
+    _floor_index.assign(r*c, -1);
+    _floor_cells.clear();
+    for (int y=0;y<r;++y){
+        for (int x=0;x<c;++x){
+            if (reach.find(pii(x, y)) == reach.end()) continue;
+            _floor_index[y*c+x] = _floor_cells.size();
+            _floor_cells.push_back(pii(x, y));
+        }
+    }
+
     // Test our hashmap
     // #ifdef DEBUG
     // std::cout << new_state;
@@ -216,30 +235,36 @@ int Sokoban::get_actions(const State* s, std::vector<std::shared_ptr<Action>>& v
         // Efficient moves only -> e.g. only moves that will shift a box
         // For moves which affect box locations, it sufficies to look at the
         // intersection between _traversible and _boxes sets
+        // Boxes are visited in board order so the successor order depends only on the
+        // position, not on the hash map's insertion history (copies and unpacked states differ)
+        std::vector<pii> reachable_boxes;
         for (const std::pair<pii, int>& box_pii: bs->_boxes){ // _boxes.size() < _traversible.size() (so more efficient this way)
-            pii p = box_pii.first;
-            if (bs->is_traversible(p)){
-                // Valid box to be pushed to new location
-                // Generate which direction the box can be pushed from
-                for (int i=0;i<4;++i){
-                    int ax = -ADJ[i][0];
-                    int ay = -ADJ[i][1];
-                    pii from_loc = pii(p.first + ax, p.second + ay);
-                    // Need to check in _traversible and NOT in _boxes since _boxes is subset of _traversible from bfs call
-                    if (bs->is_traversible(from_loc) && !bs->is_box(from_loc)){
-                        // Location to push box from is traversible by player
-                        // Validate end location of box
-                        pii new_box_loc = pii(p.first - ax, p.second - ay);
-                        if (!bs->is_valid(new_box_loc) || bs->is_wall(new_box_loc) || bs->is_box(new_box_loc)) continue;
-                        // Valid action of type push_move found
-                        std::ostringstream os;
-                        os << "MOVE " << p.first << " " << p.second << " PUSH " << MOVE_DIR[i];
-                        std::string name = os.str();
-                        int dist = bs->get_dist(from_loc);  // Number of steps to move into position to push box + 1 for push
-                        // We should be able to reach unless we have not set _player_loc correctly
-                        assert(dist < std::numeric_limits<int>::max());
-                        v.push_back(std::make_shared<PositionAction>(action_types::push_move, (double)(dist+1), name, p, i));
-                    }
+            if (bs->is_traversible(box_pii.first)) reachable_boxes.push_back(box_pii.first);
+        }
+        std::sort(reachable_boxes.begin(), reachable_boxes.end(), [](const pii& a, const pii& b){
+            return a.second < b.second || (a.second == b.second && a.first < b.first);
+        });
+        for (const pii& p: reachable_boxes){
+            // Valid box to be pushed to new location
+            // Generate which direction the box can be pushed from
+            for (int i=0;i<4;++i){
+                int ax = -ADJ[i][0];
+                int ay = -ADJ[i][1];
+                pii from_loc = pii(p.first + ax, p.second + ay);
+                // Need to check in _traversible and NOT in _boxes since _boxes is subset of _traversible from bfs call
+                if (bs->is_traversible(from_loc) && !bs->is_box(from_loc)){
+                    // Location to push box from is traversible by player
+                    // Validate end location of box
+                    pii new_box_loc = pii(p.first - ax, p.second - ay);
+                    if (!bs->is_valid(new_box_loc) || bs->is_wall(new_box_loc) || bs->is_box(new_box_loc)) continue;
+                    // Valid action of type push_move found
+                    std::ostringstream os;
+                    os << "MOVE " << p.first << " " << p.second << " PUSH " << MOVE_DIR[i];
+                    std::string name = os.str();
+                    int dist = bs->get_dist(from_loc);  // Number of steps to move into position to push box + 1 for push
+                    // We should be able to reach unless we have not set _player_loc correctly
+                    assert(dist < std::numeric_limits<int>::max());
+                    v.push_back(std::make_shared<PositionAction>(action_types::push_move, (double)(dist+1), name, p, i));
                 }
             }
         }
@@ -367,6 +392,24 @@ bool Sokoban::play_rev_action(BoardState* bs, PositionAction* pa){
     else return false;
 }
 
+int Sokoban::get_goal_states(std::vector<std::shared_ptr<State>>& v) const{
+    if (!_goal_state) return ERR_CODE::STATE_TYPE_ERROR;
+    std::vector<bool> covered(_floor_cells.size(), false);
+    for (size_t f=0;f<_floor_cells.size();++f){
+        if (covered[f] || _goal_state->is_box(_floor_cells[f])) continue;
+        std::shared_ptr<BoardState> bs = std::make_shared<BoardState>(*_goal_state);
+        bs->_player_loc = _floor_cells[f];
+        bs->_traversible.clear();
+        bfs(*bs, bs->_player_loc, bs->_traversible, true);
+        for (const std::pair<pii, int>& dist_map_p: bs->_traversible){
+            int g = get_floor_index(dist_map_p.first);
+            if (g >= 0 && !bs->is_box(dist_map_p.first)) covered[g] = true;
+        }
+        v.push_back(bs);
+    }
+    return ERR_CODE::SUCCESS;
+}
+
 int Sokoban::play(Action* a){
     bool play_succeeded = play_action(_state, a);
     if (play_succeeded) return ERR_CODE::SUCCESS;
@@ -455,6 +498,89 @@ bool Sokoban::play_action(State* s, Action* a){
     else return false;
 }
 
+///////////////////
+// Packed states //
+///////////////////
+size_t Sokoban::max_packed_size() const{
+    if (_floor_cells.empty()) return 0;
+    return 2 + (_floor_cells.size() + 7)/8;
+}
+
+int Sokoban::get_floor_index(const pii& loc) const{
+    if (loc.first < 0 || loc.second < 0 || loc.first >= _cols || loc.second >= _rows) return -1;
+    return _floor_index[loc.second*_cols + loc.first];
+}
+
+int Sokoban::get_num_floor() const{
+    return _floor_cells.size();
+}
+
+size_t Sokoban::pack(const State* s, uint8_t* buf) const{
+    const BoardState* bs = dynamic_cast<const BoardState*>(s);
+    size_t n = max_packed_size();
+    if (!bs || !n) return 0;
+    int player = get_floor_index(bs->_player_loc);
+    if (player < 0) return 0;
+    memset(buf, 0, n);
+    buf[0] = player & 0xFF;
+    buf[1] = player >> 8;
+    for (const std::pair<pii, int>& box_pii: bs->_boxes){
+        int f = get_floor_index(box_pii.first);
+        if (f < 0) return 0;
+        buf[2 + f/8] |= 1 << (f & 7);
+    }
+    return n;
+}
+
+size_t Sokoban::pack_key(const State* s, uint8_t* buf) const{
+    size_t n = pack(s, buf);
+    if (!n) return 0;
+    const BoardState* bs = static_cast<const BoardState*>(s);
+    int player = get_floor_index(bs->_player_loc);
+    // Boxes on the region's border are in _traversible too but name no region
+    for (const std::pair<pii, int>& dist_map_p: bs->_traversible){
+        if (bs->is_box(dist_map_p.first)) continue;
+        int f = get_floor_index(dist_map_p.first);
+        if (f >= 0 && f < player) player = f;
+    }
+    buf[0] = player & 0xFF;
+    buf[1] = player >> 8;
+    return n;
+}
+
+std::shared_ptr<State> Sokoban::unpack(const uint8_t* buf, size_t len) const{
+    if (!len || len != max_packed_size()) return nullptr;
+    size_t player = buf[0] | (buf[1] << 8);
+    if (player >= _floor_cells.size()) return nullptr;
+    // Walls and goals come from the level, boxes and player from the bytes
+    std::shared_ptr<BoardState> bs = std::make_shared<BoardState>(*_goal_state);
+    bs->_boxes.clear();
+    bs->_player_loc = _floor_cells[player];
+    int id = 0;
+    for (size_t f=0;f<_floor_cells.size();++f){
+        if (buf[2 + f/8] & (1 << (f & 7))) bs->_boxes[_floor_cells[f]] = id++;
+    }
+    if (bs->_boxes.size() != _goal_state->_boxes.size() || bs->is_box(bs->_player_loc)) return nullptr;
+    bfs(*bs, bs->_player_loc, bs->_traversible, true);
+    return bs;
+}
+
+////////////////////////
+// Move sequence codes //
+////////////////////////
+int Sokoban::action_codes() const{
+    return _prune && _goal_state ? 4*_goal_state->_boxes.size() : 0;
+}
+
+int Sokoban::action_code(const State* s, const Action* a) const{
+    const PositionAction* pa = dynamic_cast<const PositionAction*>(a);
+    const BoardState* bs = dynamic_cast<const BoardState*>(s);
+    if (!_prune || !pa || !bs || pa->_specifier != action_types::push_move || pa->_dir < 0 || pa->_dir >= 4) return -1;
+    dist_map::const_iterator it = bs->_boxes.find(pa->_move_loc);
+    if (it == bs->_boxes.end()) return -1;
+    return it->second*4 + pa->_dir;
+}
+
 ////////////////
 // BoardState //
 ////////////////
@@ -630,23 +756,26 @@ pii BoardState::get_box(int id) const{
 }
 
 size_t BoardState::hash() const{
-    const size_t prime = 511;
-    size_t _hash = 0;
-    // get a pairhash hasher
-    PairHash hasher;
-    for (const pii& p: _walls) _hash += hasher(p);
-    _hash *= prime;
-    for (const std::pair<pii, int> box_pii: _boxes) _hash += hasher(box_pii.first);
-    _hash *= prime;
-    for (const pii& p: _goals) _hash += hasher(p);
-    _hash *= prime;
+    // Boxes are unordered, so their mixed cells are summed (order-independent but,
+    // unlike a sum of raw cells, not fooled by boxes trading coordinates)
+    uint64_t boxes = 0;
+    for (const std::pair<pii, int>& box_pii: _boxes) boxes += hash_cell(box_pii.first.first, box_pii.first.second);
+    // Once again, we do not need to hash _player_loc since unless _traversible changes
+    // player has effectively not moved at all: the smallest reachable cell names the region
+    // (boxes on its border are in _traversible too and are skipped).
+    // Walls and goals are the same in every state of a level and are left out
+    pii region(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
     for (const std::pair<pii, int>& dist_map_p: _traversible){
-        _hash += hasher(dist_map_p.first);
+        if (!is_box(dist_map_p.first)) region = std::min(region, dist_map_p.first);
     }
-    _hash *= prime;
-    // Once again, we do not need to hash _player_loc since unless _traversible changes
-    // player has effectively not moved at all
-    return _hash;
+    return hash_combine(mix64(boxes), hash_cell(region.first, region.second));
+}
+
+// Every state carries its own copy of walls and goals, each hash node costs
+// roughly one allocation plus a bucket pointer
+size_t BoardState::footprint() const{
+    const size_t node = 32 + sizeof(void*);
+    return sizeof(BoardState) + (_walls.size() + _goals.size() + _boxes.size() + _traversible.size())*node;
 }
 
 /////////
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Game.h"
+#include "../util/Hash.h"
 #include <string>
 #include <vector>
 #include <unordered_set>
@@ -11,16 +12,6 @@
 #include <sstream>
 #include <limits>
 
-// We appear to need a hash for pair (stl doesn't have one o.O)
-struct PairHash
-{
-    template <class T1, class T2>
-    std::size_t operator() (const std::pair<T1, T2> &pair) const
-    {
-        return std::hash<T1>()(pair.first) ^ std::hash<T2>()(pair.second);
-    }
-};
-
 // Used to store board coordinates
 typedef std::pair<int, int> pii;
 // Used to store set of object locations
@@ -107,6 +98,7 @@ class BoardState: public State{
         pii get_box(int id) const;  // O(b), expensive?
         // Hash function for set membership
         size_t hash() const override;
+        size_t footprint() const override;
 };
 
 class Sokoban: public Game{
@@ -123,6 +115,9 @@ class Sokoban: public Game{
         // technically, we are in the same effective state but makes easier for human player to follow
         bool _prune;    // Whether or not to prune should not be changed past the constructor
                         // thus, we have no getter/setter for this
+        // Cells the player or a box can ever occupy, numbered row-major (for packed states)
+        std::vector<int> _floor_index;  // y*cols+x -> floor index or -1
+        std::vector<pii> _floor_cells;  // floor index -> (x, y)
     public:
         // Legal actions to be taken
         enum action_types{
@@ -187,6 +182,10 @@ class Sokoban: public Game{
         int get_rev_actions(const BoardState* bs, std::vector<std::shared_ptr<PositionAction>>& v);
         // Play a forwards action in reverse
         bool play_rev_action(BoardState* bs, PositionAction* pa);
+        // Goal configurations for backward search, one per region of floor cells the
+        // packed boxes leave (player at the region's first cell, _traversible computed)
+        // @return ERR_CODE
+        int get_goal_states(std::vector<std::shared_ptr<State>>& v) const;
 
         ////////////////////////////////
         // Makes the Game interactive //
@@ -197,6 +196,28 @@ class Sokoban: public Game{
         // Play an action on a single state by MUTATING passed state
         //@return true or false depending on whether action is valid for this state
         virtual bool play_action(State* s, Action* a) override;
+
+        ///////////////////
+        // Packed states //
+        ///////////////////
+        // 16-bit player floor index followed by a bitmap of the floor cells holding boxes
+        // (walls and goals belong to the level and are restored from _goal_state)
+        virtual size_t max_packed_size() const override;
+        virtual size_t pack(const State* s, uint8_t* buf) const override;
+        // Box ids are renumbered in floor order, _traversible is recomputed
+        virtual std::shared_ptr<State> unpack(const uint8_t* buf, size_t len) const override;
+        // Player replaced by the lowest floor index it can reach, as equality only sees the region
+        virtual size_t pack_key(const State* s, uint8_t* buf) const override;
+        // Floor cell index of loc (-1 for walls and cells the player can never reach)
+        int get_floor_index(const pii& loc) const;
+        int get_num_floor() const;
+
+        ////////////////////////
+        // Move sequence codes //
+        ////////////////////////
+        // Pushes only: box id * 4 + direction (ids follow boxes from the start state, see unpack)
+        virtual int action_codes() const override;
+        virtual int action_code(const State* s, const Action* a) const override;
 };
 
 // BFS function | Given BoardState, pii location, unordered_set<pii> visited
@@ -0,0 +1,254 @@
+#pragma once
+
+#include "Sokoban.h"
+#include "../util/Hash.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+// Push-level Sokoban on plain value states, for AStar<SokobanKernel<W>, ...>
+// A state is a bitmap of the boxes over the level's floor cells (W 64-bit words,
+// so levels up to 64*W floor cells), the player's cell and the smallest non-box
+// cell of the player's region. Keys compare boxes and region only, as
+// BoardState::operator== does. Successors are the pushes Sokoban::get_actions
+// generates in prune mode, in the same order and with the same costs (walk + 1).
+// Player reach is a BFS over flat arrays, so the kernel keeps scratch buffers:
+// one kernel must not expand states on two threads at once.
+template<int W>
+class SokobanKernel{
+    public:
+        struct state_type{
+            uint64_t _boxes[W];
+            uint16_t _player;   // Grid cell y*cols+x
+            uint16_t _region;   // Smallest non-box cell the player can reach
+        };
+        struct move_type{
+            uint16_t _box;      // Grid cell of the pushed box
+            uint8_t _dir;       // NESW
+            uint16_t _cost;     // Steps to reach the box plus the push
+        };
+    private:
+        // Same NESW offsets as Game::ADJ
+        const int ADJ[4][2] = {{0,-1},{1,0},{0,1},{-1,0}};
+        const char MOVE_DIR[5] = "NESW";
+        int _rows, _cols;
+        std::vector<uint8_t> _wall, _goal;  // Per grid cell
+        std::vector<int> _neighbour;        // _neighbour[cell*4+d], -1 off the board
+        std::vector<int> _floor_index;      // Grid cell -> bit, -1 off the floor
+        std::vector<int> _floor_cells;      // Bit -> grid cell
+        std::vector<double> _box_goal_dist; // Pushes from a cell to the nearest goal (boxes ignored)
+        state_type _goal_state;
+        // BFS scratch (stamped, so nothing is cleared between searches)
+        mutable std::vector<uint32_t> _mark;
+        mutable std::vector<int> _dist, _queue;
+        mutable uint32_t _stamp;
+        struct Push{
+            int box, dir, from_dist, to;
+        };
+        mutable std::vector<Push> _pushes;
+
+        inline bool open_cell(int c) const{
+            return c >= 0 && !_wall[c];
+        }
+        // Player BFS from cell from, stopping at boxes (as bfs(..., stop_box=true))
+        // Reached cells get the current stamp and their distance in _dist
+        void reach(const state_type& s, int from) const{
+            if (++_stamp == 0){
+                std::fill(_mark.begin(), _mark.end(), 0);
+                _stamp = 1;
+            }
+            size_t head = 0;
+            _queue.clear();
+            _queue.push_back(from);
+            _mark[from] = _stamp;
+            _dist[from] = 0;
+            while (head < _queue.size()){
+                int cur = _queue[head++];
+                if (has_box(s, cur)) continue;
+                for (int d=0;d<4;++d){
+                    int n = _neighbour[cur*4+d];
+                    if (!open_cell(n) || _mark[n] == _stamp) continue;
+                    _mark[n] = _stamp;
+                    _dist[n] = _dist[cur] + 1;
+                    _queue.push_back(n);
+                }
+            }
+        }
+        // Smallest reached non-box cell after reach(s, ...)
+        int region_after_reach(const state_type& s) const{
+            int best = std::numeric_limits<int>::max();
+            for (int c: _queue){
+                if (c < best && !has_box(s, c)) best = c;
+            }
+            return best;
+        }
+        inline void set_box(state_type& s, int c, bool on) const{
+            int f = _floor_index[c];
+            if (on) s._boxes[f >> 6] |= 1ULL << (f & 63);
+            else s._boxes[f >> 6] &= ~(1ULL << (f & 63));
+        }
+    public:
+        // Level taken from the game's walls, goals and floor numbering
+        explicit SokobanKernel(Sokoban& sok):_stamp(0){
+            pii dims = sok.get_dims();
+            _cols = dims.first;
+            _rows = dims.second;
+            int cells = _rows*_cols;
+            std::shared_ptr<State> st = sok.get_goal_state();
+            const BoardState* goal = static_cast<const BoardState*>(st.get());
+            _wall.assign(cells, 0);
+            _goal.assign(cells, 0);
+            _neighbour.assign(cells*4, -1);
+            _floor_index.assign(cells, -1);
+            memset(&_goal_state, 0, sizeof(_goal_state));
+            for (int y=0;y<_rows;++y){
+                for (int x=0;x<_cols;++x){
+                    int c = y*_cols + x;
+                    _wall[c] = goal->is_wall(x, y);
+                    _goal[c] = goal->is_goal(x, y);
+                    int f = sok.get_floor_index(pii(x, y));
+                    if (f >= 0 && f < 64*W){
+                        _floor_index[c] = f;
+                        if ((int)_floor_cells.size() <= f) _floor_cells.resize(f + 1, -1);
+                        _floor_cells[f] = c;
+                    }
+                    for (int d=0;d<4;++d){
+                        int nx = x + ADJ[d][0];
+                        int ny = y + ADJ[d][1];
+                        if (nx >= 0 && ny >= 0 && nx < _cols && ny < _rows) _neighbour[c*4+d] = ny*_cols + nx;
+                    }
+                }
+            }
+            for (int c=0;c<cells;++c){
+                if (_goal[c] && _floor_index[c] >= 0) set_box(_goal_state, c, true);
+            }
+            _mark.assign(cells, 0);
+            _dist.assign(cells, 0);
+            // Push distances as SokobanHeuristic::bfs_to_goal: the box moves to an open
+            // cell with an open cell behind it, other boxes are ignored
+            _box_goal_dist.assign(cells, std::numeric_limits<double>::infinity());
+            std::vector<int> dist(cells), queue;
+            for (int s=0;s<cells;++s){
+                if (_wall[s]) continue;
+                std::fill(dist.begin(), dist.end(), -1);
+                queue.assign(1, s);
+                dist[s] = 0;
+                for (size_t head=0;head<queue.size();++head){
+                    int cur = queue[head];
+                    if (_goal[cur]){
+                        _box_goal_dist[s] = dist[cur];
+                        break;
+                    }
+                    for (int d=0;d<4;++d){
+                        int n = _neighbour[cur*4+d];
+                        int from = _neighbour[cur*4+(d+2)%4];
+                        if (!open_cell(n) || !open_cell(from) || dist[n] >= 0) continue;
+                        dist[n] = dist[cur] + 1;
+                        queue.push_back(n);
+                    }
+                }
+            }
+        }
+        // Floor cells a state can hold (levels with more need a larger W)
+        static int capacity(){
+            return 64*W;
+        }
+
+        ////////////////////////////////
+        // AStar interface (AStar.h)  //
+        ////////////////////////////////
+        inline bool has_box(const state_type& s, int c) const{
+            int f = _floor_index[c];
+            return f >= 0 && ((s._boxes[f >> 6] >> (f & 63)) & 1);
+        }
+        inline bool is_goal(const state_type& s) const{
+            return memcmp(s._boxes, _goal_state._boxes, sizeof(s._boxes)) == 0;
+        }
+        inline uint64_t key_hash(const state_type& s) const{
+            return hash_combine(hash_bytes(reinterpret_cast<const uint8_t*>(s._boxes), sizeof(s._boxes)), s._region);
+        }
+        inline bool key_equal(const state_type& a, const state_type& b) const{
+            return a._region == b._region && memcmp(a._boxes, b._boxes, sizeof(a._boxes)) == 0;
+        }
+        // Pushes in Sokoban::get_actions order: reachable boxes row by row, then NESW
+        template<class F>
+        void for_each_successor(const state_type& s, F&& f) const{
+            reach(s, s._player);
+            // Collected first, the child's region BFS reuses the scratch buffers
+            _pushes.clear();
+            for_each_box(s, [this, &s](int c){
+                if (_mark[c] != _stamp) return;
+                for (int d=0;d<4;++d){
+                    int from = _neighbour[c*4+(d+2)%4];
+                    int to = _neighbour[c*4+d];
+                    if (from < 0 || _mark[from] != _stamp || has_box(s, from)) continue;
+                    if (!open_cell(to) || has_box(s, to) || _floor_index[to] < 0) continue;
+                    _pushes.push_back(Push{c, d, _dist[from], to});
+                }
+            });
+            for (size_t i=0;i<_pushes.size();++i){
+                Push p = _pushes[i];
+                state_type child = s;
+                set_box(child, p.box, false);
+                set_box(child, p.to, true);
+                child._player = p.box;
+                reach(child, p.box);
+                child._region = region_after_reach(child);
+                f(child, move_type{(uint16_t)p.box, (uint8_t)p.dir, (uint16_t)(p.from_dist + 1)}, (double)(p.from_dist + 1));
+            }
+        }
+
+        //////////////////////////
+        // Heuristic support    //
+        //////////////////////////
+        // Calls f(cell) for every box in grid order (floor bits are numbered row-major)
+        template<class F>
+        inline void for_each_box(const state_type& s, F&& f) const{
+            for (int w=0;w<W;++w){
+                for (uint64_t bits = s._boxes[w];bits;bits &= bits - 1) f(_floor_cells[w*64 + __builtin_ctzll(bits)]);
+            }
+        }
+        inline double box_goal_dist(int c) const{
+            return _box_goal_dist[c];
+        }
+        inline bool is_goal_cell(int c) const{
+            return _goal[c];
+        }
+        inline int neighbour(int c, int d) const{
+            return _neighbour[c*4+d];
+        }
+
+        //////////////////////////
+        // Agent adapter        //
+        //////////////////////////
+        // Value state for a BoardState of this level
+        // @return false if s is not a BoardState or a box is off the floor
+        bool from_state(const State* s, state_type& out) const{
+            const BoardState* bs = dynamic_cast<const BoardState*>(s);
+            if (!bs) return false;
+            memset(&out, 0, sizeof(out));
+            pii p = bs->get_player_loc();
+            if (p.first < 0 || p.second < 0 || p.first >= _cols || p.second >= _rows) return false;
+            out._player = p.second*_cols + p.first;
+            for (const std::pair<pii, int>& box_pii: bs->get_boxes()){
+                int c = box_pii.first.second*_cols + box_pii.first.first;
+                if (_floor_index[c] < 0) return false;
+                set_box(out, c, true);
+            }
+            reach(out, out._player);
+            out._region = region_after_reach(out);
+            return true;
+        }
+        // The same push action Sokoban::get_actions builds
+        std::shared_ptr<Action> to_action(const move_type& m) const{
+            int x = m._box % _cols;
+            int y = m._box / _cols;
+            std::ostringstream os;
+            os << "MOVE " << x << " " << y << " PUSH " << MOVE_DIR[m._dir];
+            return std::make_shared<PositionAction>(Sokoban::action_types::push_move, (double)m._cost, os.str(), pii(x, y), (int)m._dir);
+        }
+};
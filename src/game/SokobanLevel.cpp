@@ -0,0 +1,184 @@
+#include "SokobanLevel.h"
+#include "../util/Trace.h"
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+#include <dirent.h>
+#include <sys/stat.h>
+
+SokobanLevel::SokobanLevel():_rows(0),_cols(0){}
+
+Sokoban* SokobanLevel::make_game(bool prune) const{
+    Trace::Scope trace("make_game", "level", _name);
+    // Sokoban only reads raw[y][x], point straight into our rows
+    std::vector<std::string> rows(_cells);
+    std::vector<char*> raw(_rows);
+    for (int y=0;y<_rows;++y) raw[y] = &rows[y][0];
+    Sokoban* sokoban = new Sokoban(_rows, _cols, raw.data(), prune);
+    if (!sokoban->valid()){
+        delete sokoban;
+        return nullptr;
+    }
+    return sokoban;
+}
+
+int SokobanLevel::read(std::istream& in, SokobanLevel& level){
+    // Parse board dimensions
+    std::string line;
+    if (!getline(in, line)){
+        std::cerr << "(SokobanLevel::read) Error: unable to read game board dimensions" << std::endl;
+        return SokobanLevel::ERR_CODE::DIMS_ERROR;
+    }
+    std::istringstream dims(line);
+    dims >> level._rows >> level._cols;
+    if (dims.fail() || level._rows <= 0 || level._cols <= 0){
+        std::cerr << "(SokobanLevel::read) Error: unable to read game board dimensions" << std::endl;
+        return SokobanLevel::ERR_CODE::DIMS_ERROR;
+    }
+    // Read rows, skipping whitespace between cells
+    level._cells.assign(level._rows, std::string());
+    for (int y=0;y<level._rows;++y){
+        if (!getline(in, line)) line.clear();
+        std::istringstream iss(line);
+        char cell;
+        for (int x=0;x<level._cols;++x){
+            iss >> cell;
+            if (iss.fail()){
+                std::cerr << "(SokobanLevel::read) Error: unable to read game cell (" << x << "," << y << ")" << std::endl;
+                return SokobanLevel::ERR_CODE::CELL_ERROR;
+            }
+            level._cells[y].push_back(cell);
+        }
+    }
+    return SokobanLevel::ERR_CODE::SUCCESS;
+}
+
+// File name without directory or extension
+static std::string file_stem(const std::string& path){
+    size_t slash = path.find_last_of('/');
+    std::string name = (slash == std::string::npos) ? path : path.substr(slash+1);
+    size_t dot = name.find_last_of('.');
+    return (dot == std::string::npos) ? name : name.substr(0, dot);
+}
+
+static bool ends_with(const std::string& s, const std::string& suffix){
+    return s.size() >= suffix.size() && s.compare(s.size()-suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Compare runs of digits by value so level_2 < level_10
+static bool natural_less(const std::string& a, const std::string& b){
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()){
+        if (isdigit(a[i]) && isdigit(b[j])){
+            size_t ie = i, je = j;
+            while (ie < a.size() && isdigit(a[ie])) ++ie;
+            while (je < b.size() && isdigit(b[je])) ++je;
+            long long va = std::stoll(a.substr(i, ie-i));
+            long long vb = std::stoll(b.substr(j, je-j));
+            if (va != vb) return va < vb;
+            i = ie; j = je;
+        }
+        else{
+            if (a[i] != b[j]) return a[i] < b[j];
+            ++i; ++j;
+        }
+    }
+    return a.size() - i < b.size() - j;
+}
+
+int SokobanLevel::load_file(const std::string& path, SokobanLevel& level){
+    Trace::Scope trace("load_level", "level", path);
+    std::ifstream fin(path);
+    if (!fin){
+        std::cerr << "(SokobanLevel::load_file) Error: <" << path << "> not found" << std::endl;
+        return SokobanLevel::ERR_CODE::FILE_ERROR;
+    }
+    level._name = file_stem(path);
+    return read(fin, level);
+}
+
+int SokobanLevel::load_xsb(const std::string& path, std::vector<SokobanLevel>& levels){
+    std::ifstream fin(path);
+    if (!fin){
+        std::cerr << "(SokobanLevel::load_xsb) Error: <" << path << "> not found" << std::endl;
+        return SokobanLevel::ERR_CODE::FILE_ERROR;
+    }
+    std::string stem = file_stem(path);
+    std::vector<std::string> rows;
+    std::string line;
+    int num = 1;
+    while (getline(fin, line)){
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) continue;
+        if (line[0] != ';'){
+            rows.push_back(line);
+            continue;
+        }
+        // End of a board, translate to our cell characters and pad with empty cells
+        if (rows.empty()) continue;
+        SokobanLevel level;
+        level._name = stem + "_" + std::to_string(num++);
+        level._rows = rows.size();
+        for (const std::string& r: rows) level._cols = std::max(level._cols, (int)r.size());
+        for (const std::string& r: rows){
+            std::string cells(level._cols, '.');
+            for (size_t x=0;x<r.size();++x){
+                switch (r[x]){
+                    case '#': cells[x] = '#'; break;
+                    case '$': cells[x] = 'x'; break;
+                    case '.': cells[x] = '_'; break;
+                    case '*': cells[x] = '@'; break;
+                    case '@': cells[x] = 'o'; break;
+                    case '+': cells[x] = '!'; break;
+                    case ' ': case '-': case '_': cells[x] = '.'; break;
+                    default:
+                        std::cerr << "(SokobanLevel::load_xsb) Error: unrecognized char '" << r[x] << "' in " << level._name << std::endl;
+                        return SokobanLevel::ERR_CODE::CELL_ERROR;
+                }
+            }
+            level._cells.push_back(cells);
+        }
+        levels.push_back(level);
+        rows.clear();
+    }
+    if (!rows.empty()){
+        std::cerr << "(SokobanLevel::load_xsb) Error: last board in <" << path << "> has no '; title' line" << std::endl;
+        return SokobanLevel::ERR_CODE::BOARD_ERROR;
+    }
+    return SokobanLevel::ERR_CODE::SUCCESS;
+}
+
+int SokobanLevel::load_path(const std::string& path, std::vector<SokobanLevel>& levels){
+    Trace::Scope trace("load_levels", "level", path);
+    struct stat st;
+    if (stat(path.c_str(), &st)){
+        std::cerr << "(SokobanLevel::load_path) Error: <" << path << "> not found" << std::endl;
+        return SokobanLevel::ERR_CODE::FILE_ERROR;
+    }
+    if (S_ISDIR(st.st_mode)){
+        DIR* dir = opendir(path.c_str());
+        if (!dir) return SokobanLevel::ERR_CODE::FILE_ERROR;
+        std::vector<std::string> files;
+        for (struct dirent* ent = readdir(dir); ent; ent = readdir(dir)){
+            std::string name(ent->d_name);
+            if (ends_with(name, ".in")) files.push_back(name);
+        }
+        closedir(dir);
+        std::sort(files.begin(), files.end(), natural_less);
+        for (const std::string& f: files){
+            SokobanLevel level;
+            int ret_code = load_file(path + "/" + f, level);
+            if (ret_code) return ret_code;
+            levels.push_back(level);
+        }
+        return SokobanLevel::ERR_CODE::SUCCESS;
+    }
+    if (ends_with(path, ".in")){
+        SokobanLevel level;
+        int ret_code = load_file(path, level);
+        if (!ret_code) levels.push_back(level);
+        return ret_code;
+    }
+    return load_xsb(path, levels);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Sokoban.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+// A Sokoban board in the character format Sokoban(r, c, raw) takes
+// .    : Empty cell
+// x    : Box
+// o    : Player starting location
+// #    : Wall
+// _    : Goal position for Box
+// @    : Goal position with Box
+// !    : Goal position with player
+// Levels come from .in files ("r c" line then r rows of c cells) or from XSB
+// collections (standard # $ . * @ + notation, each level followed by a '; title' line).
+class SokobanLevel{
+    public:
+        enum ERR_CODE{
+            SUCCESS         = 0x0,
+            FILE_ERROR      = 0x1,
+            DIMS_ERROR      = 0x2,
+            CELL_ERROR      = 0x4,
+            BOARD_ERROR     = 0x8
+        };
+        std::string _name;
+        int _rows, _cols;
+        // _rows strings of _cols cells
+        std::vector<std::string> _cells;
+        SokobanLevel();
+        // Build a game from this board (caller owns the result)
+        // @return nullptr if the board is invalid
+        Sokoban* make_game(bool prune=true) const;
+
+        ////////////////////
+        // Level loaders  //
+        ////////////////////
+        // "r c" line then r rows of c cells (whitespace between cells is ignored)
+        // @return ERR_CODE
+        static int read(std::istream& in, SokobanLevel& level);
+        // A single .in file
+        static int load_file(const std::string& path, SokobanLevel& level);
+        // Every level of an XSB collection, named <file stem>_<n> like sokoban_reformat.py
+        static int load_xsb(const std::string& path, std::vector<SokobanLevel>& levels);
+        // A .in file, an XSB collection (any other extension) or a directory of .in files
+        // (in natural order, so _2 sorts before _10), appended to levels
+        static int load_path(const std::string& path, std::vector<SokobanLevel>& levels);
+};
@@ -0,0 +1,8 @@
+#include "FixedNPuzzleHeuristic.h"
+
+Heuristic* make_fixed_npuzzle_heuristic(int rows, int cols){
+    if (rows == 3 && cols == 3) return new FixedNPuzzleHeuristic<3, 3>();
+    if (rows == 4 && cols == 4) return new FixedNPuzzleHeuristic<4, 4>();
+    if (rows == 5 && cols == 5) return new FixedNPuzzleHeuristic<5, 5>();
+    return nullptr;
+}
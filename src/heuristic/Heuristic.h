@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../game/Game.h"
+#include "../util/Hash.h"
 #include <cmath>
 
 // Define a short helper function for manhattan distances between two pair objects
@@ -19,16 +20,27 @@ T sq_distance(std::pair<T, T> p1, std::pair<T, T> p2){
     return dx*dx + dy*dy;
 };
 
-struct pair_hash{
-	template <class T1, class T2>
-	std::size_t operator() (const std::pair<T1, T2>& p) const{
-		return std::hash<T1>()(p.first) ^ std::hash<T2>()(p.second);
-	}
-};
+typedef PairHash pair_hash;
 
 class Heuristic{
     public:
         virtual double score(const State* s, const Game* g) const = 0;
+        // Score child (reached from parent by playing a) given parent_h = score(parent)
+        // Heuristics that can apply a per-move delta override this and is_incremental()
+        virtual double score_child(double parent_h, const State* parent, const Action* a, const State* child, const Game* g) const{
+            return score(child, g);
+        }
+        virtual bool is_incremental() const{ return false; }
+        // Score n states at once, out[i] = score(states[i], g) (e.g. all successors of an expansion)
+        // Overrides spread expensive heuristics over threads or vectorize cheap ones
+        virtual void score_batch(const State* const* states, size_t n, const Game* g, double* out) const{
+            for (size_t i=0;i<n;++i) out[i] = score(states[i], g);
+        }
+        // score_child over n children of one parent, out[i] = score_child(parent_h, parent, actions[i], children[i], g)
+        virtual void score_child_batch(double parent_h, const State* parent, const Action* const* actions, const State* const* children,
+                                       size_t n, const Game* g, double* out) const{
+            for (size_t i=0;i<n;++i) out[i] = score_child(parent_h, parent, actions[i], children[i], g);
+        }
         virtual ~Heuristic(){};
 };
 
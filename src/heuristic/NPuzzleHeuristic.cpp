@@ -17,8 +17,8 @@ double NPuzzleHeuristic::score(const State* s, const Game* g) const{
     return score(ts, np);
 }
 
-// Implement manhattan distance + linear conflicts Consistent Heuristic
-double NPuzzleHeuristic::score(const TileState* ts, const NPuzzle* np) const{
+// Sum of manhattan distances of every cell (blank included) to its home
+double NPuzzleHeuristic::manhattan(const TileState* ts, const NPuzzle* np) const{
     double score = 0.0;
     // Get dimensions of NPuzzle board
     pii dims_xy = np->get_dims();
@@ -28,62 +28,113 @@ double NPuzzleHeuristic::score(const TileState* ts, const NPuzzle* np) const{
             score += (double) manhattan_distance<int>(pii(x,y), ts->get_tile_home_position(x,y));
         }
     }
+    return score;
+}
+
+// Number of conflicting tile pairs in column x
+int NPuzzleHeuristic::column_conflicts(const TileState* ts, int x, int rows) const{
+    // Create set to store conflicting pairs in this column
+    std::unordered_set<pii, pair_hash> conflicts;
+    for (int y=0;y<rows;++y){
+        // Look at whether this cell could have conflicts
+        pii cur_home_pos = ts->get_tile_home_position(x, y);
+        if (cur_home_pos.first == x){
+            // Look from current y till goal y
+            int min_y = std::min(cur_home_pos.second, y);
+            int max_y = std::max(cur_home_pos.second, y);
+            for (int dy=min_y;dy<=max_y;++dy){
+                if (dy == y) continue;
+                bool is_real = ts->get_tile_real(x, dy);
+                if (!is_real) continue;
+                pii int_tile_home_pos = ts->get_tile_home_position(x, dy);
+                if (int_tile_home_pos.first == x){
+                    conflicts.insert(pii(std::min(dy,y), std::max(dy,y)));
+                }
+            }
+        }
+    }
+    return conflicts.size();
+}
 
-    // return score;
+// Number of conflicting tile pairs in row y
+int NPuzzleHeuristic::row_conflicts(const TileState* ts, int y, int cols) const{
+    // Create set to store conflicting pairs in this row
+    std::unordered_set<pii, pair_hash> conflicts;
+    for (int x=0;x<cols;++x){
+        // Look at whether this cell could have conflicts
+        pii cur_home_pos = ts->get_tile_home_position(x, y);
+        if (cur_home_pos.second == y){
+            // Look from current x till goal x
+            int min_x = std::min(cur_home_pos.first, x);
+            int max_x = std::max(cur_home_pos.first, x);
+            for (int dx=min_x;dx<=max_x;++dx){
+                if (dx == x) continue;
+                bool is_real = ts->get_tile_real(dx, y);
+                if (!is_real) continue;
+                pii int_tile_home_pos = ts->get_tile_home_position(dx, y);
+                if (int_tile_home_pos.second == y){
+                    conflicts.insert(pii(std::min(dx,x), std::max(dx,x)));
+                }
+            }
+        }
+    }
+    return conflicts.size();
+}
+
+// Implement manhattan distance + linear conflicts Consistent Heuristic
+double NPuzzleHeuristic::score(const TileState* ts, const NPuzzle* np) const{
+    double score = manhattan(ts, np);
+    // Get dimensions of NPuzzle board
+    pii dims_xy = np->get_dims();
 
     int num_conflicts = 0;
 
     // Run through each column to grab number of linear conflicts
     for (int x=0;x<dims_xy.first;++x){
-        // Create set to store conflicting pairs in this row
-        std::unordered_set<pii, pair_hash> conflicts;
-        for (int y=0;y<dims_xy.second;++y){
-            // Look at whether this cell could have conflicts
-            pii cur_home_pos = ts->get_tile_home_position(x, y);
-            if (cur_home_pos.first == x){
-                // Look from current y till goal y
-                int min_y = std::min(cur_home_pos.second, y);
-                int max_y = std::max(cur_home_pos.second, y);
-                for (int dy=min_y;dy<=max_y;++dy){
-                    if (dy == y) continue;
-                    bool is_real = ts->get_tile_real(x, dy);
-                    if (!is_real) continue;
-                    pii int_tile_home_pos = ts->get_tile_home_position(x, dy);
-                    if (int_tile_home_pos.first == x){
-                        conflicts.insert(pii(std::min(dy,y), std::max(dy,y)));
-                    }
-                }
-            }
-        }
-        num_conflicts += conflicts.size();
+        num_conflicts += column_conflicts(ts, x, dims_xy.second);
     }
 
     // Run through each row to grab number of linear conflicts
     for (int y=0;y<dims_xy.second;++y){
-        // Create set to store conflicting pairs in this row
-        std::unordered_set<pii, pair_hash> conflicts;
-        for (int x=0;x<dims_xy.first;++x){
-            // Look at whether this cell could have conflicts
-            pii cur_home_pos = ts->get_tile_home_position(x, y);
-            if (cur_home_pos.second == y){
-                // Look from current x till goal x
-                int min_x = std::min(cur_home_pos.first, x);
-                int max_x = std::max(cur_home_pos.first, x);
-                for (int dx=min_x;dx<=max_x;++dx){
-                    if (dx == x) continue;
-                    bool is_real = ts->get_tile_real(dx, y);
-                    if (!is_real) continue;
-                    pii int_tile_home_pos = ts->get_tile_home_position(dx, y);
-                    if (int_tile_home_pos.second == y){
-                        conflicts.insert(pii(std::min(dx,x), std::max(dx,x)));
-                    }
-                }
-            }
-        }
-        num_conflicts += conflicts.size();
+        num_conflicts += row_conflicts(ts, y, dims_xy.first);
     }
 
     score += num_conflicts*2;
 
     return score;
 }
+
+double NPuzzleHeuristic::score_child(double parent_h, const State* parent, const Action* a, const State* child, const Game* g) const{
+    const TileState* pts = dynamic_cast<const TileState*>(parent);
+    const TileState* cts = dynamic_cast<const TileState*>(child);
+    const NPuzzle* np = dynamic_cast<const NPuzzle*>(g);
+    if (!pts || !cts || !np || std::isnan(parent_h)){
+        return score(child, g);
+    }
+    // The blank moved from b to nb and the tile at nb slid into b
+    pii b = pts->get_empty_space();
+    pii nb = cts->get_empty_space();
+    if (manhattan_distance<int>(b, nb) != 1){
+        return score(child, g);
+    }
+    pii dims_xy = np->get_dims();
+    pii home = cts->get_tile_home_position(b.first, b.second);
+    pii blank_home = cts->get_tile_home_position(nb.first, nb.second);
+    double delta = manhattan_distance<int>(b, home) - manhattan_distance<int>(nb, home)
+                 + manhattan_distance<int>(nb, blank_home) - manhattan_distance<int>(b, blank_home);
+    // Only the lines the two cells lie on can change their conflict count
+    int conflicts = 0;
+    if (b.first == nb.first){
+        // Vertical move: one column, two rows
+        conflicts += column_conflicts(cts, b.first, dims_xy.second) - column_conflicts(pts, b.first, dims_xy.second);
+        conflicts += row_conflicts(cts, b.second, dims_xy.first) - row_conflicts(pts, b.second, dims_xy.first);
+        conflicts += row_conflicts(cts, nb.second, dims_xy.first) - row_conflicts(pts, nb.second, dims_xy.first);
+    }
+    else{
+        // Horizontal move: one row, two columns
+        conflicts += row_conflicts(cts, b.second, dims_xy.first) - row_conflicts(pts, b.second, dims_xy.first);
+        conflicts += column_conflicts(cts, b.first, dims_xy.second) - column_conflicts(pts, b.first, dims_xy.second);
+        conflicts += column_conflicts(cts, nb.first, dims_xy.second) - column_conflicts(pts, nb.first, dims_xy.second);
+    }
+    return parent_h + delta + conflicts*2;
+}
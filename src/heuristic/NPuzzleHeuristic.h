@@ -9,9 +9,17 @@ class NPuzzleHeuristic: public Heuristic{
     protected:
         // In private, we (programmers) know that NPuzzle uses TileState and NPuzzle
         virtual double score(const TileState* ts, const NPuzzle *np) const;
+        // Linear conflicts along a single column / row
+        int column_conflicts(const TileState* ts, int x, int rows) const;
+        int row_conflicts(const TileState* ts, int y, int cols) const;
     public:
         NPuzzleHeuristic();
         virtual ~NPuzzleHeuristic();
         // Public consistent interface wrapper for internal score function
         virtual double score(const State* s, const Game* g) const override;
+        // A move slides one tile, so only its Manhattan term and the lines it touches change
+        virtual bool is_incremental() const override{ return true; }
+        virtual double score_child(double parent_h, const State* parent, const Action* a, const State* child, const Game* g) const override;
+        // Manhattan term of score (without linear conflicts)
+        double manhattan(const TileState* ts, const NPuzzle* np) const;
 };
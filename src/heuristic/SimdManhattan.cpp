@@ -0,0 +1,187 @@
+#include "SimdManhattan.h"
+#include <cstring>
+#include <cstdlib>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_MANHATTAN_X86
+#include <immintrin.h>
+#endif
+
+SimdManhattan::SimdManhattan(int rows, int cols, bool count_blank):_rows(rows), _cols(cols), _cells(rows*cols), _count_blank(count_blank){
+    memset(_home_row, 0, sizeof(_home_row));
+    memset(_home_col, 0, sizeof(_home_col));
+    memset(_cell_row, 0, sizeof(_cell_row));
+    memset(_cell_col, 0, sizeof(_cell_col));
+    memset(_cell_mask, 0, sizeof(_cell_mask));
+    if (_cells > MAX_CELLS) _cells = MAX_CELLS;
+    // Goal index t sits at (t % cols, t / cols), same as cell index
+    for (int t=0;t<_cells;++t){
+        _home_row[t] = _cell_row[t] = t / cols;
+        _home_col[t] = _cell_col[t] = t % cols;
+        _cell_mask[t] = 0xFF;
+    }
+    _kernel = detect();
+}
+
+SimdManhattan::kernel_type SimdManhattan::detect(){
+#ifdef SIMD_MANHATTAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return kernel_type::AVX2;
+    if (__builtin_cpu_supports("ssse3")) return kernel_type::SSSE3;
+#endif
+    return kernel_type::SCALAR;
+}
+
+SimdManhattan::kernel_type SimdManhattan::set_kernel(kernel_type k){
+    kernel_type best = detect();
+    _kernel = (k > best) ? best : k;
+    return _kernel;
+}
+
+SimdManhattan::kernel_type SimdManhattan::get_kernel() const{
+    return _kernel;
+}
+
+const char* SimdManhattan::kernel_name(kernel_type k){
+    switch(k){
+        case kernel_type::AVX2: return "avx2";
+        case kernel_type::SSSE3: return "ssse3";
+        default: return "scalar";
+    }
+}
+
+int SimdManhattan::score(const uint8_t* board) const{
+    switch(_kernel){
+        // A single board of <= 16 cells fits one 128-bit register
+        case kernel_type::AVX2: return (_cells > 16) ? score_avx2(board) : score_ssse3(board);
+        case kernel_type::SSSE3: return score_ssse3(board);
+        default: return score_scalar(board);
+    }
+}
+
+void SimdManhattan::score_batch(const uint8_t* const* boards, size_t n, int* out) const{
+    size_t i = 0;
+    // Two boards share one 256-bit register when each fits in a 128-bit lane
+    if (_kernel == kernel_type::AVX2 && _cells <= 16){
+        for (;i+1<n;i+=2) score_pair_avx2(boards[i], boards[i+1], out+i);
+    }
+    for (;i<n;++i) out[i] = score(boards[i]);
+}
+
+int SimdManhattan::score_scalar(const uint8_t* board) const{
+    int h = 0;
+    for (int p=0;p<_cells;++p){
+        int t = board[p];
+        if (!t && !_count_blank) continue;
+        h += std::abs(_home_row[t] - _cell_row[p]) + std::abs(_home_col[t] - _cell_col[p]);
+    }
+    return h;
+}
+
+#ifdef SIMD_MANHATTAN_X86
+
+__attribute__((target("ssse3")))
+int SimdManhattan::score_ssse3(const uint8_t* board) const{
+    alignas(16) uint8_t buf[MAX_CELLS] = {0};
+    const uint8_t* src = buf;
+    // 4x4 boards are exactly one register, no padding needed
+    if (_cells == 16) src = board;
+    else memcpy(buf, board, _cells);
+    const __m128i low_nibble = _mm_set1_epi8(0x0F);
+    const __m128i fifteen = _mm_set1_epi8(15);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i sum = zero;
+    for (int half=0;half*16<_cells;++half){
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + 16*half));
+        __m128i idx = _mm_and_si128(v, low_nibble);
+        __m128i hr = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)_home_row), idx);
+        __m128i hc = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)_home_col), idx);
+        if (_cells > 16){
+            // Tiles 16..31 come from the upper half of the tables
+            __m128i hi = _mm_cmpgt_epi8(v, fifteen);
+            __m128i hr_hi = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)(_home_row + 16)), idx);
+            __m128i hc_hi = _mm_shuffle_epi8(_mm_load_si128((const __m128i*)(_home_col + 16)), idx);
+            hr = _mm_or_si128(_mm_and_si128(hi, hr_hi), _mm_andnot_si128(hi, hr));
+            hc = _mm_or_si128(_mm_and_si128(hi, hc_hi), _mm_andnot_si128(hi, hc));
+        }
+        __m128i cr = _mm_load_si128((const __m128i*)(_cell_row + 16*half));
+        __m128i cc = _mm_load_si128((const __m128i*)(_cell_col + 16*half));
+        __m128i dr = _mm_sub_epi8(_mm_max_epu8(hr, cr), _mm_min_epu8(hr, cr));
+        __m128i dc = _mm_sub_epi8(_mm_max_epu8(hc, cc), _mm_min_epu8(hc, cc));
+        __m128i d = _mm_and_si128(_mm_add_epi8(dr, dc), _mm_load_si128((const __m128i*)(_cell_mask + 16*half)));
+        if (!_count_blank) d = _mm_andnot_si128(_mm_cmpeq_epi8(v, zero), d);
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(d, zero));
+    }
+    return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+}
+
+__attribute__((target("avx2")))
+int SimdManhattan::score_avx2(const uint8_t* board) const{
+    alignas(32) uint8_t buf[MAX_CELLS] = {0};
+    memcpy(buf, board, _cells);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i v = _mm256_load_si256((const __m256i*)buf);
+    __m256i idx = _mm256_and_si256(v, _mm256_set1_epi8(0x0F));
+    // vpshufb looks up within each 128-bit lane, so broadcast the 16-entry tables
+    __m256i hr = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)_home_row)), idx);
+    __m256i hc = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)_home_col)), idx);
+    if (_cells > 16){
+        __m256i hi = _mm256_cmpgt_epi8(v, _mm256_set1_epi8(15));
+        __m256i hr_hi = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)(_home_row + 16))), idx);
+        __m256i hc_hi = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)(_home_col + 16))), idx);
+        hr = _mm256_blendv_epi8(hr, hr_hi, hi);
+        hc = _mm256_blendv_epi8(hc, hc_hi, hi);
+    }
+    __m256i cr = _mm256_load_si256((const __m256i*)_cell_row);
+    __m256i cc = _mm256_load_si256((const __m256i*)_cell_col);
+    __m256i dr = _mm256_sub_epi8(_mm256_max_epu8(hr, cr), _mm256_min_epu8(hr, cr));
+    __m256i dc = _mm256_sub_epi8(_mm256_max_epu8(hc, cc), _mm256_min_epu8(hc, cc));
+    __m256i d = _mm256_and_si256(_mm256_add_epi8(dr, dc), _mm256_load_si256((const __m256i*)_cell_mask));
+    if (!_count_blank) d = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, zero), d);
+    __m256i sad = _mm256_sad_epu8(d, zero);
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(sad), _mm256_extracti128_si256(sad, 1));
+    return _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(sum, sum));
+}
+
+__attribute__((target("avx2")))
+void SimdManhattan::score_pair_avx2(const uint8_t* a, const uint8_t* b, int* out) const{
+    alignas(32) uint8_t buf[32] = {0};
+    memcpy(buf, a, _cells);
+    memcpy(buf + 16, b, _cells);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i v = _mm256_load_si256((const __m256i*)buf);
+    __m256i idx = _mm256_and_si256(v, _mm256_set1_epi8(0x0F));
+    __m256i hr = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)_home_row)), idx);
+    __m256i hc = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)_home_col)), idx);
+    // Both lanes index the same 16 cells
+    __m256i cr = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)_cell_row));
+    __m256i cc = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)_cell_col));
+    __m256i mask = _mm256_broadcastsi128_si256(_mm_load_si128((const __m128i*)_cell_mask));
+    __m256i dr = _mm256_sub_epi8(_mm256_max_epu8(hr, cr), _mm256_min_epu8(hr, cr));
+    __m256i dc = _mm256_sub_epi8(_mm256_max_epu8(hc, cc), _mm256_min_epu8(hc, cc));
+    __m256i d = _mm256_and_si256(_mm256_add_epi8(dr, dc), mask);
+    if (!_count_blank) d = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, zero), d);
+    __m256i sad = _mm256_sad_epu8(d, zero);
+    __m128i lo = _mm256_castsi256_si128(sad);
+    __m128i hi = _mm256_extracti128_si256(sad, 1);
+    out[0] = _mm_cvtsi128_si32(lo) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(lo, lo));
+    out[1] = _mm_cvtsi128_si32(hi) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(hi, hi));
+}
+
+#else
+
+// Non-x86 builds only ever select the scalar kernel
+int SimdManhattan::score_ssse3(const uint8_t* board) const{
+    return score_scalar(board);
+}
+
+int SimdManhattan::score_avx2(const uint8_t* board) const{
+    return score_scalar(board);
+}
+
+void SimdManhattan::score_pair_avx2(const uint8_t* a, const uint8_t* b, int* out) const{
+    out[0] = score_scalar(a);
+    out[1] = score_scalar(b);
+}
+
+#endif
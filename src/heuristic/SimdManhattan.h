@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Manhattan distance over packed NPuzzle boards (board[y*cols+x] = goal index of the tile, 0 = blank)
+// Tile home rows/cols are looked up with byte shuffles, differenced against the
+// per-cell rows/cols and summed horizontally with psadbw. The kernel (AVX2, SSSE3
+// or scalar) is picked once at construction from the CPU's feature flags.
+// Boards of up to MAX_CELLS cells (5x5 and smaller) are supported.
+class SimdManhattan{
+    public:
+        static const int MAX_CELLS = 32;
+        enum kernel_type{
+            SCALAR  = 0,
+            SSSE3   = 1,
+            AVX2    = 2
+        };
+        // count_blank matches NPuzzleHeuristic, which also charges the blank's distance
+        SimdManhattan(int rows, int cols, bool count_blank=false);
+        // Single board
+        int score(const uint8_t* board) const;
+        // n boards (e.g. all successors of an expansion), out[i] = score(boards[i])
+        void score_batch(const uint8_t* const* boards, size_t n, int* out) const;
+        // Force a kernel (falls back to the best supported one below it)
+        // @return kernel actually selected
+        kernel_type set_kernel(kernel_type k);
+        kernel_type get_kernel() const;
+        static const char* kernel_name(kernel_type k);
+        // Best kernel this CPU supports
+        static kernel_type detect();
+    private:
+        int _rows, _cols, _cells;
+        bool _count_blank;
+        kernel_type _kernel;
+        // Indexed by tile (goal index), padded with zeros
+        alignas(32) uint8_t _home_row[MAX_CELLS];
+        alignas(32) uint8_t _home_col[MAX_CELLS];
+        // Indexed by cell, padded with zeros
+        alignas(32) uint8_t _cell_row[MAX_CELLS];
+        alignas(32) uint8_t _cell_col[MAX_CELLS];
+        // 0xFF for cells on the board, 0x00 for padding
+        alignas(32) uint8_t _cell_mask[MAX_CELLS];
+        int score_scalar(const uint8_t* board) const;
+        int score_ssse3(const uint8_t* board) const;
+        int score_avx2(const uint8_t* board) const;
+        void score_pair_avx2(const uint8_t* a, const uint8_t* b, int* out) const;
+};
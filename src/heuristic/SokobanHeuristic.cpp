@@ -1,4 +1,6 @@
 #include "SokobanHeuristic.h"
+#include <atomic>
+#include <thread>
 
 // Used to store board coordinates
 typedef std::pair<int, int> pii;
@@ -7,7 +9,7 @@ typedef std::unordered_set<pii, PairHash> set_pii;
 // Used to memoize distances to locations via bfs step-distance
 typedef std::unordered_map<pii, int, PairHash> dist_map;
 
-SokobanHeuristic::SokobanHeuristic(){}
+SokobanHeuristic::SokobanHeuristic():_pool(nullptr), _min_parallel_batch(4){}
 
 SokobanHeuristic::~SokobanHeuristic(){}
 
@@ -37,6 +39,11 @@ double SokobanHeuristic::score(const BoardState* bs, const Sokoban* sok) const{
         score += cur_box_score;
         // occupied_goals.insert(g_loc);    //Makes search inadmissible
     }
+    score += player_penalty(bs);
+    return score;
+}
+
+double SokobanHeuristic::player_penalty(const BoardState* bs) const{
     // If player is standing on a goal, implies we've pushed some box out of the way, penalize
     pii _player_loc = bs->get_player_loc();
     if (bs->is_goal(_player_loc)){
@@ -46,12 +53,75 @@ double SokobanHeuristic::score(const BoardState* bs, const Sokoban* sok) const{
             pii adj_loc = pii(ax, ay);
             if (bs->is_box(adj_loc) && !bs->is_goal(adj_loc)){
                 // We pushed a box out of the way
-                score += 1.0;
-                break;
+                return 1.0;
             }
         }
     }
-    return score;
+    return 0.0;
+}
+
+// Box distances only depend on walls, so a push changes a single box term
+double SokobanHeuristic::score_child(double parent_h, const State* parent, const Action* a, const State* child, const Game* g) const{
+    const BoardState* pbs = dynamic_cast<const BoardState*>(parent);
+    const BoardState* cbs = dynamic_cast<const BoardState*>(child);
+    const PositionAction* pa = dynamic_cast<const PositionAction*>(a);
+    if (!pbs || !cbs || !pa || pa->_specifier != Sokoban::action_types::push_move ||
+        std::isnan(parent_h) || parent_h == std::numeric_limits<double>::infinity()){
+        return score(child, g);
+    }
+    pii old_loc = pa->_move_loc;
+    pii new_loc = pii(old_loc.first + ADJ[pa->_dir][0], old_loc.second + ADJ[pa->_dir][1]);
+    if (!cbs->is_box(new_loc) || !pbs->is_box(old_loc)){
+        return score(child, g);
+    }
+    double new_box_score = bfs_to_goal(cbs, new_loc);
+    if (new_box_score == std::numeric_limits<double>::infinity()) return new_box_score;
+    double old_box_score = bfs_to_goal(pbs, old_loc);
+    return parent_h - player_penalty(pbs) - old_box_score + new_box_score + player_penalty(cbs);
+}
+
+void SokobanHeuristic::set_pool(WorkStealingPool* pool, size_t min_batch){
+    _pool = pool;
+    _min_parallel_batch = min_batch < 2 ? 2 : min_batch;
+}
+
+void SokobanHeuristic::run_batch(size_t n, const std::function<void(size_t)>& item) const{
+    // Workers and the caller claim items one at a time. Helpers that start after
+    // the batch is done find nothing to claim and only touch the shared counters
+    struct Batch{
+        std::atomic<size_t> next, done;
+    };
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+    batch->next = 0;
+    batch->done = 0;
+    const std::function<void(size_t)>* f = &item;
+    auto work = [batch, n, f](){
+        for (size_t i = batch->next++;i < n;i = batch->next++){
+            (*f)(i);
+            batch->done++;
+        }
+    };
+    size_t helpers = std::min((size_t)_pool->size(), n - 1);
+    for (size_t i=0;i<helpers;++i) _pool->submit(work);
+    work();
+    while (batch->done.load() < n) std::this_thread::yield();
+}
+
+void SokobanHeuristic::score_batch(const State* const* states, size_t n, const Game* g, double* out) const{
+    if (!_pool || n < _min_parallel_batch){
+        Heuristic::score_batch(states, n, g, out);
+        return;
+    }
+    run_batch(n, [&](size_t i){out[i] = score(states[i], g);});
+}
+
+void SokobanHeuristic::score_child_batch(double parent_h, const State* parent, const Action* const* actions, const State* const* children,
+                                         size_t n, const Game* g, double* out) const{
+    if (!_pool || n < _min_parallel_batch){
+        Heuristic::score_child_batch(parent_h, parent, actions, children, n, g, out);
+        return;
+    }
+    run_batch(n, [&](size_t i){out[i] = score_child(parent_h, parent, actions[i], children[i], g);});
 }
 
 bool SokobanHeuristic::expand_admissible(const BoardState* bs, const pii& t_loc, const pii& f_loc) const{
@@ -3,12 +3,18 @@
 #include "Heuristic.h"
 #include "../game/Game.h"
 #include "../game/Sokoban.h"
+#include "../util/WorkStealingPool.h"
 #include <unordered_set>
 #include <algorithm>
 #include <limits>
 #include <functional>
 
 class SokobanHeuristic: public Heuristic{
+    private:
+        WorkStealingPool* _pool;
+        size_t _min_parallel_batch;
+        // Run item(i) for i < n on the pool's threads and the caller, return when all are done
+        void run_batch(size_t n, const std::function<void(size_t)>& item) const;
     protected:
 		typedef std::pair<int, int> pii;
     	typedef std::unordered_set<pii, PairHash> set_pii;
@@ -21,6 +27,8 @@ class SokobanHeuristic: public Heuristic{
         bool expand_admissible(const BoardState* bs, const pii& t_loc, const pii& f_loc) const;
         // Test whether we should terminate bfs once we have box at t_loc
         bool end_goal(const BoardState* bs, const pii& t_loc) const;
+        // Penalty for a player standing on a goal next to an unplaced box
+        double player_penalty(const BoardState* bs) const;
         double bfs_to_goal(const BoardState* bs, const pii& s_loc) const;
         double bfs_to_goal(const BoardState* bs, const pii& s_loc, pii& goal_loc) const;
         // Only one that contains bfs logic
@@ -66,4 +74,15 @@ class SokobanHeuristic: public Heuristic{
         virtual ~SokobanHeuristic();
         // Public consistent interface wrapper for internal score function
         virtual double score(const State* s, const Game* g) const override;
+        // Only the pushed box's BFS distance (and the player penalty) is recomputed
+        virtual bool is_incremental() const override{ return true; }
+        virtual double score_child(double parent_h, const State* parent, const Action* a, const State* child, const Game* g) const override;
+        // Batches of at least min_batch states are scored on pool's threads (null: serial)
+        // The pool is not owned and should be one no search runs on (the caller waits for its items)
+        void set_pool(WorkStealingPool* pool, size_t min_batch=4);
+        // Every state runs its own box BFSs, so siblings score independently
+        virtual void score_batch(const State* const* states, size_t n, const Game* g, double* out) const override;
+        // Per-push deltas of siblings, spread over the pool like score_batch
+        virtual void score_child_batch(double parent_h, const State* parent, const Action* const* actions, const State* const* children,
+                                       size_t n, const Game* g, double* out) const override;
 };
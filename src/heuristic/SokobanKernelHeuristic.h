@@ -0,0 +1,30 @@
+#pragma once
+
+#include "../game/SokobanKernel.h"
+#include <limits>
+
+// SokobanHeuristic on SokobanKernel states, for AStar<SokobanKernel<W>, SokobanKernelHeuristic<W>>
+// Same value: each box off a goal adds its push distance to the nearest goal (from
+// the kernel's per-cell table instead of a BFS per box), plus 1 when the player
+// stands on a goal next to a box off a goal.
+template<int W>
+class SokobanKernelHeuristic{
+    public:
+        typedef SokobanKernel<W> game_type;
+        typedef typename game_type::state_type state_type;
+        inline double score(const game_type& k, const state_type& s) const{
+            double score = 0.0;
+            k.for_each_box(s, [&k, &score](int c){
+                if (!k.is_goal_cell(c)) score += k.box_goal_dist(c);
+            });
+            // A dead box (no goal reachable) makes the sum infinite
+            if (score == std::numeric_limits<double>::infinity()) return score;
+            if (k.is_goal_cell(s._player)){
+                for (int d=0;d<4;++d){
+                    int n = k.neighbour(s._player, d);
+                    if (n >= 0 && k.has_box(s, n) && !k.is_goal_cell(n)) return score + 1.0;
+                }
+            }
+            return score;
+        }
+};
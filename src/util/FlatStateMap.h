@@ -0,0 +1,216 @@
+#pragma once
+
+#include "../game/Game.h"
+#include "Hash.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash map from states to V (Robin Hood probing)
+// Drop-in for std::unordered_map<std::shared_ptr<State>, V, StatePointerHash, DerefCompare>
+// in search loops. Entries live densely in insertion order; the probe table holds
+// 4 bytes of metadata per slot (probe distance and an 8-bit tag of the hash) and,
+// in a parallel array, the full 64-bit hash and the entry index. A probe walks the
+// metadata bytes, so most misses are rejected without touching a state. The
+// virtual State::operator== (a dynamic_cast for BoardState) runs only when tag
+// and full hash both match. State::hash() is called once per operation and mixed
+// so that weak hashes still spread over a power-of-2 table.
+// Unlike unordered_map, insert and erase invalidate iterators and pointers to
+// values (erase moves the last entry into the hole).
+template<class V>
+class FlatStateMap{
+    public:
+        typedef std::shared_ptr<State> key_type;
+        typedef std::pair<key_type, V> value_type;
+        typedef typename std::vector<value_type>::iterator iterator;
+        typedef typename std::vector<value_type>::const_iterator const_iterator;
+    private:
+        struct Meta{
+            uint16_t dist;  // Probe distance + 1, 0 = empty slot
+            uint8_t tag;    // Top byte of the hash
+        };
+        struct Slot{
+            uint64_t hash;
+            uint32_t id;    // Index into _entries
+        };
+        // Longest probe sequence before the table grows anyway (only reached when
+        // thousands of states share one hash value)
+        static const int MAX_DIST = 65000;
+        std::vector<Meta> _meta;
+        std::vector<Slot> _slots;
+        std::vector<value_type> _entries;
+        std::vector<uint64_t> _hashes;  // Per entry, for rehashing
+        size_t _mask;
+
+        static inline uint64_t hash_of(const key_type& k){
+            return mix64(k->hash());
+        }
+        // Slot holding k, or -1
+        long locate(const key_type& k, uint64_t h) const{
+            if (_meta.empty()) return -1;
+            size_t pos = h & _mask;
+            uint8_t tag = h >> 56;
+            for (int d=1;;++d){
+                const Meta& m = _meta[pos];
+                // Robin Hood invariant: k would have displaced anything closer to home
+                if (m.dist < d) return -1;
+                if (m.tag == tag && _slots[pos].hash == h && *_entries[_slots[pos].id].first == *k) return pos;
+                pos = (pos + 1) & _mask;
+            }
+        }
+        // Put entry id into the probe table
+        // @return false if a probe sequence got too long (caller grows)
+        bool place(uint64_t h, uint32_t id){
+            size_t pos = h & _mask;
+            Meta m = {1, (uint8_t)(h >> 56)};
+            Slot s = {h, id};
+            bool ok = true;
+            for (;;){
+                if (!_meta[pos].dist){
+                    _meta[pos] = m;
+                    _slots[pos] = s;
+                    return ok;
+                }
+                if (_meta[pos].dist < m.dist){
+                    std::swap(_meta[pos], m);
+                    std::swap(_slots[pos], s);
+                }
+                pos = (pos + 1) & _mask;
+                if (++m.dist > MAX_DIST){
+                    m.dist = MAX_DIST;
+                    ok = false;
+                }
+            }
+        }
+        void rehash(size_t slots){
+            size_t n = 16;
+            while (n < slots) n *= 2;
+            for (;;){
+                _meta.assign(n, Meta{0, 0});
+                _slots.resize(n);
+                _mask = n - 1;
+                bool ok = true;
+                for (size_t i=0;i<_entries.size() && ok;++i) ok = place(_hashes[i], i);
+                if (ok) return;
+                if (n > 64*_entries.size()) throw std::length_error("FlatStateMap: too many states share one hash value");
+                n *= 2;
+            }
+        }
+        // Keep the load under 7/8
+        void grow_for(size_t count){
+            if (count*8 > _meta.size()*7) rehash(_meta.size() ? _meta.size()*2 : 16);
+        }
+    public:
+        // Hash quality of the current contents (see probe_stats)
+        struct ProbeStats{
+            size_t entries, slots;
+            double mean_probe;          // Slots inspected to find a stored entry
+            size_t max_probe;
+            size_t hash_collisions;     // Entries whose 64-bit hash an earlier, different state already has
+            std::vector<size_t> bucket_load;    // Home slots that 0, 1, 2, 3 and 4+ entries hash to
+        };
+        FlatStateMap():_mask(0){}
+        size_t size() const{return _entries.size();}
+        bool empty() const{return _entries.empty();}
+        void clear(){
+            _meta.clear();
+            _slots.clear();
+            _entries.clear();
+            _hashes.clear();
+            _mask = 0;
+        }
+        void reserve(size_t n){
+            if (n*8 > _meta.size()*7) rehash(n*8/7 + 1);
+            _entries.reserve(n);
+            _hashes.reserve(n);
+        }
+        iterator begin(){return _entries.begin();}
+        iterator end(){return _entries.end();}
+        const_iterator begin() const{return _entries.begin();}
+        const_iterator end() const{return _entries.end();}
+        iterator find(const key_type& k){
+            long pos = locate(k, hash_of(k));
+            return pos < 0 ? end() : _entries.begin() + _slots[pos].id;
+        }
+        const_iterator find(const key_type& k) const{
+            long pos = locate(k, hash_of(k));
+            return pos < 0 ? end() : _entries.begin() + _slots[pos].id;
+        }
+        size_t count(const key_type& k) const{
+            return find(k) != end();
+        }
+        std::pair<iterator, bool> insert(const value_type& kv){
+            uint64_t h = hash_of(kv.first);
+            long pos = locate(kv.first, h);
+            if (pos >= 0) return std::make_pair(_entries.begin() + _slots[pos].id, false);
+            grow_for(_entries.size() + 1);
+            _entries.push_back(kv);
+            _hashes.push_back(h);
+            if (!place(h, _entries.size() - 1)) rehash(_meta.size()*2);
+            return std::make_pair(_entries.end() - 1, true);
+        }
+        V& operator[](const key_type& k){
+            return insert(value_type(k, V())).first->second;
+        }
+        size_t erase(const key_type& k){
+            long found = locate(k, hash_of(k));
+            if (found < 0) return 0;
+            size_t pos = found;
+            uint32_t id = _slots[pos].id;
+            // Backward shift: pull the rest of the cluster one slot closer to home
+            size_t next = (pos + 1) & _mask;
+            while (_meta[next].dist > 1){
+                _meta[pos] = _meta[next];
+                _meta[pos].dist--;
+                _slots[pos] = _slots[next];
+                pos = next;
+                next = (next + 1) & _mask;
+            }
+            _meta[pos].dist = 0;
+            // Move the last entry into the hole and repoint its slot
+            uint32_t last = _entries.size() - 1;
+            if (id != last){
+                _entries[id] = std::move(_entries[last]);
+                _hashes[id] = _hashes[last];
+                size_t p = _hashes[id] & _mask;
+                while (_slots[p].id != last || !_meta[p].dist) p = (p + 1) & _mask;
+                _slots[p].id = id;
+            }
+            _entries.pop_back();
+            _hashes.pop_back();
+            return 1;
+        }
+        // Walks the whole table, for diagnostics only
+        ProbeStats probe_stats() const{
+            ProbeStats ps = {_entries.size(), _meta.size(), 0.0, 0, 0, std::vector<size_t>(5, 0)};
+            size_t total = 0;
+            for (const Meta& m: _meta){
+                total += m.dist;
+                ps.max_probe = std::max(ps.max_probe, (size_t)m.dist);
+            }
+            if (!_entries.empty()) ps.mean_probe = (double)total/_entries.size();
+            std::vector<uint32_t> load(_meta.size(), 0);
+            for (uint64_t h: _hashes) load[h & _mask]++;
+            for (uint32_t c: load) ps.bucket_load[std::min<uint32_t>(c, 4)]++;
+            std::vector<uint64_t> sorted(_hashes);
+            std::sort(sorted.begin(), sorted.end());
+            for (size_t i=1;i<sorted.size();++i) ps.hash_collisions += sorted[i] == sorted[i-1];
+            return ps;
+        }
+        void report(std::ostream& os) const{
+            ProbeStats ps = probe_stats();
+            os << ps.entries << " states in " << ps.slots << " slots, probe mean " << ps.mean_probe
+               << " max " << ps.max_probe << ", 64-bit hash collisions " << ps.hash_collisions
+               << " (" << (ps.entries ? 100.0*ps.hash_collisions/ps.entries : 0.0) << "%), bucket load 0/1/2/3/4+:";
+            for (size_t i=0;i<ps.bucket_load.size();++i) os << (i ? "/" : " ") << ps.bucket_load[i];
+        }
+        // Bytes held by the table and entries (not the states themselves)
+        size_t memory_bytes() const{
+            return _meta.capacity()*sizeof(Meta) + _slots.capacity()*sizeof(Slot)
+                 + _entries.capacity()*sizeof(value_type) + _hashes.capacity()*sizeof(uint64_t);
+        }
+};
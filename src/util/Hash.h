@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <utility>
+
+// splitmix64 finalizer: every input bit affects every output bit
+inline uint64_t mix64(uint64_t x){
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Order-dependent combine (hash(a, b) != hash(b, a))
+inline uint64_t hash_combine(uint64_t h, uint64_t v){
+    return mix64(h ^ (v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+}
+
+// Word-at-a-time hash of a byte string, seeds give independent functions
+inline uint64_t hash_bytes(const uint8_t* p, size_t n, uint64_t seed = 0){
+    uint64_t h = mix64(seed ^ n);
+    while (n >= 8){
+        uint64_t w;
+        memcpy(&w, p, 8);
+        h = mix64(h ^ w);
+        p += 8;
+        n -= 8;
+    }
+    uint64_t w = 0;
+    memcpy(&w, p, n);
+    return mix64(h ^ w);
+}
+
+// A board cell (x, y) packed into one word and mixed, so (x, y) and (y, x) differ
+inline uint64_t hash_cell(int x, int y){
+    return mix64(((uint64_t)(uint32_t)x << 32) | (uint32_t)y);
+}
+
+// Hash for std::pair keys (integral members are packed as cells)
+struct PairHash{
+    template <class T1, class T2>
+    std::size_t operator() (const std::pair<T1, T2>& p) const{
+        return hash_combine(std::hash<T1>()(p.first), std::hash<T2>()(p.second));
+    }
+    std::size_t operator() (const std::pair<int, int>& p) const{
+        return hash_cell(p.first, p.second);
+    }
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+
+// Quote a string for a JSON document (names, action strings; no unicode escapes needed)
+inline std::string json_escape(const std::string& s){
+    std::string out;
+    for (char ch: s){
+        switch (ch){
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char)ch < 0x20){
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", ch);
+                    out += buf;
+                }
+                else out.push_back(ch);
+        }
+    }
+    return out;
+}
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Hardware performance counters (perf_event_open) split by search phase
+// Each thread that calls start() opens one counter group (cycles, instructions,
+// last-level cache misses, branch misses, plus the task clock), read with a
+// single read() and closed when the thread exits. phase(p) charges everything
+// counted since the previous call to the phase that was running and switches
+// to p, so phases never overlap and their counts add up to the whole solve.
+// Counts from every thread add into the same totals. Events the machine does
+// not count (a VM without a PMU, perf_event_paranoid) are reported as n/a.
+// Agents switch phases through SolveOptions::perf: without it a switch is one
+// null test, with it one read() system call (about a microsecond).
+class PerfCounters{
+    public:
+        enum PHASE{
+            OTHER           = 0,
+            SUCCESSORS      = 1,    // Game::get_successors
+            HEURISTIC       = 2,    // Heuristic scoring
+            LOOKUP          = 3,    // Hashing and visited/closed set lookups
+            OPEN_LIST       = 4,    // Open list (or stack, beam) operations
+            NUM_PHASES      = 5
+        };
+        enum EVENT{
+            CYCLES          = 0,
+            INSTRUCTIONS    = 1,
+            LLC_MISSES      = 2,
+            BRANCH_MISSES   = 3,
+            TASK_CLOCK      = 4,    // ns on the CPU (software event)
+            NUM_EVENTS      = 5
+        };
+    private:
+        // Counter group of one thread
+        struct ThreadGroup{
+            int fd[NUM_EVENTS];     // -1: not counted on this thread
+            int error[NUM_EVENTS];  // errno of perf_event_open
+            int slot[NUM_EVENTS];   // Position in the group's read, -1 if not counted
+            int count;
+            int leader;
+            bool opened;
+            PerfCounters* owner;    // Totals this thread charges, nullptr when stopped
+            int phase;
+            uint64_t last[NUM_EVENTS];
+            ThreadGroup():count(0), leader(-1), opened(false), owner(nullptr), phase(OTHER){
+                for (int e=0;e<NUM_EVENTS;++e){
+                    fd[e] = slot[e] = -1;
+                    error[e] = 0;
+                    last[e] = 0;
+                }
+            }
+            ~ThreadGroup(){
+#ifdef __linux__
+                for (int e=0;e<NUM_EVENTS;++e){
+                    if (fd[e] >= 0) close(fd[e]);
+                }
+#endif
+            }
+        };
+        static ThreadGroup& group(){
+            static thread_local ThreadGroup g;
+            return g;
+        }
+        std::atomic<uint64_t> _counts[NUM_PHASES][NUM_EVENTS];
+        std::atomic<bool> _available[NUM_EVENTS];
+        std::atomic<bool> _multiplexed;
+        std::atomic<bool> _warned;
+
+        static void open(ThreadGroup& g){
+            g.opened = true;
+#ifdef __linux__
+            static const uint32_t types[NUM_EVENTS] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_SOFTWARE};
+            static const uint64_t configs[NUM_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+                                                         PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_SW_TASK_CLOCK};
+            for (int e=0;e<NUM_EVENTS;++e){
+                perf_event_attr attr;
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = types[e];
+                attr.config = configs[e];
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                // This thread, any CPU, first event that opens leads the group
+                int fd = syscall(SYS_perf_event_open, &attr, 0, -1, g.leader, 0);
+                if (fd < 0){
+                    g.error[e] = errno;
+                    continue;
+                }
+                if (g.leader < 0) g.leader = fd;
+                g.fd[e] = fd;
+                g.slot[e] = g.count++;
+            }
+#endif
+        }
+        // @return false if the group cannot be read
+        bool read_group(ThreadGroup& g, uint64_t values[NUM_EVENTS]){
+#ifdef __linux__
+            // nr, time enabled, time running, then one value per event
+            uint64_t buf[3 + NUM_EVENTS];
+            ssize_t want = (3 + g.count)*sizeof(uint64_t);
+            if (g.leader < 0 || ::read(g.leader, buf, want) != want) return false;
+            if (buf[2] < buf[1]) _multiplexed.store(true, std::memory_order_relaxed);
+            for (int e=0;e<NUM_EVENTS;++e) values[e] = g.slot[e] >= 0 ? buf[3 + g.slot[e]] : 0;
+            return true;
+#else
+            return false;
+#endif
+        }
+        // Charge the counts since the last read to the running phase
+        void charge(ThreadGroup& g){
+            uint64_t now[NUM_EVENTS];
+            if (!read_group(g, now)) return;
+            for (int e=0;e<NUM_EVENTS;++e){
+                if (g.slot[e] < 0) continue;
+                _counts[g.phase][e].fetch_add(now[e] - g.last[e], std::memory_order_relaxed);
+                g.last[e] = now[e];
+            }
+        }
+    public:
+        PerfCounters():_multiplexed(false), _warned(false){
+            reset();
+            for (int e=0;e<NUM_EVENTS;++e) _available[e].store(false);
+        }
+        ~PerfCounters(){
+            stop();
+        }
+        // Start charging this thread's counts here, in phase OTHER
+        // @return false if no event can be counted on this thread
+        bool start(){
+            ThreadGroup& g = group();
+            if (!g.opened) open(g);
+            // Say once which events are not counted
+            if (g.count < NUM_EVENTS && !_warned.exchange(true)){
+                std::cerr << "(PerfCounters::start) Error: cannot count";
+                for (int e=0;e<NUM_EVENTS;++e){
+                    if (g.slot[e] < 0) std::cerr << " " << event_name(e) << " (" << strerror(g.error[e]) << ")";
+                }
+                std::cerr << std::endl;
+            }
+            if (g.leader < 0) return false;
+            for (int e=0;e<NUM_EVENTS;++e){
+                if (g.slot[e] >= 0) _available[e].store(true, std::memory_order_relaxed);
+            }
+            g.owner = this;
+            g.phase = OTHER;
+            read_group(g, g.last);
+            return true;
+        }
+        // Charge the running phase and switch to p (no-op on threads not started
+        // or already in p)
+        inline void phase(int p){
+            ThreadGroup& g = group();
+            if (g.owner != this || g.phase == p) return;
+            charge(g);
+            g.phase = p;
+        }
+        // Charge the running phase and stop charging this thread
+        void stop(){
+            ThreadGroup& g = group();
+            if (g.owner != this) return;
+            charge(g);
+            g.owner = nullptr;
+        }
+        // Zero the totals (not while threads are charging)
+        void reset(){
+            for (int p=0;p<NUM_PHASES;++p){
+                for (int e=0;e<NUM_EVENTS;++e) _counts[p][e].store(0, std::memory_order_relaxed);
+            }
+            _multiplexed.store(false);
+        }
+        uint64_t get(int phase, int event) const{
+            return _counts[phase][event].load(std::memory_order_relaxed);
+        }
+        uint64_t total(int event) const{
+            uint64_t t = 0;
+            for (int p=0;p<NUM_PHASES;++p) t += get(p, event);
+            return t;
+        }
+        // Counted on some thread that started
+        bool available(int event) const{
+            return _available[event].load(std::memory_order_relaxed);
+        }
+        // The kernel time-shared the counters, counts cover only part of the run
+        bool multiplexed() const{
+            return _multiplexed.load(std::memory_order_relaxed);
+        }
+        static const char* phase_name(int p){
+            static const char* names[NUM_PHASES] = {"other", "successors", "heuristic", "lookup", "open_list"};
+            return (p >= 0 && p < NUM_PHASES) ? names[p] : "?";
+        }
+        static const char* event_name(int e){
+            static const char* names[NUM_EVENTS] = {"cycles", "instructions", "llc_misses", "branch_misses", "task_clock_ns"};
+            return (e >= 0 && e < NUM_EVENTS) ? names[e] : "?";
+        }
+        // Table of counts per phase, IPC and misses per 1000 instructions (and per expansion if given)
+        void report(std::ostream& os, long long expanded = 0) const{
+            char line[256];
+            snprintf(line, sizeof(line), "%-12s %14s %14s %12s %14s %14s %6s %8s %8s", "phase", "cycles", "instructions", "llc_misses",
+                     "branch_misses", "task_clock_ns", "ipc", "llc/ki", "br/ki");
+            os << line << std::endl;
+            for (int p=0;p<=NUM_PHASES;++p){
+                uint64_t v[NUM_EVENTS];
+                for (int e=0;e<NUM_EVENTS;++e) v[e] = p < NUM_PHASES ? get(p, e) : total(e);
+                std::string cells;
+                for (int e=0;e<NUM_EVENTS;++e){
+                    int width = e == LLC_MISSES ? 12 : 14;
+                    if (available(e)) snprintf(line, sizeof(line), " %*llu", width, (unsigned long long)v[e]);
+                    else snprintf(line, sizeof(line), " %*s", width, "n/a");
+                    cells += line;
+                }
+                bool ki = available(INSTRUCTIONS) && v[INSTRUCTIONS] > 0;
+                auto ratio = [&](bool ok, double x, int width){
+                    if (ok) snprintf(line, sizeof(line), " %*.2f", width, x);
+                    else snprintf(line, sizeof(line), " %*s", width, "n/a");
+                    return std::string(line);
+                };
+                cells += ratio(ki && available(CYCLES) && v[CYCLES] > 0, ki && v[CYCLES] ? (double)v[INSTRUCTIONS]/v[CYCLES] : 0, 6);
+                cells += ratio(ki && available(LLC_MISSES), ki ? 1000.0*v[LLC_MISSES]/v[INSTRUCTIONS] : 0, 8);
+                cells += ratio(ki && available(BRANCH_MISSES), ki ? 1000.0*v[BRANCH_MISSES]/v[INSTRUCTIONS] : 0, 8);
+                snprintf(line, sizeof(line), "%-12s", p < NUM_PHASES ? phase_name(p) : "total");
+                os << line << cells << std::endl;
+            }
+            if (expanded > 0){
+                os << "per expansion:";
+                for (int e=0;e<NUM_EVENTS;++e){
+                    if (available(e)) os << " " << event_name(e) << " " << (double)total(e)/expanded;
+                }
+                os << std::endl;
+            }
+            if (multiplexed()) os << "(counters were multiplexed, counts are partial)" << std::endl;
+        }
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "Json.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Timestamped scoped events for Chrome's trace viewer / Perfetto
+// Off until enable(); a disabled Trace::Scope costs one relaxed load. Each thread
+// records into its own ring buffer (no locks after the first event), which grows
+// to events_per_thread, then overwrites its oldest events and counts them, so
+// short-lived threads cost only what they record. write() turns every
+// thread's ring into one Chrome trace JSON ("X" complete events, microseconds).
+// Rings have a single writer and are read without locks: call write() once the
+// recording threads are idle (joined, or a pool waited on).
+// Event names and categories must outlive the trace (string literals); the
+// optional detail string and number go into the event's args.
+class Trace{
+    public:
+        struct Event{
+            const char* name;
+            const char* cat;
+            uint64_t start_ns, dur_ns;
+            long long value;        // -1: none
+            std::string detail;
+        };
+    private:
+        struct Ring{
+            int tid;
+            std::string thread_name;
+            std::vector<Event> events;  // Grows to capacity, then wraps
+            size_t capacity;
+            size_t next;            // Slot the next event goes to once full
+            uint64_t recorded;
+        };
+        struct Registry{
+            std::atomic<bool> on;
+            size_t capacity;
+            std::chrono::steady_clock::time_point epoch;
+            std::mutex lock;
+            std::vector<std::shared_ptr<Ring>> rings;
+            Registry():on(false), capacity(1 << 16), epoch(std::chrono::steady_clock::now()){}
+        };
+        static Registry& registry(){
+            static Registry r;
+            return r;
+        }
+        // This thread's ring, registered on first use
+        static Ring& ring(){
+            static thread_local std::shared_ptr<Ring> mine;
+            if (!mine){
+                Registry& r = registry();
+                mine = std::make_shared<Ring>();
+                std::lock_guard<std::mutex> guard(r.lock);
+                mine->tid = r.rings.size() + 1;
+                mine->capacity = r.capacity;
+                mine->next = 0;
+                mine->recorded = 0;
+                r.rings.push_back(mine);
+            }
+            return *mine;
+        }
+    public:
+        // Start recording, keeping the newest events_per_thread events of every thread
+        static void enable(size_t events_per_thread = 1 << 16){
+            Registry& r = registry();
+            {
+                std::lock_guard<std::mutex> guard(r.lock);
+                r.capacity = std::max<size_t>(events_per_thread, 1);
+            }
+            r.on.store(true, std::memory_order_relaxed);
+        }
+        static void disable(){
+            registry().on.store(false, std::memory_order_relaxed);
+        }
+        static inline bool enabled(){
+            return registry().on.load(std::memory_order_relaxed);
+        }
+        // ns since the trace epoch
+        static inline uint64_t now(){
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - registry().epoch).count();
+        }
+        // Label of the calling thread in the viewer
+        static void set_thread_name(const std::string& name){
+            if (enabled()) ring().thread_name = name;
+        }
+        // An event from start to now (timestamps from now())
+        static void record(const char* name, const char* cat, uint64_t start, long long value = -1, const std::string& detail = std::string()){
+            if (!enabled()) return;
+            uint64_t end = now();
+            Ring& rg = ring();
+            Event* e;
+            if (rg.events.size() < rg.capacity){
+                rg.events.push_back(Event());
+                e = &rg.events.back();
+            }
+            else{
+                e = &rg.events[rg.next];
+                if (++rg.next == rg.capacity) rg.next = 0;
+            }
+            e->name = name;
+            e->cat = cat;
+            e->start_ns = start;
+            e->dur_ns = end > start ? end - start : 0;
+            e->value = value;
+            e->detail = detail;
+            rg.recorded++;
+        }
+        // Event covering the scope (nothing when tracing is off at construction)
+        class Scope{
+            private:
+                const char* _name;
+                const char* _cat;
+                uint64_t _start;
+                long long _value;
+                std::string _detail;
+            public:
+                Scope(const char* name, const char* cat, long long value = -1):_name(nullptr), _cat(cat), _start(0), _value(value){
+                    if (!Trace::enabled()) return;
+                    _name = name;
+                    _start = Trace::now();
+                }
+                Scope(const char* name, const char* cat, const std::string& detail, long long value = -1):Scope(name, cat, value){
+                    if (_name) _detail = detail;
+                }
+                // Value known only at the end (e.g. nodes expanded)
+                void set_value(long long v){_value = v;}
+                ~Scope(){
+                    if (_name) Trace::record(_name, _cat, _start, _value, _detail);
+                }
+        };
+        // Events recorded so far (newest events_per_thread of each thread) and overwritten ones
+        static void counts(size_t& kept, size_t& dropped){
+            Registry& r = registry();
+            std::lock_guard<std::mutex> guard(r.lock);
+            kept = dropped = 0;
+            for (const std::shared_ptr<Ring>& rg: r.rings){
+                size_t k = std::min<uint64_t>(rg->recorded, rg->events.size());
+                kept += k;
+                dropped += rg->recorded - k;
+            }
+        }
+        // Chrome trace JSON of every thread's events, oldest first
+        // @return 0 on success
+        static int write(const std::string& path){
+            std::ofstream fout(path);
+            if (!fout){
+                std::cerr << "(Trace::write) Error: cannot write <" << path << ">" << std::endl;
+                return 1;
+            }
+            Registry& r = registry();
+            std::lock_guard<std::mutex> guard(r.lock);
+            fout << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << std::endl;
+            bool first = true;
+            uint64_t dropped = 0;
+            char buf[128];
+            for (const std::shared_ptr<Ring>& rg: r.rings){
+                std::string thread_name = rg->thread_name.empty() ? "thread " + std::to_string(rg->tid) : rg->thread_name;
+                fout << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << rg->tid
+                     << ", \"args\": {\"name\": \"" << json_escape(thread_name) << "\"}}";
+                first = false;
+                size_t n = rg->events.size();
+                size_t kept = std::min<uint64_t>(rg->recorded, n);
+                dropped += rg->recorded - kept;
+                // Oldest kept event first
+                size_t at = rg->recorded > n ? rg->next : 0;
+                for (size_t i=0;i<kept;++i){
+                    const Event& e = rg->events[(at + i) % n];
+                    snprintf(buf, sizeof(buf), "\"ts\": %.3f, \"dur\": %.3f", e.start_ns/1000.0, e.dur_ns/1000.0);
+                    fout << ",\n{\"name\": \"" << json_escape(e.name) << "\", \"cat\": \"" << json_escape(e.cat) << "\", \"ph\": \"X\", "
+                         << buf << ", \"pid\": 1, \"tid\": " << rg->tid;
+                    if (e.value >= 0 || !e.detail.empty()){
+                        fout << ", \"args\": {";
+                        if (!e.detail.empty()) fout << "\"detail\": \"" << json_escape(e.detail) << "\"";
+                        if (e.value >= 0) fout << (e.detail.empty() ? "" : ", ") << "\"value\": " << e.value;
+                        fout << "}";
+                    }
+                    fout << "}";
+                }
+            }
+            fout << "\n], \"otherData\": {\"dropped_events\": \"" << dropped << "\"}}" << std::endl;
+            if (!fout){
+                std::cerr << "(Trace::write) Error: short write to <" << path << ">" << std::endl;
+                return 1;
+            }
+            return 0;
+        }
+};
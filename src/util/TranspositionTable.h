@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+// Fixed-size transposition table for game-tree search, shared by threads without locks
+// Each entry is two 64-bit words: the packed data (value, depth, bound, move,
+// generation) and key ^ data. Writers store both words with relaxed atomics, so a
+// reader can see halves of two different writes; such a torn entry no longer
+// XORs back to its key and is read as a miss. Buckets hold two entries: the
+// first keeps the deepest result of the current search, the second always takes
+// the newest one. Entries from earlier searches (new_search) are replaced first.
+class TranspositionTable{
+    public:
+        enum BOUND{
+            NONE    = 0,
+            EXACT   = 1,
+            LOWER   = 2,    // value is a lower bound (fail high)
+            UPPER   = 3     // value is an upper bound (fail low)
+        };
+        struct Entry{
+            int value;
+            int depth;
+            int bound;
+            int move;       // -1: none
+        };
+    private:
+        struct Slot{
+            std::atomic<uint64_t> _check;   // key ^ _data
+            std::atomic<uint64_t> _data;
+        };
+        struct Bucket{
+            Slot _slot[2];
+        };
+        std::unique_ptr<Bucket[]> _buckets;
+        size_t _mask;
+        uint8_t _generation;
+
+        // value: bits 0-31, depth: 32-39, bound: 40-41, move + 1: 42-49, generation: 56-63
+        static inline uint64_t pack(int value, int depth, int bound, int move, uint8_t generation){
+            return (uint64_t)(uint32_t)value | (uint64_t)(depth & 0xff) << 32 | (uint64_t)(bound & 3) << 40
+                   | (uint64_t)((move + 1) & 0xff) << 42 | (uint64_t)generation << 56;
+        }
+        static inline int depth_of(uint64_t d){return (d >> 32) & 0xff;}
+        static inline uint8_t generation_of(uint64_t d){return d >> 56;}
+    public:
+        // Rounded down to a power of 2 of buckets (at least one)
+        TranspositionTable(size_t bytes = 16 << 20):_mask(0), _generation(0){
+            resize(bytes);
+        }
+        // Drop all entries and size the table to about bytes
+        void resize(size_t bytes){
+            size_t n = 1;
+            while (2*n*sizeof(Bucket) <= bytes) n <<= 1;
+            _buckets.reset(new Bucket[n]);
+            _mask = n - 1;
+            clear();
+        }
+        // Not thread-safe
+        void clear(){
+            for (size_t i=0;i<=_mask;++i){
+                for (Slot& s: _buckets[i]._slot){
+                    s._check.store(0, std::memory_order_relaxed);
+                    s._data.store(0, std::memory_order_relaxed);
+                }
+            }
+        }
+        // Age the table: older entries are kept but replaced first (call between searches)
+        void new_search(){
+            _generation++;
+        }
+        size_t bytes() const{
+            return (_mask + 1)*sizeof(Bucket);
+        }
+        // @return false on a miss
+        bool probe(uint64_t key, Entry& e) const{
+            const Bucket& b = _buckets[key & _mask];
+            for (const Slot& s: b._slot){
+                uint64_t d = s._data.load(std::memory_order_relaxed);
+                if ((s._check.load(std::memory_order_relaxed) ^ d) != key) continue;
+                e.bound = (d >> 40) & 3;
+                if (e.bound == NONE) continue;
+                e.value = (int32_t)(uint32_t)d;
+                e.depth = depth_of(d);
+                e.move = (int)((d >> 42) & 0xff) - 1;
+                return true;
+            }
+            return false;
+        }
+        // depth in [0, 255], move in [-1, 254]
+        void store(uint64_t key, int value, int depth, int bound, int move){
+            Bucket& b = _buckets[key & _mask];
+            uint64_t d = pack(value, depth, bound, move, _generation);
+            Slot& deep = b._slot[0];
+            uint64_t old = deep._data.load(std::memory_order_relaxed);
+            bool same = (deep._check.load(std::memory_order_relaxed) ^ old) == key;
+            Slot& s = (same || generation_of(old) != _generation || depth >= depth_of(old)) ? deep : b._slot[1];
+            s._data.store(d, std::memory_order_relaxed);
+            s._check.store(key ^ d, std::memory_order_relaxed);
+        }
+};
@@ -0,0 +1,108 @@
+#include "WorkStealingPool.h"
+#include "Trace.h"
+
+// Which pool (and slot) the current thread works for
+static thread_local const WorkStealingPool* tl_pool = nullptr;
+static thread_local int tl_index = -1;
+
+WorkStealingPool::WorkStealingPool(int num_threads):_queued(0),_pending(0),_stop(false),_next(0),_steals(0){
+    if (num_threads <= 0) num_threads = std::thread::hardware_concurrency();
+    if (num_threads <= 0) num_threads = 1;
+    for (int i=0;i<num_threads;++i){
+        _queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+    }
+    for (int i=0;i<num_threads;++i){
+        _threads.push_back(std::thread(&WorkStealingPool::run, this, i));
+    }
+}
+
+WorkStealingPool::~WorkStealingPool(){
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stop = true;
+    }
+    _wake.notify_all();
+    for (std::thread& t: _threads) t.join();
+}
+
+int WorkStealingPool::size() const{
+    return _threads.size();
+}
+
+int WorkStealingPool::worker_index(){
+    return tl_index;
+}
+
+long long WorkStealingPool::steals() const{
+    return _steals.load();
+}
+
+void WorkStealingPool::submit(task_type task){
+    int id = (tl_pool == this) ? tl_index : (int)(_next++ % _queues.size());
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        ++_pending;
+    }
+    {
+        std::lock_guard<std::mutex> guard(_queues[id]->lock);
+        _queues[id]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        ++_queued;
+    }
+    _wake.notify_one();
+}
+
+void WorkStealingPool::wait(){
+    std::unique_lock<std::mutex> guard(_lock);
+    _idle.wait(guard, [this]{ return _pending == 0; });
+}
+
+bool WorkStealingPool::pop(int id, task_type& task){
+    // Own deque first (LIFO)
+    {
+        std::lock_guard<std::mutex> guard(_queues[id]->lock);
+        if (!_queues[id]->tasks.empty()){
+            task = std::move(_queues[id]->tasks.back());
+            _queues[id]->tasks.pop_back();
+            return true;
+        }
+    }
+    // Steal the oldest task of the next non-empty victim
+    for (size_t k=1;k<_queues.size();++k){
+        WorkerQueue& victim = *_queues[(id + k) % _queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if (!victim.tasks.empty()){
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            ++_steals;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(int id){
+    tl_pool = this;
+    tl_index = id;
+    Trace::set_thread_name("pool worker " + std::to_string(id));
+    while (true){
+        task_type task;
+        if (pop(id, task)){
+            {
+                std::lock_guard<std::mutex> guard(_lock);
+                --_queued;
+            }
+            task();
+            std::lock_guard<std::mutex> guard(_lock);
+            if (--_pending == 0) _idle.notify_all();
+            continue;
+        }
+        // Nothing to take, sleep until something is queued
+        std::unique_lock<std::mutex> guard(_lock);
+        _wake.wait(guard, [this]{ return _stop || _queued > 0; });
+        if (_stop && _queued == 0) return;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size thread pool with one task deque per worker
+// A worker pops its own deque from the back (most recently pushed, cache warm)
+// and, when empty, steals from the front of the other workers' deques, so
+// long-running tasks (hard levels) don't hold up the queue behind them.
+// Tasks submitted from outside the pool are dealt round-robin; tasks submitted
+// from inside a task go onto the calling worker's own deque.
+class WorkStealingPool{
+    public:
+        typedef std::function<void()> task_type;
+        // num_threads <= 0 uses std::thread::hardware_concurrency()
+        explicit WorkStealingPool(int num_threads=0);
+        // Finishes queued tasks then joins the workers
+        ~WorkStealingPool();
+        void submit(task_type task);
+        // Block until every task submitted so far has finished
+        void wait();
+        int size() const;
+        // Index of the calling worker in its pool, -1 outside any pool
+        static int worker_index();
+        // Tasks taken from another worker's deque (since construction)
+        long long steals() const;
+    private:
+        struct WorkerQueue{
+            std::mutex lock;
+            std::deque<task_type> tasks;
+        };
+        std::vector<std::unique_ptr<WorkerQueue>> _queues;
+        std::vector<std::thread> _threads;
+        // Guards _queued, _pending and _stop
+        std::mutex _lock;
+        std::condition_variable _wake;
+        std::condition_variable _idle;
+        size_t _queued;     // Sitting in a deque
+        size_t _pending;    // Queued or running
+        bool _stop;
+        std::atomic<size_t> _next;
+        std::atomic<long long> _steals;
+        void run(int id);
+        bool pop(int id, task_type& task);
+        // Non-copyable (owns threads)
+        WorkStealingPool(const WorkStealingPool&);
+        WorkStealingPool& operator=(const WorkStealingPool&);
+};
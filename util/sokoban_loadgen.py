@@ -0,0 +1,142 @@
+# Load generator for sokoban_server
+#
+# Sends levels to a running server (-u socket) or to one it spawns on
+# stdin/stdout (--spawn), keeping up to -c requests in flight on one
+# connection, and reports requests/sec and latency percentiles.
+#
+#   python3 util/sokoban_loadgen.py --spawn "bin/sokoban_server -j 4" -n 500 -c 8 sokoban_61kids
+#   python3 util/sokoban_loadgen.py -u /tmp/sokoban.sock -n 500 -c 8 sokoban_61kids/Dimitri-Yorick_1.in
+
+import argparse
+import json
+import os
+import shlex
+import socket
+import struct
+import subprocess
+import sys
+import threading
+import time
+
+
+# Framing shared with sokoban_server: 4-byte little-endian length + payload
+def send_frame(out, payload):
+    out.write(struct.pack('<I', len(payload)) + payload)
+    out.flush()
+
+
+def read_exact(inp, n):
+    buf = b''
+    while len(buf) < n:
+        chunk = inp.read(n - len(buf))
+        if not chunk:
+            return None
+        buf += chunk
+    return buf
+
+
+def read_frame(inp):
+    header = read_exact(inp, 4)
+    if header is None:
+        return None
+    (n,) = struct.unpack('<I', header)
+    return read_exact(inp, n)
+
+
+# Level files (.in) given directly or inside directories
+def collect_levels(paths):
+    files = []
+    for p in paths:
+        if os.path.isdir(p):
+            files += sorted(os.path.join(p, f) for f in os.listdir(p) if f.endswith('.in'))
+        else:
+            files.append(p)
+    levels = []
+    for f in files:
+        with open(f) as fin:
+            levels.append(fin.read())
+    return levels
+
+
+def percentile(sorted_vals, q):
+    if not sorted_vals:
+        return 0.0
+    idx = min(len(sorted_vals) - 1, int(round(q * (len(sorted_vals) - 1))))
+    return sorted_vals[idx]
+
+
+def main():
+    parser = argparse.ArgumentParser(description='sokoban_server load generator')
+    parser.add_argument('levels', nargs='+', help='.in files or directories of them')
+    parser.add_argument('-u', '--socket', help='unix socket of a running server')
+    parser.add_argument('--spawn', default='bin/sokoban_server', help='server command to run on stdin/stdout')
+    parser.add_argument('-n', '--requests', type=int, default=200)
+    parser.add_argument('-c', '--concurrency', type=int, default=4, help='requests in flight')
+    parser.add_argument('-w', '--weight', type=float, default=1.0)
+    parser.add_argument('-T', '--time-limit', type=float, default=10000.0, help='ms per request')
+    args = parser.parse_args()
+
+    levels = collect_levels(args.levels)
+    if not levels:
+        print('no levels found', file=sys.stderr)
+        return 1
+
+    proc = None
+    if args.socket:
+        sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        sock.connect(args.socket)
+        out = sock.makefile('wb')
+        inp = sock.makefile('rb')
+    else:
+        proc = subprocess.Popen(shlex.split(args.spawn), stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        out = proc.stdin
+        inp = proc.stdout
+
+    in_flight = threading.Semaphore(args.concurrency)
+    sent_at = {}
+    latencies = []
+    statuses = {}
+    cached = [0]
+    lock = threading.Lock()
+
+    def reader():
+        for _ in range(args.requests):
+            payload = read_frame(inp)
+            if payload is None:
+                break
+            now = time.perf_counter()
+            resp = json.loads(payload.decode())
+            with lock:
+                latencies.append((now - sent_at.pop(resp['id'])) * 1000.0)
+                statuses[resp['status']] = statuses.get(resp['status'], 0) + 1
+                cached[0] += 1 if resp.get('cached') else 0
+            in_flight.release()
+
+    t = threading.Thread(target=reader)
+    t.start()
+    start = time.perf_counter()
+    for i in range(args.requests):
+        in_flight.acquire()
+        payload = '{} {} {}\n{}'.format(i, args.weight, args.time_limit, levels[i % len(levels)]).encode()
+        with lock:
+            sent_at[str(i)] = time.perf_counter()
+        send_frame(out, payload)
+    t.join()
+    elapsed = time.perf_counter() - start
+
+    if proc is not None:
+        proc.stdin.close()
+        proc.wait()
+
+    lat = sorted(latencies)
+    print('requests:    {} ({} levels, concurrency {})'.format(len(lat), len(levels), args.concurrency))
+    print('statuses:    {}'.format(', '.join('{}={}'.format(k, v) for k, v in sorted(statuses.items()))))
+    print('cache hits:  {}'.format(cached[0]))
+    print('throughput:  {:.1f} req/s'.format(len(lat) / elapsed if elapsed > 0 else 0.0))
+    print('latency ms:  p50 {:.2f}  p90 {:.2f}  p99 {:.2f}  max {:.2f}'.format(
+        percentile(lat, 0.50), percentile(lat, 0.90), percentile(lat, 0.99), lat[-1] if lat else 0.0))
+    return 0 if len(lat) == args.requests else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())